@@ -472,7 +472,7 @@
  * The default value defined in CMake build scripts is
  * <c>AVS_COAP_FORMAT_NONE</c>.
  */
-#define ANJAY_DEFAULT_SEND_FORMAT AVS_COAP_FORMAT_NONE
+#define ANJAY_DEFAULT_SEND_FORMAT AVS_COAP_FORMAT_SENML_CBOR
 
 /**
  * Optional Anjay modules.
@@ -0,0 +1,55 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "change_filter.h"
+
+void change_filter_init(change_filter_t *filter,
+                        const change_filter_config_t *config) {
+    assert(filter);
+    assert(config);
+    filter->config = config;
+    change_filter_reset(filter);
+}
+
+void change_filter_reset(change_filter_t *filter) {
+    assert(filter);
+    filter->has_reported = false;
+    filter->reported_value = 0;
+    filter->reported_time = AVS_TIME_MONOTONIC_INVALID;
+}
+
+static bool is_significant(const change_filter_t *filter, int32_t value) {
+    if (!filter->has_reported) {
+        return true;
+    }
+
+    // in 64 bits, as the difference and the threshold may overflow 32 bits
+    const int64_t diff = llabs((int64_t) value - filter->reported_value);
+    const int64_t rel_threshold =
+            (int64_t) filter->config->rel_deadband_permille
+            * llabs(filter->reported_value);
+    return diff > 0 && diff >= filter->config->abs_deadband
+           && diff * 1000 >= rel_threshold;
+}
+
+bool change_filter_update(change_filter_t *filter, int32_t value) {
+    assert(filter);
+    assert(filter->config);
+
+    if (!is_significant(filter, value)) {
+        return false;
+    }
+
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    if (filter->has_reported
+            && avs_time_duration_less(
+                       avs_time_monotonic_diff(now, filter->reported_time),
+                       filter->config->min_interval)) {
+        return false;
+    }
+
+    filter->has_reported = true;
+    filter->reported_value = value;
+    filter->reported_time = now;
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef _CHANGE_FILTER_H_
+#define _CHANGE_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <avsystem/commons/avs_time.h>
+
+/*
+ * Significant-change filter deciding whether a new value of a resource is
+ * worth an anjay_notify_changed() call.
+ *
+ * A value is significant if it differs from the last reported one by at least
+ * abs_deadband and by at least rel_deadband_permille thousandths of the last
+ * reported value, and the last report happened at least min_interval ago.
+ * Values are compared against the last reported value, so slow drift is
+ * reported as soon as it accumulates over the deadband. Zero disables the
+ * respective condition.
+ *
+ * Values are integers in units chosen by the user of the filter, e.g.
+ * sensor_value_t thousandths, so that filtering needs no floating point.
+ */
+typedef struct change_filter_config_struct {
+    int32_t abs_deadband;
+    uint16_t rel_deadband_permille;
+    avs_time_duration_t min_interval;
+} change_filter_config_t;
+
+typedef struct change_filter_struct {
+    const change_filter_config_t *config;
+    bool has_reported;
+    int32_t reported_value;
+    avs_time_monotonic_t reported_time;
+} change_filter_t;
+
+void change_filter_init(change_filter_t *filter,
+                        const change_filter_config_t *config);
+
+/**
+ * Forgets the last reported value, so that the next value is significant.
+ */
+void change_filter_reset(change_filter_t *filter);
+
+/**
+ * Returns true if @p value is significant; in that case it becomes the last
+ * reported value.
+ */
+bool change_filter_update(change_filter_t *filter, int32_t value);
+
+#endif // _CHANGE_FILTER_H_
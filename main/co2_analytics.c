@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+#include "co2_analytics.h"
+
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+
+#    define RATE_FRACTION_BITS 4
+
+// lower limits of the bands above CO2_ANALYTICS_BAND_GOOD, in ppm
+static const uint16_t BAND_THRESHOLDS[CO2_ANALYTICS_BAND_COUNT - 1] = {
+    800, 1000, 1400, 2000
+};
+
+static co2_analytics_band_t band_of(uint32_t value) {
+    co2_analytics_band_t band = CO2_ANALYTICS_BAND_GOOD;
+    while (band < CO2_ANALYTICS_BAND_COUNT - 1
+           && value >= BAND_THRESHOLDS[band]) {
+        band++;
+    }
+    return band;
+}
+
+static co2_analytics_band_t update_band(co2_analytics_band_t band,
+                                        uint16_t value) {
+    const co2_analytics_band_t raw = band_of(value);
+    if (raw >= band) {
+        return raw;
+    }
+    // move down only as far as the hysteresis margin allows
+    return band_of((uint32_t) value + CO2_ANALYTICS_BAND_HYSTERESIS);
+}
+
+static int32_t update_rate(int32_t rate_q4, int32_t delta, uint16_t period) {
+    const int64_t rate = (int64_t) delta * 3600 * (1 << RATE_FRACTION_BITS)
+                         / period;
+    return (int32_t) (rate_q4
+                      + (rate - rate_q4) * period
+                                / (period + CO2_ANALYTICS_RATE_TIME_CONSTANT));
+}
+
+static uint16_t estimate_occupancy(uint16_t value, int32_t rate_q4) {
+    // V * (ACH * (C - C_outdoor) + dC/dt) / G, with ACH in 0.1/h, rate in
+    // 1/16 ppm/h and 1e6 ppm * 1e-3 m^3/l folded into the denominator
+    const int64_t excess =
+            (int64_t) value - CONFIG_ANJAY_CLIENT_CO2_OUTDOOR_LEVEL;
+    const int64_t num =
+            (int64_t) CONFIG_ANJAY_CLIENT_CO2_ROOM_VOLUME
+            * (CONFIG_ANJAY_CLIENT_CO2_AIR_CHANGES * excess
+                       * (1 << RATE_FRACTION_BITS)
+               + 10 * (int64_t) rate_q4);
+    const int64_t den = 10 * (1 << RATE_FRACTION_BITS) * 1000
+                        * (int64_t) CO2_ANALYTICS_GENERATION_RATE;
+    if (num <= 0) {
+        return 0;
+    }
+    const int64_t occupancy = (num + den / 2) / den;
+    return occupancy > UINT16_MAX ? UINT16_MAX : (uint16_t) occupancy;
+}
+
+void co2_analytics_init(co2_analytics_t *analytics) {
+    assert(analytics);
+    *analytics = (co2_analytics_t) {
+        .band = CO2_ANALYTICS_BAND_GOOD
+    };
+}
+
+int co2_analytics_update(co2_analytics_t *analytics,
+                         uint16_t value,
+                         uint16_t period) {
+    assert(analytics);
+    int changed = 0;
+
+    // the band of the first sample is where the stream starts, not a
+    // transition, e.g. after a reboot in a room already above 800 ppm
+    const co2_analytics_band_t band =
+            analytics->has_last_value ? update_band(analytics->band, value)
+                                      : band_of(value);
+    if (!analytics->has_last_value) {
+        analytics->band = band;
+    } else if (band != analytics->band) {
+        analytics->band = band;
+        changed |= CO2_ANALYTICS_BAND_CHANGED;
+    }
+
+    if (analytics->has_last_value && period) {
+        analytics->rate_q4 =
+                update_rate(analytics->rate_q4,
+                            (int32_t) value - analytics->last_value, period);
+    }
+    analytics->has_last_value = true;
+    analytics->last_value = value;
+
+    const int32_t rate = co2_analytics_get_rate(analytics);
+    const bool rising =
+            analytics->rising
+                    ? rate >= CONFIG_ANJAY_CLIENT_CO2_RISE_ALERT_RATE / 2
+                    : rate >= CONFIG_ANJAY_CLIENT_CO2_RISE_ALERT_RATE;
+    if (rising != analytics->rising) {
+        analytics->rising = rising;
+        changed |= CO2_ANALYTICS_RISING_CHANGED;
+    }
+
+    const uint16_t occupancy = estimate_occupancy(value, analytics->rate_q4);
+    if (occupancy != analytics->occupancy) {
+        analytics->occupancy = occupancy;
+        changed |= CO2_ANALYTICS_OCCUPANCY_CHANGED;
+    }
+    return changed;
+}
+
+int32_t co2_analytics_get_rate(const co2_analytics_t *analytics) {
+    assert(analytics);
+    return analytics->rate_q4 / (1 << RATE_FRACTION_BITS);
+}
+
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
@@ -0,0 +1,66 @@
+#ifndef _CO2_ANALYTICS_H_
+#define _CO2_ANALYTICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Edge analytics on the filtered CO2 stream, in integer arithmetic and
+ * constant time per sample.
+ *
+ * - Band: indoor air quality class of the CO2 level. Leaving a band towards a
+ *   better one requires CO2_ANALYTICS_BAND_HYSTERESIS ppm of margin, so that
+ *   noise around a threshold does not cause a storm of transitions. The
+ *   first sample sets the band without reporting a transition.
+ * - Rate: exponentially smoothed rate of change, weighted by the measurement
+ *   period of every sample. CO2 is considered rising while the rate stays
+ *   above CONFIG_ANJAY_CLIENT_CO2_RISE_ALERT_RATE (cleared below half of it).
+ * - Occupancy: number of people estimated from the CO2 mass balance of a
+ *   room of CONFIG_ANJAY_CLIENT_CO2_ROOM_VOLUME ventilated with
+ *   CONFIG_ANJAY_CLIENT_CO2_AIR_CHANGES:
+ *   N = V * (ACH * (C - C_outdoor) + dC/dt) / G
+ */
+#define CO2_ANALYTICS_BAND_HYSTERESIS 50     // in ppm
+#define CO2_ANALYTICS_RATE_TIME_CONSTANT 300 // in seconds
+// CO2 generated by a sedentary adult, in l/h
+#define CO2_ANALYTICS_GENERATION_RATE 18
+
+typedef enum {
+    CO2_ANALYTICS_BAND_GOOD,     // below 800 ppm
+    CO2_ANALYTICS_BAND_FAIR,     // below 1000 ppm
+    CO2_ANALYTICS_BAND_MODERATE, // below 1400 ppm
+    CO2_ANALYTICS_BAND_POOR,     // below 2000 ppm
+    CO2_ANALYTICS_BAND_BAD,
+    CO2_ANALYTICS_BAND_COUNT
+} co2_analytics_band_t;
+
+// flags returned by co2_analytics_update()
+#define CO2_ANALYTICS_BAND_CHANGED (1 << 0)
+#define CO2_ANALYTICS_RISING_CHANGED (1 << 1)
+#define CO2_ANALYTICS_OCCUPANCY_CHANGED (1 << 2)
+
+typedef struct co2_analytics_struct {
+    co2_analytics_band_t band;
+    int32_t rate_q4; // smoothed rate of change, in 1/16 ppm/h
+    uint16_t occupancy;
+    bool rising;
+    bool has_last_value;
+    uint16_t last_value; // in ppm
+} co2_analytics_t;
+
+void co2_analytics_init(co2_analytics_t *analytics);
+
+/**
+ * Feeds a sample standing for @p period seconds and returns a combination of
+ * CO2_ANALYTICS_*_CHANGED flags.
+ */
+int co2_analytics_update(co2_analytics_t *analytics,
+                         uint16_t value,
+                         uint16_t period);
+
+/**
+ * Returns the smoothed rate of change in ppm/h.
+ */
+int32_t co2_analytics_get_rate(const co2_analytics_t *analytics);
+
+#endif // _CO2_ANALYTICS_H_
@@ -0,0 +1,516 @@
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#include <avsystem/commons/avs_defs.h>
+
+#include "co2_log.h"
+
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+
+#    define SECTOR_SIZE SPI_FLASH_SEC_SIZE
+#    define SECTOR_MAGIC 0x474C4F43UL // "COLG"
+#    define SECTOR_HEADER_SIZE 8U     // magic + sequence number
+#    define ERASED_BYTE 0xFF
+
+/*
+ * Every record starts with a header byte telling which fields changed since
+ * the previous record; a zigzag varint follows for each of them. Bits outside
+ * FIELD_MASK are never set, so a header can't be mistaken for erased flash.
+ */
+#    define FIELD_INTERVAL (1 << 0)
+#    define FIELD_CO2 (1 << 1)
+#    define FIELD_TEMPERATURE (1 << 2)
+#    define FIELD_HUMIDITY (1 << 3)
+#    define FIELD_MASK 0x0F
+
+#    define MAX_VARINT_SIZE 10U
+#    define MAX_RECORD_SIZE (1U + 4U * MAX_VARINT_SIZE)
+#    define READ_CHUNK_SIZE 64U
+// amount of pending data programmed at once, one flash page
+#    define FLUSH_THRESHOLD 256U
+
+static const char *TAG = "co2_log";
+
+typedef struct {
+    int64_t timestamp;
+    int64_t interval;
+    int32_t co2;
+    int32_t temperature;
+    int32_t humidity;
+} delta_state_t;
+
+typedef struct {
+    // RAM copy of the sector, NULL if the sector has to be read from flash
+    const uint8_t *ram;
+    size_t sector_offset;
+    size_t pos;
+    size_t chunk_start;
+    size_t chunk_len;
+    uint8_t chunk[READ_CHUNK_SIZE];
+} sector_reader_t;
+
+typedef struct {
+    sector_reader_t reader;
+    int64_t start; // timestamp of the first record
+} query_sector_t;
+
+static struct {
+    const esp_partition_t *partition;
+    pthread_mutex_t mutex;
+    size_t sector_count;
+    size_t active_sector;
+    uint32_t active_seq;
+    // RAM copy of the active sector
+    uint8_t buffer[SECTOR_SIZE];
+    size_t used;
+    size_t flushed;
+    bool erased;
+    delta_state_t state;
+} log_state = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static inline uint64_t zigzag_encode(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static size_t varint_encode(int64_t value, uint8_t *out) {
+    uint64_t raw = zigzag_encode(value);
+    size_t len = 0;
+    do {
+        out[len] = (uint8_t) (raw & 0x7F);
+        raw >>= 7;
+        if (raw) {
+            out[len] |= 0x80;
+        }
+        len++;
+    } while (raw);
+    return len;
+}
+
+static int reader_get(sector_reader_t *reader, uint8_t *out) {
+    if (reader->pos >= SECTOR_SIZE) {
+        return -1;
+    }
+    if (reader->ram) {
+        *out = reader->ram[reader->pos++];
+        return 0;
+    }
+    if (reader->pos < reader->chunk_start
+            || reader->pos >= reader->chunk_start + reader->chunk_len) {
+        reader->chunk_start = reader->pos;
+        reader->chunk_len = AVS_MIN(sizeof(reader->chunk),
+                                    SECTOR_SIZE - reader->chunk_start);
+        if (esp_partition_read(log_state.partition,
+                               reader->sector_offset + reader->chunk_start,
+                               reader->chunk, reader->chunk_len)) {
+            reader->chunk_len = 0;
+            return -1;
+        }
+    }
+    *out = reader->chunk[reader->pos++ - reader->chunk_start];
+    return 0;
+}
+
+static int varint_decode(sector_reader_t *reader, int64_t *out) {
+    uint64_t raw = 0;
+    for (size_t i = 0; i < MAX_VARINT_SIZE; i++) {
+        uint8_t byte;
+        if (reader_get(reader, &byte)) {
+            return -1;
+        }
+        raw |= (uint64_t) (byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            *out = zigzag_decode(raw);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static size_t encode_record(delta_state_t *state,
+                            const co2_log_record_t *record,
+                            uint8_t *out) {
+    const int64_t interval = record->timestamp - state->timestamp;
+    uint8_t fields = 0;
+    size_t len = 1;
+
+    if (interval != state->interval) {
+        fields |= FIELD_INTERVAL;
+        len += varint_encode(interval, &out[len]);
+    }
+    if (record->co2 != state->co2) {
+        fields |= FIELD_CO2;
+        len += varint_encode((int64_t) record->co2 - state->co2, &out[len]);
+    }
+    if (record->temperature != state->temperature) {
+        fields |= FIELD_TEMPERATURE;
+        len += varint_encode((int64_t) record->temperature
+                                     - state->temperature,
+                             &out[len]);
+    }
+    if (record->humidity != state->humidity) {
+        fields |= FIELD_HUMIDITY;
+        len += varint_encode((int64_t) record->humidity - state->humidity,
+                             &out[len]);
+    }
+    out[0] = fields;
+
+    state->timestamp = record->timestamp;
+    state->interval = interval;
+    state->co2 = record->co2;
+    state->temperature = record->temperature;
+    state->humidity = record->humidity;
+    return len;
+}
+
+/**
+ * Returns 0 if a record has been decoded, 1 at the end of sector data and -1
+ * if the data is corrupted (e.g. a record interrupted by a power loss).
+ */
+static int decode_record(sector_reader_t *reader,
+                         delta_state_t *state,
+                         co2_log_record_t *out_record) {
+    uint8_t fields;
+    if (reader->pos >= SECTOR_SIZE) {
+        return 1;
+    }
+    if (reader_get(reader, &fields)) {
+        return -1;
+    }
+    if (fields == ERASED_BYTE) {
+        reader->pos--;
+        return 1;
+    }
+    if (fields & ~FIELD_MASK) {
+        return -1;
+    }
+
+    int64_t delta;
+    if (fields & FIELD_INTERVAL) {
+        if (varint_decode(reader, &state->interval)) {
+            return -1;
+        }
+    }
+    if (fields & FIELD_CO2) {
+        if (varint_decode(reader, &delta)) {
+            return -1;
+        }
+        state->co2 += (int32_t) delta;
+    }
+    if (fields & FIELD_TEMPERATURE) {
+        if (varint_decode(reader, &delta)) {
+            return -1;
+        }
+        state->temperature += (int32_t) delta;
+    }
+    if (fields & FIELD_HUMIDITY) {
+        if (varint_decode(reader, &delta)) {
+            return -1;
+        }
+        state->humidity += (int32_t) delta;
+    }
+    state->timestamp += state->interval;
+
+    out_record->timestamp = state->timestamp;
+    out_record->co2 = (uint16_t) state->co2;
+    out_record->temperature = (int16_t) state->temperature;
+    out_record->humidity = (uint16_t) state->humidity;
+    return 0;
+}
+
+static int read_sector_seq(size_t sector, uint32_t *out_seq) {
+    uint8_t header[SECTOR_HEADER_SIZE];
+    if (esp_partition_read(log_state.partition, sector * SECTOR_SIZE, header,
+                           sizeof(header))) {
+        return -1;
+    }
+    const uint32_t magic = (uint32_t) header[0] | (uint32_t) header[1] << 8
+                           | (uint32_t) header[2] << 16
+                           | (uint32_t) header[3] << 24;
+    if (magic != SECTOR_MAGIC) {
+        return -1;
+    }
+    *out_seq = (uint32_t) header[4] | (uint32_t) header[5] << 8
+               | (uint32_t) header[6] << 16 | (uint32_t) header[7] << 24;
+    return 0;
+}
+
+static void start_sector(size_t sector, uint32_t seq) {
+    log_state.active_sector = sector;
+    log_state.active_seq = seq;
+    memset(log_state.buffer, ERASED_BYTE, sizeof(log_state.buffer));
+    for (int i = 0; i < 4; i++) {
+        log_state.buffer[i] = (uint8_t) (SECTOR_MAGIC >> (8 * i));
+        log_state.buffer[4 + i] = (uint8_t) (seq >> (8 * i));
+    }
+    log_state.used = SECTOR_HEADER_SIZE;
+    log_state.flushed = 0;
+    log_state.erased = false;
+    memset(&log_state.state, 0, sizeof(log_state.state));
+}
+
+static int flush_unlocked(void) {
+    if (log_state.flushed == log_state.used) {
+        return 0;
+    }
+    const size_t sector_offset = log_state.active_sector * SECTOR_SIZE;
+    if (!log_state.erased) {
+        if (esp_partition_erase_range(log_state.partition, sector_offset,
+                                      SECTOR_SIZE)) {
+            ESP_LOGW(TAG, "Erasing sector %u failed",
+                     (unsigned) log_state.active_sector);
+            return -1;
+        }
+        log_state.erased = true;
+    }
+    if (esp_partition_write(log_state.partition,
+                            sector_offset + log_state.flushed,
+                            &log_state.buffer[log_state.flushed],
+                            log_state.used - log_state.flushed)) {
+        ESP_LOGW(TAG, "Writing sector %u failed",
+                 (unsigned) log_state.active_sector);
+        return -1;
+    }
+    log_state.flushed = log_state.used;
+    return 0;
+}
+
+int co2_log_init(void) {
+    pthread_mutex_lock(&log_state.mutex);
+    log_state.partition = esp_partition_find_first(
+            (esp_partition_type_t) CO2_LOG_PARTITION_TYPE,
+            CO2_LOG_PARTITION_SUBTYPE, CO2_LOG_PARTITION_LABEL);
+    if (!log_state.partition
+            || log_state.partition->size < 2 * SECTOR_SIZE) {
+        ESP_LOGW(TAG, "No usable " CO2_LOG_PARTITION_LABEL " partition");
+        log_state.partition = NULL;
+        pthread_mutex_unlock(&log_state.mutex);
+        return -1;
+    }
+    log_state.sector_count = log_state.partition->size / SECTOR_SIZE;
+
+    // the newest sector is the one with the highest sequence number
+    bool found = false;
+    size_t newest = 0;
+    uint32_t newest_seq = 0;
+    for (size_t sector = 0; sector < log_state.sector_count; sector++) {
+        uint32_t seq;
+        if (!read_sector_seq(sector, &seq) && (!found || seq > newest_seq)) {
+            found = true;
+            newest = sector;
+            newest_seq = seq;
+        }
+    }
+
+    if (!found) {
+        start_sector(0, 0);
+    } else if (esp_partition_read(log_state.partition, newest * SECTOR_SIZE,
+                                  log_state.buffer, SECTOR_SIZE)) {
+        start_sector((newest + 1) % log_state.sector_count, newest_seq + 1);
+    } else {
+        // continue appending right after the last intact record
+        sector_reader_t reader = {
+            .ram = log_state.buffer,
+            .pos = SECTOR_HEADER_SIZE
+        };
+        delta_state_t state = { 0 };
+        co2_log_record_t record;
+        int result;
+        while (!(result = decode_record(&reader, &state, &record))) {
+        }
+        log_state.active_sector = newest;
+        log_state.active_seq = newest_seq;
+        if (result < 0) {
+            // data after a broken record can't be safely programmed over
+            start_sector((newest + 1) % log_state.sector_count,
+                         newest_seq + 1);
+        } else {
+            log_state.used = reader.pos;
+            log_state.flushed = reader.pos;
+            log_state.erased = true;
+            log_state.state = state;
+        }
+    }
+    ESP_LOGI(TAG, "Appending to sector %u of %u",
+             (unsigned) log_state.active_sector,
+             (unsigned) log_state.sector_count);
+    pthread_mutex_unlock(&log_state.mutex);
+    return 0;
+}
+
+int co2_log_append(const co2_log_record_t *record) {
+    assert(record);
+
+    int result = 0;
+    pthread_mutex_lock(&log_state.mutex);
+    if (!log_state.partition) {
+        pthread_mutex_unlock(&log_state.mutex);
+        return -1;
+    }
+
+    uint8_t encoded[MAX_RECORD_SIZE];
+    delta_state_t state = log_state.state;
+    size_t len = encode_record(&state, record, encoded);
+
+    if (log_state.used + len > SECTOR_SIZE) {
+        // sector is full - write it out as a whole and move to the next one
+        result = flush_unlocked();
+        start_sector((log_state.active_sector + 1) % log_state.sector_count,
+                     log_state.active_seq + 1);
+        state = log_state.state;
+        len = encode_record(&state, record, encoded);
+    }
+    memcpy(&log_state.buffer[log_state.used], encoded, len);
+    log_state.used += len;
+    log_state.state = state;
+    if (!result && log_state.used - log_state.flushed >= FLUSH_THRESHOLD) {
+        result = flush_unlocked();
+    }
+    pthread_mutex_unlock(&log_state.mutex);
+    return result;
+}
+
+int co2_log_flush(void) {
+    pthread_mutex_lock(&log_state.mutex);
+    int result = log_state.partition ? flush_unlocked() : -1;
+    pthread_mutex_unlock(&log_state.mutex);
+    return result;
+}
+
+/**
+ * Prepares reading of @p sector and decodes the timestamp of its first
+ * record. Returns false if the sector holds no records of the current pass.
+ */
+static bool open_sector(size_t sector, query_sector_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->reader.sector_offset = sector * SECTOR_SIZE;
+    out->reader.pos = SECTOR_HEADER_SIZE;
+    if (sector == log_state.active_sector) {
+        out->reader.ram = log_state.buffer;
+    } else {
+        uint32_t seq;
+        if (read_sector_seq(sector, &seq) || seq >= log_state.active_seq) {
+            return false;
+        }
+    }
+
+    delta_state_t state = { 0 };
+    co2_log_record_t record;
+    if (decode_record(&out->reader, &state, &record)) {
+        return false;
+    }
+    out->start = record.timestamp;
+    // the chunk read so far stays cached
+    out->reader.pos = SECTOR_HEADER_SIZE;
+    return true;
+}
+
+/**
+ * Returns true if the first records of the sectors do not go back in time,
+ * from the oldest sector to the active one.
+ */
+static bool sectors_ordered(void) {
+    bool has_previous = false;
+    int64_t previous_start = 0;
+    for (size_t i = 1; i <= log_state.sector_count; i++) {
+        query_sector_t sector;
+        if (!open_sector((log_state.active_sector + i)
+                                 % log_state.sector_count,
+                         &sector)) {
+            continue;
+        }
+        if (has_previous && sector.start < previous_start) {
+            return false;
+        }
+        has_previous = true;
+        previous_start = sector.start;
+    }
+    return true;
+}
+
+/**
+ * Passes the records of a sector that fall in the range to @p callback. If
+ * @p ordered, records past the range end the query. Returns non-zero if the
+ * query is over.
+ */
+static int query_sector(sector_reader_t *reader,
+                        int64_t from,
+                        int64_t to,
+                        bool ordered,
+                        co2_log_query_cb_t *callback,
+                        void *arg) {
+    delta_state_t state = { 0 };
+    co2_log_record_t record;
+    while (!decode_record(reader, &state, &record)) {
+        if (record.timestamp > to) {
+            if (ordered) {
+                return 1;
+            }
+            continue;
+        }
+        if (record.timestamp >= from) {
+            int stop = callback(&record, arg);
+            if (stop) {
+                return stop;
+            }
+        }
+    }
+    return 0;
+}
+
+int co2_log_query(int64_t from,
+                  int64_t to,
+                  co2_log_query_cb_t *callback,
+                  void *arg) {
+    assert(callback);
+
+    pthread_mutex_lock(&log_state.mutex);
+    if (!log_state.partition) {
+        pthread_mutex_unlock(&log_state.mutex);
+        return -1;
+    }
+
+    // records appended by older firmware may predate the clock being set,
+    // then the time ranges of sectors overlap and all of them are decoded
+    const bool ordered = sectors_ordered();
+    if (!ordered) {
+        ESP_LOGW(TAG, "Timestamps go back in time, scanning the whole log");
+    }
+
+    // sectors are visited from the oldest one, the active sector comes last
+    query_sector_t current;
+    query_sector_t next;
+    bool has_current = false;
+    int stop = 0;
+    for (size_t i = 1; i <= log_state.sector_count && !stop; i++) {
+        if (!open_sector((log_state.active_sector + i)
+                                 % log_state.sector_count,
+                         &next)) {
+            continue;
+        }
+        // records of a sector are not newer than the first one of the next
+        // sector, so sectors ending before the range are not decoded at all
+        if (has_current && (!ordered || next.start >= from)) {
+            stop = query_sector(&current.reader, from, to, ordered, callback,
+                                arg);
+        }
+        current = next;
+        has_current = true;
+    }
+    if (has_current && !stop) {
+        query_sector(&current.reader, from, to, ordered, callback, arg);
+    }
+    pthread_mutex_unlock(&log_state.mutex);
+    return 0;
+}
+
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
@@ -0,0 +1,53 @@
+#ifndef _CO2_LOG_H_
+#define _CO2_LOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Append-only CO2 time-series log kept in the "co2_log" data partition.
+ *
+ * The partition is used as a ring of flash sectors, written strictly in
+ * order, so every sector is erased once per pass over the partition. Records
+ * are delta encoded against the previous record of the same sector and
+ * stored as zigzag varints; the first record of each sector is stored against
+ * an all-zero state, so every sector can be decoded on its own.
+ *
+ * Records are collected in a RAM copy of the active sector and programmed to
+ * flash once a flash page worth of them is pending, or when co2_log_flush()
+ * is called, so a power loss costs at most that many records. Erased flash
+ * can be programmed in place, so this does not add erase cycles.
+ *
+ * Records are appended only once the clock is set (see time_sync.h), so
+ * timestamps do not decrease and queries decode only the sectors that may
+ * hold records of the requested range. If the first records of the sectors
+ * do go back in time, e.g. when written by older firmware that logged with
+ * the clock not set, queries fall back to decoding the whole log.
+ */
+#define CO2_LOG_PARTITION_LABEL "co2_log"
+// custom partition type, out of the range reserved for ESP-IDF
+#define CO2_LOG_PARTITION_TYPE 0x40
+#define CO2_LOG_PARTITION_SUBTYPE 0x00
+
+typedef struct co2_log_record_struct {
+    int64_t timestamp;   // in seconds since Unix epoch
+    uint16_t co2;        // in ppm
+    int16_t temperature; // in 0.1 Cel
+    uint16_t humidity;   // in 0.1 %RH
+} co2_log_record_t;
+
+/**
+ * Called for every record matching the query, oldest first. Returning a
+ * non-zero value stops the query.
+ */
+typedef int co2_log_query_cb_t(const co2_log_record_t *record, void *arg);
+
+int co2_log_init(void);
+int co2_log_append(const co2_log_record_t *record);
+int co2_log_flush(void);
+int co2_log_query(int64_t from,
+                  int64_t to,
+                  co2_log_query_cb_t *callback,
+                  void *arg);
+
+#endif // _CO2_LOG_H_
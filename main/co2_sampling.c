@@ -0,0 +1,60 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+
+#include "co2_sampling.h"
+
+void co2_sampling_init(co2_sampling_t *sampling, uint16_t period) {
+    assert(sampling);
+    *sampling = (co2_sampling_t) {
+        .period = period
+    };
+}
+
+#if CONFIG_ANJAY_CLIENT_CO2_ADAPTIVE_PERIOD
+
+uint16_t co2_sampling_update(co2_sampling_t *sampling, uint16_t value) {
+    assert(sampling);
+
+    if (!sampling->has_last_value) {
+        sampling->has_last_value = true;
+        sampling->last_value = value;
+        return sampling->period;
+    }
+
+    const int32_t rate = ((int32_t) value - sampling->last_value) * 60
+                         / (int32_t) sampling->period;
+    sampling->smoothed_rate = (sampling->smoothed_rate + rate) / 2;
+    sampling->last_value = value;
+
+    uint32_t period = sampling->period;
+    if (rate >= CONFIG_ANJAY_CLIENT_CO2_FAST_RISE_RATE) {
+        // react to the first steep rise without waiting for the average
+        period = CONFIG_ANJAY_CLIENT_CO2_FAST_PERIOD;
+    } else if (abs(sampling->smoothed_rate)
+               <= CONFIG_ANJAY_CLIENT_CO2_STABLE_RATE) {
+        period *= 2;
+    } else {
+        period /= 2;
+    }
+
+    if (period < CONFIG_ANJAY_CLIENT_CO2_FAST_PERIOD) {
+        period = CONFIG_ANJAY_CLIENT_CO2_FAST_PERIOD;
+    } else if (period > CONFIG_ANJAY_CLIENT_CO2_SLOW_PERIOD) {
+        period = CONFIG_ANJAY_CLIENT_CO2_SLOW_PERIOD;
+    }
+    sampling->period = (uint16_t) period;
+    return sampling->period;
+}
+
+#else // CONFIG_ANJAY_CLIENT_CO2_ADAPTIVE_PERIOD
+
+uint16_t co2_sampling_update(co2_sampling_t *sampling, uint16_t value) {
+    assert(sampling);
+    (void) value;
+    return sampling->period;
+}
+
+#endif // CONFIG_ANJAY_CLIENT_CO2_ADAPTIVE_PERIOD
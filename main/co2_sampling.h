@@ -0,0 +1,32 @@
+#ifndef _CO2_SAMPLING_H_
+#define _CO2_SAMPLING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Adaptive CO2 measurement period controller.
+ *
+ * The period drops straight to CONFIG_ANJAY_CLIENT_CO2_FAST_PERIOD when CO2
+ * rises faster than CONFIG_ANJAY_CLIENT_CO2_FAST_RISE_RATE (e.g. people
+ * entering the room). While the smoothed rate of change stays below
+ * CONFIG_ANJAY_CLIENT_CO2_STABLE_RATE the period doubles with every sample up
+ * to CONFIG_ANJAY_CLIENT_CO2_SLOW_PERIOD; in between it is halved back towards
+ * the fast one.
+ */
+typedef struct co2_sampling_struct {
+    uint16_t period;       // in seconds
+    uint16_t last_value;   // in ppm
+    int32_t smoothed_rate; // in ppm/min
+    bool has_last_value;
+} co2_sampling_t;
+
+void co2_sampling_init(co2_sampling_t *sampling, uint16_t period);
+
+/**
+ * Feeds a sample measured with the current period and returns the period
+ * that should be used from now on.
+ */
+uint16_t co2_sampling_update(co2_sampling_t *sampling, uint16_t value);
+
+#endif // _CO2_SAMPLING_H_
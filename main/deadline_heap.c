@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdbool.h>
+
+#include "deadline_heap.h"
+
+#define PARENT(Index) (((Index) - 1) / 2)
+#define LEFT_CHILD(Index) (2 * (Index) + 1)
+
+static bool earlier(const deadline_heap_t *heap, uint8_t a, uint8_t b) {
+    return avs_time_monotonic_before(heap->entries[a].deadline,
+                                     heap->entries[b].deadline);
+}
+
+static void swap(deadline_heap_t *heap, uint8_t a, uint8_t b) {
+    const deadline_heap_entry_t tmp = heap->entries[a];
+    heap->entries[a] = heap->entries[b];
+    heap->entries[b] = tmp;
+}
+
+int deadline_heap_push(deadline_heap_t *heap,
+                       uint8_t id,
+                       avs_time_monotonic_t deadline) {
+    assert(heap);
+
+    if (heap->size == DEADLINE_HEAP_CAPACITY) {
+        return -1;
+    }
+    uint8_t index = heap->size++;
+    heap->entries[index] = (deadline_heap_entry_t) {
+        .deadline = deadline,
+        .id = id
+    };
+    while (index && earlier(heap, index, PARENT(index))) {
+        swap(heap, index, PARENT(index));
+        index = PARENT(index);
+    }
+    return 0;
+}
+
+int deadline_heap_peek(const deadline_heap_t *heap,
+                       deadline_heap_entry_t *out_entry) {
+    assert(heap);
+    assert(out_entry);
+
+    if (!heap->size) {
+        return -1;
+    }
+    *out_entry = heap->entries[0];
+    return 0;
+}
+
+void deadline_heap_pop(deadline_heap_t *heap) {
+    assert(heap);
+
+    if (!heap->size) {
+        return;
+    }
+    heap->entries[0] = heap->entries[--heap->size];
+    uint8_t index = 0;
+    for (;;) {
+        uint8_t earliest = index;
+        const uint8_t left = LEFT_CHILD(index);
+        if (left < heap->size && earlier(heap, left, earliest)) {
+            earliest = left;
+        }
+        if (left + 1 < heap->size && earlier(heap, left + 1, earliest)) {
+            earliest = left + 1;
+        }
+        if (earliest == index) {
+            return;
+        }
+        swap(heap, index, earliest);
+        index = earliest;
+    }
+}
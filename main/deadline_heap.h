@@ -0,0 +1,44 @@
+#ifndef _DEADLINE_HEAP_H_
+#define _DEADLINE_HEAP_H_
+
+#include <stdint.h>
+
+#include <avsystem/commons/avs_time.h>
+
+/*
+ * Binary min-heap of deadlines, each tagged with an id chosen by the user.
+ * The earliest deadline is available in O(1); pushing and popping cost
+ * O(log n). A zero-initialized heap is empty and ready to use.
+ */
+#define DEADLINE_HEAP_CAPACITY 8
+
+typedef struct deadline_heap_entry_struct {
+    avs_time_monotonic_t deadline;
+    uint8_t id;
+} deadline_heap_entry_t;
+
+typedef struct deadline_heap_struct {
+    deadline_heap_entry_t entries[DEADLINE_HEAP_CAPACITY];
+    uint8_t size;
+} deadline_heap_t;
+
+/**
+ * Returns -1 if the heap is full.
+ */
+int deadline_heap_push(deadline_heap_t *heap,
+                       uint8_t id,
+                       avs_time_monotonic_t deadline);
+
+/**
+ * Copies the entry with the earliest deadline to @p out_entry without
+ * removing it. Returns -1 if the heap is empty.
+ */
+int deadline_heap_peek(const deadline_heap_t *heap,
+                       deadline_heap_entry_t *out_entry);
+
+/**
+ * Removes the entry with the earliest deadline, if any.
+ */
+void deadline_heap_pop(deadline_heap_t *heap);
+
+#endif // _DEADLINE_HEAP_H_
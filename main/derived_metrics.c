@@ -0,0 +1,59 @@
+#include <math.h>
+
+#include "derived_metrics.h"
+
+// Magnus formula coefficients, over water
+#define MAGNUS_A 6.112f // in hPa
+#define MAGNUS_B 17.62f
+#define MAGNUS_C 243.12f // in Cel
+
+// water vapour gas constant based factor, in g*K/(m3*hPa)
+#define ABSOLUTE_HUMIDITY_FACTOR 216.7f
+#define ZERO_CELSIUS 273.15f // in K
+
+// relative humidity is clamped above 0, where dew point is undefined
+#define MIN_HUMIDITY 0.1f // in %
+
+static float clamp_humidity(float humi) {
+    if (humi < MIN_HUMIDITY) {
+        return MIN_HUMIDITY;
+    }
+    return humi > 100.0f ? 100.0f : humi;
+}
+
+float derived_metrics_dew_point(float temp, float humi) {
+    const float gamma = logf(clamp_humidity(humi) / 100.0f)
+                        + MAGNUS_B * temp / (MAGNUS_C + temp);
+    return MAGNUS_C * gamma / (MAGNUS_B - gamma);
+}
+
+float derived_metrics_absolute_humidity(float temp, float humi) {
+    // saturation vapour pressure, in hPa
+    const float saturation =
+            MAGNUS_A * expf(MAGNUS_B * temp / (MAGNUS_C + temp));
+    return ABSOLUTE_HUMIDITY_FACTOR * (clamp_humidity(humi) / 100.0f)
+           * saturation / (ZERO_CELSIUS + temp);
+}
+
+float derived_metrics_heat_index(float temp, float humi) {
+    // the NWS formulas are defined in Fahrenheit
+    const float t = temp * 1.8f + 32.0f;
+    const float rh = clamp_humidity(humi);
+
+    // Steadman's simple formula, good enough below 80 F
+    float hi = 0.5f * (t + 61.0f + (t - 68.0f) * 1.2f + rh * 0.094f);
+    if ((hi + t) / 2.0f >= 80.0f) {
+        // Rothfusz regression
+        hi = -42.379f + 2.04901523f * t + 10.14333127f * rh
+             - 0.22475541f * t * rh - 0.00683783f * t * t
+             - 0.05481717f * rh * rh + 0.00122874f * t * t * rh
+             + 0.00085282f * t * rh * rh - 0.00000199f * t * t * rh * rh;
+        if (rh < 13.0f && t >= 80.0f && t <= 112.0f) {
+            hi -= (13.0f - rh) / 4.0f
+                  * sqrtf((17.0f - fabsf(t - 95.0f)) / 17.0f);
+        } else if (rh > 85.0f && t >= 80.0f && t <= 87.0f) {
+            hi += (rh - 85.0f) / 10.0f * (87.0f - t) / 5.0f;
+        }
+    }
+    return (hi - 32.0f) / 1.8f;
+}
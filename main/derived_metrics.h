@@ -0,0 +1,28 @@
+#ifndef _DERIVED_METRICS_H_
+#define _DERIVED_METRICS_H_
+
+/*
+ * Environmental metrics derived from temperature (in Cel) and relative
+ * humidity (in %). Single precision only: the ESP32 FPU does not support
+ * double, so these are several times cheaper than their double counterparts.
+ *
+ * Saturation vapour pressure uses the Magnus formula with Sonntag
+ * coefficients, accurate to 0.35 Cel between -45 and 60 Cel.
+ */
+
+/**
+ * Temperature to which air has to be cooled to become saturated, in Cel.
+ */
+float derived_metrics_dew_point(float temp, float humi);
+
+/**
+ * Mass of water vapour in a unit volume of air, in g/m3.
+ */
+float derived_metrics_absolute_humidity(float temp, float humi);
+
+/**
+ * Apparent temperature perceived by humans (NWS heat index), in Cel.
+ */
+float derived_metrics_heat_index(float temp, float humi);
+
+#endif // _DERIVED_METRICS_H_
@@ -0,0 +1,65 @@
+#include <math.h>
+#include <stdbool.h>
+
+#include "fixed_fft.h"
+
+#define QUARTER (FIXED_FFT_SIZE / 4)
+
+// sin(2 * pi * i / FIXED_FFT_SIZE) in Q15, cosine is read QUARTER further
+static int16_t sine[FIXED_FFT_SIZE / 2 + QUARTER];
+static bool sine_initialized;
+
+static void init_sine(void) {
+    for (int i = 0; i < (int) (sizeof(sine) / sizeof(sine[0])); i++) {
+        sine[i] = (int16_t) lrintf(
+                32767.0f * sinf(2.0f * (float) M_PI * i / FIXED_FFT_SIZE));
+    }
+    sine_initialized = true;
+}
+
+static void bit_reverse(int16_t *re, int16_t *im) {
+    for (uint32_t i = 1, j = 0; i < FIXED_FFT_SIZE; i++) {
+        uint32_t bit = FIXED_FFT_SIZE >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int16_t tmp = re[i];
+            re[i] = re[j];
+            re[j] = tmp;
+            tmp = im[i];
+            im[i] = im[j];
+            im[j] = tmp;
+        }
+    }
+}
+
+void fixed_fft(int16_t *re, int16_t *im) {
+    if (!sine_initialized) {
+        init_sine();
+    }
+    bit_reverse(re, im);
+
+    for (uint32_t len = 2; len <= FIXED_FFT_SIZE; len <<= 1) {
+        const uint32_t half = len / 2;
+        const uint32_t step = FIXED_FFT_SIZE / len;
+        for (uint32_t start = 0; start < FIXED_FFT_SIZE; start += len) {
+            for (uint32_t k = 0; k < half; k++) {
+                // twiddle factor exp(-2 * pi * i * k / len)
+                const int32_t wr = sine[k * step + QUARTER];
+                const int32_t wi = -sine[k * step];
+                const uint32_t a = start + k;
+                const uint32_t b = a + half;
+                const int32_t tr = (wr * re[b] - wi * im[b]) >> 15;
+                const int32_t ti = (wr * im[b] + wi * re[b]) >> 15;
+                const int32_t ar = re[a];
+                const int32_t ai = im[a];
+                re[a] = (int16_t) ((ar + tr) >> 1);
+                im[a] = (int16_t) ((ai + ti) >> 1);
+                re[b] = (int16_t) ((ar - tr) >> 1);
+                im[b] = (int16_t) ((ai - ti) >> 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef _FIXED_FFT_H_
+#define _FIXED_FFT_H_
+
+#include <stdint.h>
+
+#define FIXED_FFT_SIZE_LOG2 8
+#define FIXED_FFT_SIZE (1 << FIXED_FFT_SIZE_LOG2)
+// largest input magnitude for which no stage of fixed_fft() overflows
+#define FIXED_FFT_MAX_INPUT ((1 << 14) - 1)
+
+/**
+ * In-place radix-2 FFT of FIXED_FFT_SIZE complex points in Q15, with inputs
+ * of magnitude up to FIXED_FFT_MAX_INPUT. Every stage is scaled by 1/2, so
+ * the result is the DFT divided by FIXED_FFT_SIZE.
+ *
+ * Not reentrant on the first call, which fills the twiddle factor table.
+ */
+void fixed_fft(int16_t *re, int16_t *im);
+
+#endif // _FIXED_FFT_H_
@@ -0,0 +1,125 @@
+#include <assert.h>
+#include <string.h>
+
+#include "hampel_filter.h"
+
+// consistency constant of MAD for normally distributed data, times 1000
+#define MAD_SCALE_X1000 1483
+
+// outliers are not detected until the window holds this many samples
+#define MIN_SAMPLES 3
+
+void hampel_filter_init(hampel_filter_t *filter,
+                        uint8_t window_size,
+                        uint16_t threshold,
+                        uint16_t min_deviation) {
+    assert(filter);
+    assert(window_size > 0 && window_size <= HAMPEL_FILTER_MAX_WINDOW);
+    memset(filter, 0, sizeof(*filter));
+    filter->window_size = window_size;
+    filter->threshold = threshold;
+    filter->min_deviation = min_deviation;
+}
+
+// index of the first sorted element not less than value
+static uint8_t lower_bound(const hampel_filter_t *filter, uint16_t value) {
+    uint8_t lo = 0;
+    uint8_t hi = filter->count;
+    while (lo < hi) {
+        const uint8_t mid = (uint8_t) ((lo + hi) / 2);
+        if (filter->sorted[mid] < value) {
+            lo = (uint8_t) (mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void sorted_remove(hampel_filter_t *filter, uint16_t value) {
+    const uint8_t index = lower_bound(filter, value);
+    assert(index < filter->count && filter->sorted[index] == value);
+    memmove(&filter->sorted[index], &filter->sorted[index + 1],
+            (filter->count - index - 1) * sizeof(filter->sorted[0]));
+    filter->count--;
+}
+
+static void sorted_insert(hampel_filter_t *filter, uint16_t value) {
+    const uint8_t index = lower_bound(filter, value);
+    memmove(&filter->sorted[index + 1], &filter->sorted[index],
+            (filter->count - index) * sizeof(filter->sorted[0]));
+    filter->sorted[index] = value;
+    filter->count++;
+}
+
+// median times 2, to stay in integers for even counts
+static uint32_t median_x2(const uint16_t *sorted, uint8_t count) {
+    return (uint32_t) sorted[(count - 1) / 2] + sorted[count / 2];
+}
+
+// median absolute deviation times 2, around a median given times 2
+static uint32_t mad_x2(const hampel_filter_t *filter, uint32_t med_x2) {
+    const uint8_t count = filter->count;
+    // deviations (times 2) grow when walking left from the median on the
+    // lower side and right on the upper side, so merging both walks yields
+    // them in sorted order
+    int left = (int) lower_bound(filter, (uint16_t) ((med_x2 + 1) / 2)) - 1;
+    int right = left + 1;
+    uint32_t prev = 0;
+    uint32_t curr = 0;
+
+    for (uint8_t i = 0; i <= count / 2; i++) {
+        const uint32_t left_dev = left >= 0
+                                          ? med_x2 - 2U * filter->sorted[left]
+                                          : UINT32_MAX;
+        const uint32_t right_dev = right < count
+                                           ? 2U * filter->sorted[right] - med_x2
+                                           : UINT32_MAX;
+        prev = curr;
+        if (left_dev <= right_dev) {
+            curr = left_dev;
+            left--;
+        } else {
+            curr = right_dev;
+            right++;
+        }
+    }
+    // the loop stopped at element count / 2 of the sorted deviations
+    return count % 2 ? curr : (prev + curr) / 2;
+}
+
+uint16_t hampel_filter_update(hampel_filter_t *filter,
+                              uint16_t sample,
+                              bool *out_is_outlier) {
+    assert(filter);
+
+    if (filter->count == filter->window_size) {
+        sorted_remove(filter, filter->samples[filter->head]);
+        filter->samples[filter->head] = sample;
+        filter->head = (uint8_t) ((filter->head + 1) % filter->window_size);
+    } else {
+        filter->samples[(filter->head + filter->count) % filter->window_size] =
+                sample;
+    }
+    sorted_insert(filter, sample);
+
+    bool is_outlier = false;
+    uint16_t result = sample;
+    if (filter->count >= MIN_SAMPLES) {
+        const uint32_t med_x2 = median_x2(filter->sorted, filter->count);
+        const uint32_t dev_x2 = 2U * sample > med_x2 ? 2U * sample - med_x2
+                                                     : med_x2 - 2U * sample;
+        // dev > threshold / 10 * MAD_SCALE * mad, all sides times 2
+        const uint64_t limit_x2 = (uint64_t) filter->threshold
+                                  * MAD_SCALE_X1000 * mad_x2(filter, med_x2)
+                                  / 10000;
+        if (dev_x2 > limit_x2 && dev_x2 > 2U * filter->min_deviation) {
+            is_outlier = true;
+            result = (uint16_t) (med_x2 / 2);
+        }
+    }
+    if (out_is_outlier) {
+        *out_is_outlier = is_outlier;
+    }
+    return result;
+}
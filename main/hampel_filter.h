@@ -0,0 +1,47 @@
+#ifndef _HAMPEL_FILTER_H_
+#define _HAMPEL_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Streaming Hampel identifier over the last window_size samples.
+ *
+ * A sample deviating from the window median by more than threshold times the
+ * scaled median absolute deviation (and by more than min_deviation) is
+ * considered an outlier and replaced with the median. The window is kept both
+ * in arrival order and sorted, so that every sample costs two binary searches
+ * and two short memmove() calls; the MAD is found by merging the deviations on
+ * both sides of the median, which are already sorted.
+ *
+ * The cost per sample is O(window_size), not constant: the memmove() calls
+ * and the merge walk cover up to the whole window. Windows are limited to
+ * HAMPEL_FILTER_MAX_WINDOW samples, which bounds it; see
+ * test/hampel_filter_benchmark.c for the figures.
+ */
+#define HAMPEL_FILTER_MAX_WINDOW 31
+
+typedef struct hampel_filter_struct {
+    uint16_t samples[HAMPEL_FILTER_MAX_WINDOW]; // in arrival order
+    uint16_t sorted[HAMPEL_FILTER_MAX_WINDOW];
+    uint8_t window_size;
+    uint8_t head; // oldest sample
+    uint8_t count;
+    uint16_t threshold;     // in 0.1 of the scaled MAD
+    uint16_t min_deviation; // in units of the samples
+} hampel_filter_t;
+
+void hampel_filter_init(hampel_filter_t *filter,
+                        uint8_t window_size,
+                        uint16_t threshold,
+                        uint16_t min_deviation);
+
+/**
+ * Adds @p sample to the window and returns the filtered value: the sample
+ * itself, or the window median if the sample is an outlier.
+ */
+uint16_t hampel_filter_update(hampel_filter_t *filter,
+                              uint16_t sample,
+                              bool *out_is_outlier);
+
+#endif // _HAMPEL_FILTER_H_
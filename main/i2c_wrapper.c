@@ -97,6 +97,47 @@ int i2c_master_write_slave_reg(const i2c_device_t *const device,
     }
 }
 
+int i2c_master_read_write_slave_reg(const i2c_device_t *const device,
+                                    const uint8_t rd_reg,
+                                    uint8_t *const data_rd,
+                                    const uint8_t rd_size,
+                                    const uint8_t wr_reg,
+                                    const uint8_t *data_wr,
+                                    const uint32_t wr_size) {
+    if (rd_size == 0) {
+        return i2c_master_write_slave_reg(device, wr_reg, data_wr, wr_size);
+    }
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (!cmd) {
+        return -1;
+    }
+    esp_err_t ret = -1;
+    if (!i2c_master_start(cmd)
+            && !i2c_master_write_byte(cmd,
+                                      (device->address << 1) | I2C_MASTER_WRITE,
+                                      I2C_ACK_CHECK_EN)
+            && !i2c_master_write_byte(cmd, rd_reg, I2C_ACK_CHECK_EN)
+            && !i2c_master_start(cmd)
+            && !i2c_master_write_byte(cmd,
+                                      (device->address << 1) | I2C_MASTER_READ,
+                                      I2C_ACK_CHECK_EN)
+            && (rd_size <= 1
+                || !i2c_master_read(cmd, data_rd, rd_size - 1, I2C_MASTER_ACK))
+            && !i2c_master_read_byte(cmd, data_rd + rd_size - 1,
+                                     I2C_MASTER_NACK)
+            && !i2c_master_start(cmd)
+            && !i2c_master_write_byte(cmd,
+                                      (device->address << 1) | I2C_MASTER_WRITE,
+                                      I2C_ACK_CHECK_EN)
+            && !i2c_master_write_byte(cmd, wr_reg, I2C_ACK_CHECK_EN)
+            && !i2c_master_write(cmd, data_wr, wr_size, I2C_ACK_CHECK_EN)
+            && !i2c_master_stop(cmd)) {
+        ret = i2c_master_cmd_begin(device->port, cmd, I2C_TIMEOUT_TICKS);
+    }
+    i2c_cmd_link_delete(cmd);
+    return (int) ret;
+}
+
 int i2c_device_init(const i2c_device_t *const device) {
     if (i2c_param_config(device->port, &(device->config))) {
         return -1;
@@ -39,6 +39,18 @@ int i2c_master_write_slave_reg(const i2c_device_t *const device,
                                const uint8_t i2c_reg,
                                const uint8_t *data_wr,
                                const uint32_t size);
+/**
+ * Reads @p rd_size bytes starting at @p rd_reg, then writes @p wr_size bytes
+ * starting at @p wr_reg, in a single bus transaction (repeated start between
+ * the parts).
+ */
+int i2c_master_read_write_slave_reg(const i2c_device_t *const device,
+                                    const uint8_t rd_reg,
+                                    uint8_t *const data_rd,
+                                    const uint8_t rd_size,
+                                    const uint8_t wr_reg,
+                                    const uint8_t *data_wr,
+                                    const uint32_t wr_size);
 int i2c_device_init(const i2c_device_t *const device);
 
 #endif /* _I2C_WRAPPER_H_ */
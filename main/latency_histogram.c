@@ -0,0 +1,53 @@
+#include <assert.h>
+
+#include "latency_histogram.h"
+
+void latency_histogram_record(latency_histogram_t *histogram,
+                              uint32_t duration_us) {
+    assert(histogram);
+
+    int bucket = 0;
+    while (bucket < LATENCY_HISTOGRAM_BUCKETS - 1
+           && duration_us >= (1U << bucket)) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&histogram->counts[bucket], 1,
+                              memory_order_relaxed);
+}
+
+void latency_histogram_snapshot(
+        latency_histogram_t *histogram,
+        uint32_t out_counts[LATENCY_HISTOGRAM_BUCKETS]) {
+    assert(histogram);
+    assert(out_counts);
+
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        out_counts[i] = atomic_load_explicit(&histogram->counts[i],
+                                             memory_order_relaxed);
+    }
+}
+
+uint32_t
+latency_histogram_percentile(const uint32_t counts[LATENCY_HISTOGRAM_BUCKETS],
+                             uint16_t permille) {
+    assert(counts);
+    assert(permille <= 1000);
+
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        total += counts[i];
+    }
+    if (!total) {
+        return 0;
+    }
+    // smallest number of durations that makes up the requested fraction
+    const uint64_t rank = (total * permille + 999) / 1000;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS - 1; i++) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return 1U << i;
+        }
+    }
+    return UINT32_MAX;
+}
@@ -0,0 +1,34 @@
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Histogram of durations with logarithmic buckets: bucket i counts durations
+ * below 2^i us (and not below 2^(i-1) us), the last one everything longer.
+ * Recording is lock-free, so any task may record while another one takes
+ * a snapshot. A zero-initialized histogram is empty.
+ */
+#define LATENCY_HISTOGRAM_BUCKETS 24 // the last one starts at about 4 s
+
+typedef struct latency_histogram_struct {
+    atomic_uint counts[LATENCY_HISTOGRAM_BUCKETS];
+} latency_histogram_t;
+
+void latency_histogram_record(latency_histogram_t *histogram,
+                              uint32_t duration_us);
+
+void latency_histogram_snapshot(latency_histogram_t *histogram,
+                                uint32_t out_counts[LATENCY_HISTOGRAM_BUCKETS]);
+
+/**
+ * Returns the upper bound, in us, of the bucket holding the @p permille-th
+ * permille of durations in @p counts, UINT32_MAX if it is the last bucket and
+ * 0 if there are no durations at all.
+ */
+uint32_t
+latency_histogram_percentile(const uint32_t counts[LATENCY_HISTOGRAM_BUCKETS],
+                             uint16_t permille);
+
+#endif // _LATENCY_HISTOGRAM_H_
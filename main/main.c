@@ -15,6 +15,8 @@
  */
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
@@ -35,8 +37,11 @@
 #include <anjay/core.h>
 #include <anjay/security.h>
 #include <anjay/server.h>
+#include <avsystem/commons/avs_defs.h>
 #include <avsystem/commons/avs_log.h>
 
+#include "co2_log.h"
+#include "co2_sampling.h"
 #include "connect.h"
 #include "default_config.h"
 #include "firmware_update.h"
@@ -48,7 +53,10 @@
 #include "oled.h"
 #include "oled_page.h"
 #include "pasco2.h"
+#include "sample_queue.h"
 #include "shtc3.h"
+#include "time_sync.h"
+#include "uplink_batch.h"
 
 #include "firmware_update.h"
 #include "objects/objects.h"
@@ -84,16 +92,42 @@ static const anjay_dm_object_def_t **DEVICE_OBJ;
 static const anjay_dm_object_def_t **PUSH_BUTTON_OBJ;
 static const anjay_dm_object_def_t **LIGHT_CONTROL_OBJ;
 static const anjay_dm_object_def_t **AIR_QUALITY_OBJ;
+static const anjay_dm_object_def_t **VIBRATION_OBJ;
+static const anjay_dm_object_def_t **MOTION_OBJ;
+static const anjay_dm_object_def_t **SENSOR_STATS_OBJ;
+static const anjay_dm_object_def_t **SHTC3_PROFILE_OBJ;
 #ifdef CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
 static const anjay_dm_object_def_t **WLAN_OBJ;
 #endif // CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
 
 static anjay_t *anjay;
-static avs_sched_handle_t sensors_job_handle;
+static avs_sched_handle_t update_objects_job_handle;
 static avs_sched_handle_t connection_status_job_handle;
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+static avs_sched_handle_t save_state_job_handle;
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
 #ifdef CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
 static avs_sched_handle_t change_config_job_handle;
 #endif // CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
+#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+/*
+ * A CO2 sensor with the Air quality object instance it feeds. Every channel
+ * is driven by an air_quality_task of its own, the only producer of its
+ * queue, which update_objects_job drains.
+ */
+typedef struct {
+    pasco2_t sensor;
+    anjay_iid_t iid; // of the Air quality object instance bound to sensor
+    co2_sampling_t sampling;
+    sample_queue_t queue;
+} co2_channel_t;
+
+static co2_channel_t onboard_co2_channel = {
+    .iid = AIR_QUALITY_ONBOARD_IID
+};
+
+static co2_channel_t *const CO2_CHANNELS[] = { &onboard_co2_channel };
+#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
 static int read_anjay_config();
 #ifdef CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
@@ -164,7 +198,7 @@ static int setup_security_object(anjay_t *anjay) {
     }
 
     anjay_security_instance_t security_instance = {
-        .ssid = 1,
+        .ssid = MAIN_SERVER_SSID,
         .server_uri = SERVER_URI,
 #if defined(CONFIG_ANJAY_SECURITY_MODE_CERTIFICATES)
         .security_mode = ANJAY_SECURITY_CERTIFICATE,
@@ -204,7 +238,7 @@ static int setup_server_object(anjay_t *anjay) {
 
     const anjay_server_instance_t server_instance = {
         // Server Short ID
-        .ssid = 1,
+        .ssid = MAIN_SERVER_SSID,
         // Client will send Update message often than every 60 seconds
         .lifetime = 60,
         // Disable Default Minimum Period resource
@@ -227,18 +261,70 @@ static int setup_server_object(anjay_t *anjay) {
     return 0;
 }
 
+#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+static void drain_co2_samples(anjay_t *anjay) {
+    for (int i = 0; i < (int) AVS_ARRAY_SIZE(CO2_CHANNELS); i++) {
+        sample_queue_entry_t sample;
+        while (sample_queue_pop(&CO2_CHANNELS[i]->queue, &sample)) {
+            air_quality_update_measurment_val(anjay, AIR_QUALITY_OBJ,
+                                              sample.iid, sample.co2,
+                                              sample.period, sample.timestamp);
+        }
+    }
+}
+#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+
 static void update_objects_job(avs_sched_t *sched, const void *anjay_ptr) {
     anjay_t *anjay = *(anjay_t *const *) anjay_ptr;
 
     device_object_update(anjay, DEVICE_OBJ);
     push_button_object_update(anjay, PUSH_BUTTON_OBJ);
+    vibration_object_update(anjay, VIBRATION_OBJ);
+    motion_object_update(anjay, MOTION_OBJ);
     sensors_update(anjay);
+    sensor_stats_object_update(anjay, SENSOR_STATS_OBJ);
+#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+    drain_co2_samples(anjay);
+#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
-    AVS_SCHED_DELAYED(sched, &sensors_job_handle,
+    AVS_SCHED_DELAYED(sched, &update_objects_job_handle,
                       avs_time_duration_from_scalar(1, AVS_TIME_S),
                       &update_objects_job, &anjay, sizeof(anjay));
 }
 
+bool main_is_warm_reset(void) {
+    switch (esp_reset_reason()) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+static void save_state_job(avs_sched_t *sched, const void *args) {
+    (void) args;
+
+    if (AIR_QUALITY_OBJ && air_quality_save_state(AIR_QUALITY_OBJ)) {
+        avs_log(tutorial, WARNING, "Could not save air quality state");
+    }
+    // records pending since the last flash page was programmed
+    if (co2_log_flush()) {
+        avs_log(tutorial, WARNING, "Could not flush CO2 log");
+    }
+
+    AVS_SCHED_DELAYED(sched, &save_state_job_handle,
+                      avs_time_duration_from_scalar(
+                              CONFIG_ANJAY_CLIENT_CO2_STATE_SAVE_PERIOD,
+                              AVS_TIME_MIN),
+                      save_state_job, NULL, 0);
+}
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+
 #if CONFIG_ANJAY_CLIENT_LCD
 static void check_and_write_connection_status(anjay_t *anjay) {
     if (anjay_get_socket_entries(anjay) == NULL) {
@@ -349,6 +435,23 @@ static void anjay_init(void) {
 
     if ((AIR_QUALITY_OBJ = air_quality_object_create())) {
         anjay_register_object(anjay, AIR_QUALITY_OBJ);
+        uplink_batch_init(anjay);
+    }
+
+    if ((VIBRATION_OBJ = vibration_object_create())) {
+        anjay_register_object(anjay, VIBRATION_OBJ);
+    }
+
+    if ((MOTION_OBJ = motion_object_create())) {
+        anjay_register_object(anjay, MOTION_OBJ);
+    }
+
+    if ((SENSOR_STATS_OBJ = sensor_stats_object_create())) {
+        anjay_register_object(anjay, SENSOR_STATS_OBJ);
+    }
+
+    if ((SHTC3_PROFILE_OBJ = shtc3_profile_object_create())) {
+        anjay_register_object(anjay, SHTC3_PROFILE_OBJ);
     }
 
 #ifdef CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
@@ -363,6 +466,13 @@ static void anjay_task(void *pvParameters) {
 
     update_connection_status_job(anjay_get_scheduler(anjay), &anjay);
     update_objects_job(anjay_get_scheduler(anjay), &anjay);
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+    AVS_SCHED_DELAYED(anjay_get_scheduler(anjay), &save_state_job_handle,
+                      avs_time_duration_from_scalar(
+                              CONFIG_ANJAY_CLIENT_CO2_STATE_SAVE_PERIOD,
+                              AVS_TIME_MIN),
+                      save_state_job, NULL, 0);
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
 
 #ifdef CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE
     cellular_event_loop_run(anjay);
@@ -370,45 +480,147 @@ static void anjay_task(void *pvParameters) {
     anjay_event_loop_run_with_error_handling(
             anjay, avs_time_duration_from_scalar(1, AVS_TIME_S));
 #endif // CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE
-    avs_sched_del(&sensors_job_handle);
+    avs_sched_del(&update_objects_job_handle);
+    sensors_stop();
     avs_sched_del(&connection_status_job_handle);
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+    avs_sched_del(&save_state_job_handle);
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+    uplink_batch_release();
     anjay_delete(anjay);
     sensors_release();
 
     if (fw_update_requested()) {
+#if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
+        co2_log_flush();
+        if (AIR_QUALITY_OBJ) {
+            air_quality_save_state(AIR_QUALITY_OBJ);
+        }
+#endif // CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
         fw_update_reboot();
     }
 }
 
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 static void IRAM_ATTR gpio_isr_handler(void *arg) {
+#    if CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    // level triggered, re-enabled once the interrupt status is cleared
+    gpio_intr_disable(GPIO_NUM_19);
+#    endif // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
     xSemaphoreGiveFromISR(gpio_semaphore, pdFALSE);
 }
 
-static void air_quality_task(void *pvParameters) {
+static void co2_log_measurment(uint16_t co2_val, avs_time_real_t time) {
+    int64_t timestamp;
+    sensor_value_t temp, humi;
+    // records must not go back in time across reboots, see time_sync.h
+    if (!time_sync_is_valid()
+            || avs_time_real_to_scalar(&timestamp, AVS_TIME_S, time)
+            || shtc3_get_last_temp_and_humi(&temp, &humi)) {
+        return;
+    }
+
+    const co2_log_record_t record = {
+        .timestamp = timestamp,
+        .co2 = co2_val,
+        .temperature = (int16_t) SENSOR_VALUE_ROUND(temp, 10),
+        .humidity = (uint16_t) SENSOR_VALUE_ROUND(humi, 10)
+    };
+    if (co2_log_append(&record)) {
+        avs_log(tutorial, WARNING, "Appending to CO2 log failed");
+    }
+}
+
+static void process_co2_measurment(co2_channel_t *channel) {
+    co2_sampling_t *sampling = &channel->sampling;
     uint16_t co2_val = 0;
+    bool ready;
+
+    if (pasco2_read_measur_val_and_clear(&channel->sensor, &co2_val, &ready)) {
+        // not known whether the interrupt status got cleared
+        while (pasco2_reset_int_status_clear(&channel->sensor)) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        return;
+    }
+    if (!ready) {
+        avs_log(tutorial, INFO, "Measurment not ready");
+        return;
+    }
+    avs_log(tutorial, INFO, "CO2 value: %uppm", co2_val);
+
+    // the data model is updated from the Anjay thread, see drain_co2_samples()
+    const sample_queue_entry_t sample = {
+        .timestamp = avs_time_real_now(),
+        .iid = channel->iid,
+        .co2 = co2_val,
+        .period = sampling->period
+    };
+    if (!sample_queue_push(&channel->queue, &sample)) {
+        avs_log(tutorial, WARNING, "CO2 sample queue full, %u samples dropped",
+                sample_queue_dropped(&channel->queue));
+    }
+    if (channel->iid == AIR_QUALITY_ONBOARD_IID) {
+        oled_page_update_co2(co2_val);
+        oled_update();
+        co2_log_measurment(co2_val, sample.timestamp);
+    }
 
-    while (pasco2_init()) {
+    const uint16_t period = sampling->period;
+    if (co2_sampling_update(sampling, co2_val) == period) {
+        return;
+    }
+#    if !CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    // in single shot mode the period is kept by air_quality_task
+    if (pasco2_set_measur_period(&channel->sensor, sampling->period)) {
+        avs_log(tutorial, WARNING, "Could not change CO2 measurment period");
+        sampling->period = period;
+        return;
+    }
+#    endif // !CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    avs_log(tutorial, INFO, "CO2 measurment period: %us",
+            (unsigned) sampling->period);
+}
+
+static void air_quality_task(void *pvParameters) {
+    co2_channel_t *channel = (co2_channel_t *) pvParameters;
+
+    while (pasco2_init(&channel->sensor)) {
         avs_log(tutorial, ERROR, "PASCO2 init failed");
         vTaskDelay(pdMS_TO_TICKS(2500));
     }
     avs_log(tutorial, INFO, "PASCO2 init done");
+    co2_sampling_init(&channel->sampling, PASCO2_MEASURMENTS_PERIOD);
 
+#    if CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    TickType_t last_wake_time = xTaskGetTickCount();
     for (;;) {
-        xSemaphoreTake(gpio_semaphore, portMAX_DELAY);
-        if (!pasco2_is_measur_rdy()) {
-            pasco2_get_measur_val(&co2_val);
-            avs_log(tutorial, INFO, "CO2 value: %uppm", co2_val);
-            oled_page_update_co2(co2_val);
-            oled_update();
-            air_quality_update_measurment_val(anjay, AIR_QUALITY_OBJ, co2_val);
+        if (pasco2_start_single_shot(&channel->sensor)) {
+            avs_log(tutorial, WARNING, "Could not start CO2 measurment");
         } else {
-            avs_log(tutorial, INFO, "Measurment not ready");
-        }
-        while (pasco2_reset_int_status_clear()) {
-            vTaskDelay(pdMS_TO_TICKS(100));
+            // the CPU sleeps until the data ready interrupt wakes it up
+            BaseType_t ready = xSemaphoreTake(
+                    gpio_semaphore,
+                    pdMS_TO_TICKS(PASCO2_SINGLE_SHOT_TIMEOUT_MS));
+            if (ready == pdTRUE) {
+                process_co2_measurment(channel);
+            } else {
+                avs_log(tutorial, WARNING, "CO2 measurment timed out");
+                while (pasco2_reset_int_status_clear(&channel->sensor)) {
+                    vTaskDelay(pdMS_TO_TICKS(100));
+                }
+            }
         }
+        gpio_intr_enable(GPIO_NUM_19);
+        vTaskDelayUntil(&last_wake_time,
+                        pdMS_TO_TICKS(channel->sampling.period * 1000UL));
+    }
+#    else  // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    for (;;) {
+        xSemaphoreTake(gpio_semaphore, portMAX_DELAY);
+        process_co2_measurment(channel);
     }
+#    endif // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
 }
 #endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
@@ -596,6 +808,20 @@ static void set_wifi_config(wifi_config_t *wifi_config) {
 }
 #endif // CONFIG_ANJAY_CLIENT_INTERFACE_ONBOARD_WIFI
 
+#if CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT || CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+static void enable_light_sleep(void) {
+    esp_pm_config_esp32_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,
+        .light_sleep_enable = true
+    };
+    if (esp_pm_configure(&pm_config)) {
+        avs_log(tutorial, WARNING, "Could not enable automatic light sleep");
+    }
+}
+#endif // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT ||
+       // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
@@ -620,9 +846,14 @@ void app_main(void) {
     oled_set_display_on();
 #endif // CONFIG_ANJAY_CLIENT_OLED
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+    pasco2_setup(&onboard_co2_channel.sensor, pasco2_onboard_device());
+    if (AIR_QUALITY_OBJ) {
+        air_quality_bind_sensor(AIR_QUALITY_OBJ, onboard_co2_channel.iid,
+                                &onboard_co2_channel.sensor);
+    }
     oled_page_init();
 
-    double temp, humi;
+    sensor_value_t temp, humi;
     if (shtc3_wakeup() || shtc3_get_temp_and_humi_polling(&temp, &humi)
             || shtc3_sleep()) {
         avs_log(tutorial, WARNING, "Reading temperature and humidity failed");
@@ -632,8 +863,14 @@ void app_main(void) {
     }
     gpio_config_t io_conf = {
         .pin_bit_mask = (1 << GPIO_NUM_19),
+#    if CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+        // edges are not detected in light sleep, data ready keeps the line
+        // low until the interrupt status is cleared
+        .intr_type = GPIO_INTR_LOW_LEVEL,
+#    else  // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
         // interrupt on falling edge
         .intr_type = GPIO_INTR_NEGEDGE,
+#    endif // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = true,
     };
@@ -642,10 +879,27 @@ void app_main(void) {
     gpio_install_isr_service(0);
     gpio_isr_handler_add(GPIO_NUM_19, gpio_isr_handler, NULL);
 
+#    if CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    // let the idle task put the CPU into light sleep, PASCO2 data ready
+    // interrupt wakes it up
+    gpio_wakeup_enable(GPIO_NUM_19, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    enable_light_sleep();
+#    endif // CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+
     vSemaphoreCreateBinary(gpio_semaphore);
 
-    xTaskCreate(&air_quality_task, "air_quality_task", 4092, NULL, 5, NULL);
+    if (co2_log_init()) {
+        avs_log(tutorial, WARNING, "CO2 log is not available");
+    }
+
+    xTaskCreate(&air_quality_task, "air_quality_task", 4092,
+                &onboard_co2_channel, 5, NULL);
 #endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+    // the MPU6886 motion interrupt wakes the CPU up, see motion_monitor.h
+    enable_light_sleep();
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
 
 #if defined(CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE)
     while (!setupCellular()) {
@@ -675,6 +929,7 @@ void app_main(void) {
         wlan_object_set_writable_iface_failed(anjay, WLAN_OBJ, true);
     }
 #endif // CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE
+    time_sync_start();
 
 #if CONFIG_ANJAY_CLIENT_LCD
 #    if defined(CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE)
@@ -684,5 +939,7 @@ void app_main(void) {
 #    endif // CONFIG_ANJAY_CLIENT_INTERFACE_BG96_MODULE
 #endif     // CONFIG_ANJAY_CLIENT_LCD
 
-    xTaskCreate(&anjay_task, "anjay_task", 16384, NULL, 5, NULL);
+    // sensors are sampled on the other core, see objects/sensors.c
+    xTaskCreatePinnedToCore(&anjay_task, "anjay_task", 16384, NULL, 5, NULL,
+                            0);
 }
@@ -22,7 +22,20 @@
 #define MAIN_NVS_WIFI_SSID_KEY "wifi_ssid"
 #define MAIN_NVS_WIFI_PASSWORD_KEY "wifi_pswd"
 #define MAIN_NVS_ENABLE_KEY "wifi_inter_en"
+#define MAIN_NVS_AIR_QUALITY_NAMESPACE "air_quality"
+// dedicated NVS partition of the Air quality state, see partitions.csv
+#define MAIN_NVS_AIR_QUALITY_PARTITION "aq_state"
+#define MAIN_NVS_AIR_QUALITY_PARTITION_SIZE 0x8000
+
+#define MAIN_SERVER_SSID 1
+
+#include <stdbool.h>
 
 void schedule_change_config(void);
+/**
+ * Returns true if the last reset kept the board powered, e.g. a software
+ * restart or a watchdog reset, so external sensors kept their state too.
+ */
+bool main_is_warm_reset(void);
 
 #endif // _MAIN_H_
@@ -0,0 +1,191 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "motion_monitor.h"
+#include "objects/mpu6886.h"
+
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+
+#    define IDLE_TIMEOUT_US \
+        (CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION_IDLE_TIMEOUT * 1000000LL)
+#    define TASK_STOP_POLL_PERIOD_MS 10
+
+static const char *TAG = "motion";
+
+static struct {
+    TaskHandle_t task;
+    volatile bool stop_requested;
+    motion_monitor_idle_cb_t *idle_cb;
+    // accessed by the motion task only
+    int64_t last_motion_us;
+
+    // written by the motion task only, under the mutex
+    pthread_mutex_t mutex;
+    bool idle;
+    int64_t idle_since_us;
+    int64_t idle_total_us;
+    uint32_t motion_events;
+} monitor = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void IRAM_ATTR motion_isr_handler(void *arg) {
+    // level triggered, re-enabled once the interrupt is cleared
+    gpio_intr_disable(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN);
+    BaseType_t task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(monitor.task, &task_woken);
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void set_idle(bool idle) {
+    if (mpu6886_set_low_power(idle)) {
+        ESP_LOGW(TAG, "MPU6886 power mode could not be changed");
+        return;
+    }
+    const int64_t now_us = esp_timer_get_time();
+    pthread_mutex_lock(&monitor.mutex);
+    monitor.idle = idle;
+    if (idle) {
+        monitor.idle_since_us = now_us;
+    } else {
+        monitor.idle_total_us += now_us - monitor.idle_since_us;
+    }
+    pthread_mutex_unlock(&monitor.mutex);
+    ESP_LOGI(TAG, idle ? "No motion, MPU6886 suspended" : "Motion detected");
+    monitor.idle_cb(idle);
+}
+
+static void handle_interrupt(void) {
+    bool motion;
+    if (mpu6886_motion_clear(&motion)) {
+        ESP_LOGW(TAG, "MPU6886 interrupt could not be cleared");
+    } else if (motion) {
+        monitor.last_motion_us = esp_timer_get_time();
+        pthread_mutex_lock(&monitor.mutex);
+        monitor.motion_events++;
+        pthread_mutex_unlock(&monitor.mutex);
+        if (monitor.idle) {
+            set_idle(false);
+        }
+    }
+    // while the device moves, the interrupt is raised at every sample
+    vTaskDelay(pdMS_TO_TICKS(MOTION_MONITOR_HOLDOFF_MS));
+    gpio_intr_enable(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN);
+}
+
+static void motion_task(void *arg) {
+    (void) arg;
+    while (!monitor.stop_requested) {
+        TickType_t timeout = portMAX_DELAY;
+        if (!monitor.idle) {
+            const int64_t remaining_us = monitor.last_motion_us
+                                         + IDLE_TIMEOUT_US
+                                         - esp_timer_get_time();
+            timeout = remaining_us > 0 ? pdMS_TO_TICKS(remaining_us / 1000)
+                                       : 0;
+        }
+        const bool notified = ulTaskNotifyTake(pdTRUE, timeout);
+        if (monitor.stop_requested) {
+            break;
+        }
+        if (notified) {
+            handle_interrupt();
+        } else if (!monitor.idle
+                   && esp_timer_get_time() - monitor.last_motion_us
+                              >= IDLE_TIMEOUT_US) {
+            set_idle(true);
+        }
+    }
+    if (monitor.idle) {
+        set_idle(false);
+    }
+    monitor.task = NULL;
+    vTaskDelete(NULL);
+}
+
+int motion_monitor_start(motion_monitor_idle_cb_t *idle_cb) {
+    assert(!monitor.task);
+    assert(idle_cb);
+
+    gpio_config_t config = {
+        .pin_bit_mask = BIT64(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_HIGH_LEVEL
+    };
+    esp_err_t err = gpio_config(&config);
+    if (!err) {
+        // may have been installed already by another user of GPIO interrupts
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;
+        }
+    }
+    if (!err) {
+        // edges are not detected in light sleep, the interrupt is latched
+        err = gpio_wakeup_enable(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN,
+                                 GPIO_INTR_HIGH_LEVEL);
+    }
+    if (!err) {
+        err = esp_sleep_enable_gpio_wakeup();
+    }
+    if (err) {
+        return -1;
+    }
+
+    monitor.stop_requested = false;
+    monitor.idle_cb = idle_cb;
+    monitor.last_motion_us = esp_timer_get_time();
+    if (xTaskCreate(&motion_task, "motion_task", 2048, NULL, 5,
+                    &monitor.task)
+            != pdPASS) {
+        return -1;
+    }
+    if (gpio_isr_handler_add(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN,
+                             motion_isr_handler, NULL)) {
+        ESP_LOGW(TAG, "MPU6886 interrupt is not available");
+        motion_monitor_stop();
+        return -1;
+    }
+    return 0;
+}
+
+void motion_monitor_stop(void) {
+    if (!monitor.task) {
+        return;
+    }
+    gpio_isr_handler_remove(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN);
+    gpio_wakeup_disable(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN);
+    monitor.stop_requested = true;
+    xTaskNotifyGive(monitor.task);
+    while (monitor.task) {
+        vTaskDelay(pdMS_TO_TICKS(TASK_STOP_POLL_PERIOD_MS));
+    }
+}
+
+void motion_monitor_get_stats(motion_monitor_stats_t *out_stats) {
+    assert(out_stats);
+
+    const int64_t now_us = esp_timer_get_time();
+    pthread_mutex_lock(&monitor.mutex);
+    int64_t idle_us = monitor.idle_total_us;
+    if (monitor.idle) {
+        idle_us += now_us - monitor.idle_since_us;
+    }
+    out_stats->idle = monitor.idle;
+    out_stats->motion_events = monitor.motion_events;
+    pthread_mutex_unlock(&monitor.mutex);
+    out_stats->idle_time_ms = idle_us / 1000;
+}
+
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
@@ -0,0 +1,48 @@
+#ifndef _MOTION_MONITOR_H_
+#define _MOTION_MONITOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+/*
+ * Suspends the motion sensors while the device does not move.
+ *
+ * The MPU6886 raises its wake-on-motion interrupt whenever acceleration
+ * changes by more than CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION_THRESHOLD. After
+ * CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION_IDLE_TIMEOUT seconds without motion, the
+ * MPU6886 is put into low power mode and its last sample is served instead
+ * of reading it; the next motion interrupt resumes normal operation. The
+ * interrupt also wakes the CPU up from automatic light sleep. Users of the
+ * motion sensors are told when the device becomes idle, so that they can
+ * stop sampling them and let the CPU sleep until motion.
+ */
+#define MOTION_MONITOR_HOLDOFF_MS 500
+
+typedef struct motion_monitor_stats_struct {
+    bool idle;
+    // times motion was detected, at most once per MOTION_MONITOR_HOLDOFF_MS
+    uint32_t motion_events;
+    // time spent idle since boot, including the current idle period
+    int64_t idle_time_ms;
+} motion_monitor_stats_t;
+
+/**
+ * Called from the motion task whenever the MPU6886 is suspended (@p idle is
+ * true) or resumed.
+ */
+typedef void motion_monitor_idle_cb_t(bool idle);
+
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+/**
+ * Starts handling the motion interrupt in a separate task. The MPU6886 has to
+ * be initialized first.
+ */
+int motion_monitor_start(motion_monitor_idle_cb_t *idle_cb);
+void motion_monitor_stop(void);
+
+void motion_monitor_get_stats(motion_monitor_stats_t *out_stats);
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+
+#endif // _MOTION_MONITOR_H_
@@ -12,18 +12,42 @@
 #include <stdbool.h>
 
 #include <anjay/anjay.h>
+#include <anjay/lwm2m_send.h>
 #include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_log.h>
 #include <avsystem/commons/avs_memory.h>
 
 #include <inttypes.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_partition.h"
+#include "nvs.h"
+#include "nvs_flash.h"
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 #    include "oled_page.h"
 #    include "pasco2.h"
 #endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+#include "change_filter.h"
+#include "co2_analytics.h"
+#include "co2_log.h"
+#include "hampel_filter.h"
+#include "main.h"
+#include "objects.h"
+#include "rolling_stats.h"
+#include "sleep_stats.h"
+#include "time_sync.h"
+#include "uplink_batch.h"
 
 #if CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR
 
+#    if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+_Static_assert(PASCO2_MIN_MEASURMENTS_PERIOD >= ROLLING_STATS_MIN_SAMPLE_WEIGHT,
+               "rolling_stats raw ring too short for the PASCO2 period");
+#    endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+
 /**
  * Air quality object ID
  */
@@ -36,6 +60,57 @@
  */
 #    define RID_CO2 17
 
+/**
+ * CO2 raw: R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Last level of carbon dioxide reported by the sensor, before outlier
+ * rejection. The CO2 resource and all statistics use the filtered value.
+ * Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_RAW 1050
+
+/**
+ * CO2 outliers: R, Single, Optional
+ * type: integer, range: N/A, unit: N/A
+ * Number of CO2 readings rejected as outliers and replaced with the median
+ * of recent readings. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_OUTLIERS 1051
+
+/**
+ * CO2 band: R, Single, Optional
+ * type: integer, range: 0..4, unit: N/A
+ * Indoor air quality class of the filtered CO2 level: good (below 800 ppm),
+ * fair (below 1000 ppm), moderate (below 1400 ppm), poor (below 2000 ppm)
+ * or bad. Every transition is also reported at once using the LwM2M Send
+ * operation. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_BAND 1060
+
+/**
+ * CO2 rate of change: R, Single, Optional
+ * type: float, range: N/A, unit: ppm/h
+ * Smoothed rate of change of the filtered CO2 level. Not part of the uCIFI
+ * object definition.
+ */
+#    define RID_CO2_RATE 1061
+
+/**
+ * CO2 rising: R, Single, Optional
+ * type: boolean, range: N/A, unit: N/A
+ * True while CO2 rises faster than CONFIG_ANJAY_CLIENT_CO2_RISE_ALERT_RATE,
+ * i.e. the room needs ventilation. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_RISING 1062
+
+/**
+ * Estimated occupancy: R, Single, Optional
+ * type: integer, range: N/A, unit: N/A
+ * Number of people in the room estimated from the CO2 level and its rate of
+ * change, see co2_analytics.h. Not part of the uCIFI object definition.
+ */
+#    define RID_ESTIMATED_OCCUPANCY 1063
+
 /**
  * CO2 1 hour average: R, Single, Optional
  * type: float, range: N/A, unit: ppm
@@ -44,17 +119,218 @@
  */
 #    define RID_CO2_1_HOUR_AVERAGE 18
 
+/**
+ * CO2 5 minutes average: R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Average level of carbon dioxide measured by the sensor during the last
+ * 5 minutes. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_5_MIN_AVERAGE 1000
+
+/**
+ * CO2 8 hours average: R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Average level of carbon dioxide measured by the sensor during the last
+ * 8 hours. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_8_HOUR_AVERAGE 1001
+
+/**
+ * CO2 24 hours average: R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Average level of carbon dioxide measured by the sensor during the last
+ * 24 hours. Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_24_HOUR_AVERAGE 1002
+
+/**
+ * CO2 minimum (5 minutes, 1 hour, 8 hours, 24 hours): R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Minimum level of carbon dioxide measured by the sensor during the
+ * respective window, since the last Reset Min and Max Measured Values.
+ * Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_5_MIN_MIN 1010
+#    define RID_CO2_1_HOUR_MIN 1011
+#    define RID_CO2_8_HOUR_MIN 1012
+#    define RID_CO2_24_HOUR_MIN 1013
+
+/**
+ * CO2 maximum (5 minutes, 1 hour, 8 hours, 24 hours): R, Single, Optional
+ * type: float, range: N/A, unit: ppm
+ * Maximum level of carbon dioxide measured by the sensor during the
+ * respective window, since the last Reset Min and Max Measured Values.
+ * Not part of the uCIFI object definition.
+ */
+#    define RID_CO2_5_MIN_MAX 1020
+#    define RID_CO2_1_HOUR_MAX 1021
+#    define RID_CO2_8_HOUR_MAX 1022
+#    define RID_CO2_24_HOUR_MAX 1023
+
+/**
+ * Reset Min and Max Measured Values: E, Single, Optional
+ * type: N/A, range: N/A, unit: N/A
+ * Reset the CO2 minimum and maximum resources of every window.
+ */
+#    define RID_RESET_MIN_AND_MAX_MEASURED_VALUES 5605
+
+/**
+ * Send CO2 history: E, Single, Optional
+ * type: N/A, range: N/A, unit: N/A
+ * Sends logged CO2, temperature and humidity samples with timestamps
+ * between argument 0 and argument 1 (Unix time, in seconds, both optional)
+ * using the LwM2M Send operation. At most CO2_HISTORY_MAX_RECORDS oldest
+ * matching samples are sent per execution. Present in the
+ * AIR_QUALITY_ONBOARD_IID instance only, as only its samples are logged. Not
+ * part of the uCIFI object definition.
+ */
+#    define RID_SEND_CO2_HISTORY 1030
+
+#    define CO2_HISTORY_MAX_RECORDS 40
+
+/**
+ * Awake time: R, Single, Optional
+ * type: float, range: N/A, unit: ms/h
+ * Average time per hour since boot the chip is not in light sleep, see
+ * sleep_stats.h. Present in the AIR_QUALITY_ONBOARD_IID instance only, as
+ * the figure is global. Not part of the uCIFI object definition.
+ */
+#    define RID_AWAKE_TIME 1040
+
+/**
+ * Wakeups: R, Single, Optional
+ * type: float, range: N/A, unit: 1/h
+ * Average number of times per hour since boot the chip is woken up from
+ * light sleep. Present in the AIR_QUALITY_ONBOARD_IID instance only. Not
+ * part of the uCIFI object definition.
+ */
+#    define RID_WAKEUPS 1041
+
+/**
+ * Acquisition bus transactions: R, Single, Optional
+ * type: float, range: N/A, unit: N/A
+ * Average number of I2C transactions per measurement cycle of the PASCO2
+ * bound to the instance, since boot. Not part of the uCIFI object
+ * definition.
+ */
+#    define RID_ACQUISITION_BUS_TRANSACTIONS 1042
+
+/**
+ * Acquisition bus time: R, Single, Optional
+ * type: float, range: N/A, unit: us
+ * Average time spent on I2C transactions per measurement cycle of the
+ * PASCO2 bound to the instance, since boot. Not part of the uCIFI object
+ * definition.
+ */
+#    define RID_ACQUISITION_BUS_TIME 1043
+
+/**
+ * Sensor Value resources of IPSO Temperature and Humidity objects, used to
+ * report logged samples of these sensors along with CO2.
+ */
+#    define OID_TEMPERATURE 3303
+#    define OID_HUMIDITY 3304
+#    define RID_SENSOR_VALUE 5700
+
+typedef enum {
+    CO2_STATS_AVG,
+    CO2_STATS_MIN,
+    CO2_STATS_MAX
+} co2_stats_kind_t;
+
+static const struct {
+    anjay_rid_t rid;
+    rolling_stats_window_t window;
+    co2_stats_kind_t kind;
+} STATS_RESOURCES[] = {
+    { RID_CO2_5_MIN_AVERAGE, ROLLING_STATS_WINDOW_5_MIN, CO2_STATS_AVG },
+    { RID_CO2_1_HOUR_AVERAGE, ROLLING_STATS_WINDOW_1_HOUR, CO2_STATS_AVG },
+    { RID_CO2_8_HOUR_AVERAGE, ROLLING_STATS_WINDOW_8_HOURS, CO2_STATS_AVG },
+    { RID_CO2_24_HOUR_AVERAGE, ROLLING_STATS_WINDOW_24_HOURS, CO2_STATS_AVG },
+    { RID_CO2_5_MIN_MIN, ROLLING_STATS_WINDOW_5_MIN, CO2_STATS_MIN },
+    { RID_CO2_1_HOUR_MIN, ROLLING_STATS_WINDOW_1_HOUR, CO2_STATS_MIN },
+    { RID_CO2_8_HOUR_MIN, ROLLING_STATS_WINDOW_8_HOURS, CO2_STATS_MIN },
+    { RID_CO2_24_HOUR_MIN, ROLLING_STATS_WINDOW_24_HOURS, CO2_STATS_MIN },
+    { RID_CO2_5_MIN_MAX, ROLLING_STATS_WINDOW_5_MIN, CO2_STATS_MAX },
+    { RID_CO2_1_HOUR_MAX, ROLLING_STATS_WINDOW_1_HOUR, CO2_STATS_MAX },
+    { RID_CO2_8_HOUR_MAX, ROLLING_STATS_WINDOW_8_HOURS, CO2_STATS_MAX },
+    { RID_CO2_24_HOUR_MAX, ROLLING_STATS_WINDOW_24_HOURS, CO2_STATS_MAX }
+};
+
+/**
+ * Changes of CO2 and its statistics smaller than this are not notified.
+ * Values are filtered in whole ppm (ppm/h for the rate).
+ */
+static const change_filter_config_t CO2_CHANGE_FILTER = {
+    .abs_deadband = 10,
+    .rel_deadband_permille = 20,
+    .min_interval = { .seconds = 5 }
+};
+
+/**
+ * Saved state older than this is not restored, as it no longer describes the
+ * air around the sensor.
+ */
+#    define STATE_MAX_AGE_S (24 * 3600)
+#    define STATE_MAGIC 0x41510001 // bump on layout change
+#    define STATE_KEY_FORMAT "state%u"
+
+/**
+ * Part of air_quality_instance_t persisted in NVS, so that outlier rejection
+ * and the rolling windows do not start from scratch after a reboot.
+ */
+typedef struct air_quality_state_struct {
+    uint32_t magic;
+    int64_t saved_at; // real time, in seconds
+    uint32_t carbon_dioxide_outliers;
+    hampel_filter_t carbon_dioxide_outlier_filter;
+    rolling_stats_snapshot_t carbon_dioxide_stats;
+} air_quality_state_t;
+
+/*
+ * The states of all instances take about 4 kB each, too much for the main
+ * NVS partition, so they are kept in a partition of their own. NVS stores
+ * data in 32 byte entries, 126 per 4 kB page, and keeps one page free for
+ * garbage collection. A blob takes its data entries, a header entry per
+ * chunk (at most one chunk per page) and an index entry; while a blob is
+ * rewritten, its old copy still takes space, and the namespace takes one more
+ * entry.
+ */
+#    define NVS_PAGE_SIZE 4096
+#    define NVS_PAGE_ENTRIES 126
+#    define NVS_ENTRY_SIZE 32
+#    define STATE_PARTITION_PAGES \
+        (MAIN_NVS_AIR_QUALITY_PARTITION_SIZE / NVS_PAGE_SIZE)
+#    define STATE_BLOB_ENTRIES                                             \
+        ((sizeof(air_quality_state_t) + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE \
+         + STATE_PARTITION_PAGES + 1)
+#    define STATE_ENTRIES                                                  \
+        ((CONFIG_ANJAY_CLIENT_AIR_QUALITY_INSTANCES + 1) * STATE_BLOB_ENTRIES \
+         + 1)
+
+_Static_assert(STATE_ENTRIES
+                       <= (STATE_PARTITION_PAGES - 1) * NVS_PAGE_ENTRIES,
+               "Air quality state partition too small for all instances");
+
 typedef struct air_quality_instance_struct {
-    uint16_t carbon_dioxide_level[CO2_NUMBER_OF_MEASURMENTS_PER_HOUR];
-    uint32_t carbon_dioxide_level_avg;
-    uint16_t current_measurment_array_field;
-    bool measurment_array_filled;
+    pasco2_t *sensor; // NULL until bound
+    hampel_filter_t carbon_dioxide_outlier_filter;
+    bool has_carbon_dioxide_raw;
+    uint16_t carbon_dioxide_raw;
+    uint32_t carbon_dioxide_outliers;
+    change_filter_t carbon_dioxide_raw_filter;
+    rolling_stats_t carbon_dioxide_stats;
+    change_filter_t carbon_dioxide_filter;
+    change_filter_t stats_filters[AVS_ARRAY_SIZE(STATS_RESOURCES)];
+    co2_analytics_t carbon_dioxide_analytics;
+    change_filter_t carbon_dioxide_rate_filter;
 } air_quality_instance_t;
 
 typedef struct air_quality_object_struct {
     const anjay_dm_object_def_t *def;
     pthread_mutex_t mutex;
-    air_quality_instance_t instances[1];
+    air_quality_instance_t instances[CONFIG_ANJAY_CLIENT_AIR_QUALITY_INSTANCES];
+    bool state_storage_ready;
 } air_quality_object_t;
 
 static inline air_quality_object_t *
@@ -70,7 +346,10 @@ static int list_instances(anjay_t *anjay,
     air_quality_object_t *obj = get_obj(obj_ptr);
     pthread_mutex_lock(&obj->mutex);
     for (anjay_iid_t iid = 0; iid < AVS_ARRAY_SIZE(obj->instances); iid++) {
-        anjay_dm_emit(ctx, iid);
+        // only bound instances ever get samples
+        if (obj->instances[iid].sensor) {
+            anjay_dm_emit(ctx, iid);
+        }
     }
     pthread_mutex_unlock(&obj->mutex);
     return 0;
@@ -81,15 +360,84 @@ static int list_resources(anjay_t *anjay,
                           anjay_iid_t iid,
                           anjay_dm_resource_list_ctx_t *ctx) {
     (void) anjay;
-    (void) obj_ptr;
-    (void) iid;
+    air_quality_object_t *obj = get_obj(obj_ptr);
+    assert(iid < AVS_ARRAY_SIZE(obj->instances));
 
     anjay_dm_emit_res(ctx, RID_CO2, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
-    anjay_dm_emit_res(ctx, RID_CO2_1_HOUR_AVERAGE, ANJAY_DM_RES_R,
+    anjay_dm_emit_res(ctx, RID_CO2_RAW, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_CO2_OUTLIERS, ANJAY_DM_RES_R,
                       ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_CO2_BAND, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_CO2_RATE, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_CO2_RISING, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_ESTIMATED_OCCUPANCY, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(STATS_RESOURCES); i++) {
+        anjay_dm_emit_res(ctx, STATS_RESOURCES[i].rid, ANJAY_DM_RES_R,
+                          ANJAY_DM_RES_PRESENT);
+    }
+    anjay_dm_emit_res(ctx, RID_RESET_MIN_AND_MAX_MEASURED_VALUES,
+                      ANJAY_DM_RES_E, ANJAY_DM_RES_PRESENT);
+    const anjay_dm_resource_presence_t onboard_presence =
+            iid == AIR_QUALITY_ONBOARD_IID ? ANJAY_DM_RES_PRESENT
+                                           : ANJAY_DM_RES_ABSENT;
+    anjay_dm_emit_res(ctx, RID_SEND_CO2_HISTORY, ANJAY_DM_RES_E,
+                      onboard_presence);
+    anjay_dm_emit_res(ctx, RID_AWAKE_TIME, ANJAY_DM_RES_R, onboard_presence);
+    anjay_dm_emit_res(ctx, RID_WAKEUPS, ANJAY_DM_RES_R, onboard_presence);
+#    if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+    pthread_mutex_lock(&obj->mutex);
+    const anjay_dm_resource_presence_t bus_stats_presence =
+            obj->instances[iid].sensor ? ANJAY_DM_RES_PRESENT
+                                       : ANJAY_DM_RES_ABSENT;
+    pthread_mutex_unlock(&obj->mutex);
+    anjay_dm_emit_res(ctx, RID_ACQUISITION_BUS_TRANSACTIONS, ANJAY_DM_RES_R,
+                      bus_stats_presence);
+    anjay_dm_emit_res(ctx, RID_ACQUISITION_BUS_TIME, ANJAY_DM_RES_R,
+                      bus_stats_presence);
+#    endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
     return 0;
 }
 
+static int get_stats_value(const rolling_stats_t *stats,
+                           rolling_stats_window_t window,
+                           co2_stats_kind_t kind,
+                           double *out_value) {
+    switch (kind) {
+    case CO2_STATS_AVG:
+        // an empty window reports 0, as the 1 hour average always did
+        *out_value = 0.0;
+        (void) rolling_stats_get_avg(stats, window, out_value);
+        return 0;
+    case CO2_STATS_MIN:
+    case CO2_STATS_MAX: {
+        uint16_t val;
+        int err = kind == CO2_STATS_MIN
+                          ? rolling_stats_get_min(stats, window, &val)
+                          : rolling_stats_get_max(stats, window, &val);
+        if (err) {
+            return -1;
+        }
+        *out_value = (double) val;
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+static int read_stats_resource(const rolling_stats_t *stats,
+                               rolling_stats_window_t window,
+                               co2_stats_kind_t kind,
+                               anjay_output_ctx_t *ctx) {
+    double value;
+    if (get_stats_value(stats, window, kind, &value)) {
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    return anjay_ret_double(ctx, value);
+}
+
 static int resource_read(anjay_t *anjay,
                          const anjay_dm_object_def_t *const *obj_ptr,
                          anjay_iid_t iid,
@@ -108,40 +456,407 @@ static int resource_read(anjay_t *anjay,
     switch (rid) {
     case RID_CO2:
         assert(riid == ANJAY_ID_INVALID);
-        if (!inst->measurment_array_filled
-                && inst->current_measurment_array_field == 0) {
+        if (rolling_stats_is_empty(&inst->carbon_dioxide_stats)) {
             result = ANJAY_ERR_METHOD_NOT_ALLOWED;
             break;
         }
-
-        size_t index = inst->current_measurment_array_field
-                               ? (inst->current_measurment_array_field - 1)
-                               : CO2_NUMBER_OF_MEASURMENTS_PER_HOUR - 1;
         result = anjay_ret_double(ctx,
-                                  (double) inst->carbon_dioxide_level[index]);
+                                  (double) rolling_stats_get_last(
+                                          &inst->carbon_dioxide_stats));
+        break;
+
+    case RID_CO2_RAW:
+        assert(riid == ANJAY_ID_INVALID);
+        if (!inst->has_carbon_dioxide_raw) {
+            result = ANJAY_ERR_METHOD_NOT_ALLOWED;
+            break;
+        }
+        result = anjay_ret_double(ctx, (double) inst->carbon_dioxide_raw);
+        break;
+
+    case RID_CO2_OUTLIERS:
+        assert(riid == ANJAY_ID_INVALID);
+        result = anjay_ret_i64(ctx, inst->carbon_dioxide_outliers);
         break;
 
-    case RID_CO2_1_HOUR_AVERAGE:
+    case RID_CO2_BAND:
+    case RID_CO2_RATE:
+    case RID_CO2_RISING:
+    case RID_ESTIMATED_OCCUPANCY: {
         assert(riid == ANJAY_ID_INVALID);
-        result = anjay_ret_double(ctx, (double) inst->carbon_dioxide_level_avg);
+        const co2_analytics_t *analytics = &inst->carbon_dioxide_analytics;
+        if (!analytics->has_last_value) {
+            result = ANJAY_ERR_METHOD_NOT_ALLOWED;
+        } else if (rid == RID_CO2_BAND) {
+            result = anjay_ret_i32(ctx, (int32_t) analytics->band);
+        } else if (rid == RID_CO2_RATE) {
+            result = anjay_ret_double(
+                    ctx, (double) co2_analytics_get_rate(analytics));
+        } else if (rid == RID_CO2_RISING) {
+            result = anjay_ret_bool(ctx, analytics->rising);
+        } else {
+            result = anjay_ret_i32(ctx, (int32_t) analytics->occupancy);
+        }
         break;
+    }
+
+    case RID_AWAKE_TIME:
+    case RID_WAKEUPS: {
+        assert(riid == ANJAY_ID_INVALID);
+        assert(iid == AIR_QUALITY_ONBOARD_IID);
+        double awake_ms_per_hour, wakeups_per_hour;
+        if (sleep_stats_get(&awake_ms_per_hour, &wakeups_per_hour)) {
+            result = ANJAY_ERR_INTERNAL;
+            break;
+        }
+        result = anjay_ret_double(ctx, rid == RID_AWAKE_TIME
+                                               ? awake_ms_per_hour
+                                               : wakeups_per_hour);
+        break;
+    }
+
+#    if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+    case RID_ACQUISITION_BUS_TRANSACTIONS:
+    case RID_ACQUISITION_BUS_TIME: {
+        assert(riid == ANJAY_ID_INVALID);
+        double transactions, bus_time_us;
+        if (!inst->sensor
+                || pasco2_get_bus_stats(inst->sensor, &transactions,
+                                        &bus_time_us)) {
+            result = ANJAY_ERR_METHOD_NOT_ALLOWED;
+            break;
+        }
+        result = anjay_ret_double(ctx, rid == RID_ACQUISITION_BUS_TIME
+                                               ? bus_time_us
+                                               : transactions);
+        break;
+    }
+#    endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
     default:
-        result = ANJAY_ERR_NOT_FOUND;
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(STATS_RESOURCES); i++) {
+            if (STATS_RESOURCES[i].rid == rid) {
+                assert(riid == ANJAY_ID_INVALID);
+                result = read_stats_resource(&inst->carbon_dioxide_stats,
+                                             STATS_RESOURCES[i].window,
+                                             STATS_RESOURCES[i].kind, ctx);
+                break;
+            }
+        }
     }
     pthread_mutex_unlock(&obj->mutex);
     return result;
 }
 
+typedef struct {
+    anjay_send_batch_builder_t *builder;
+    anjay_iid_t iid;
+    size_t count;
+} co2_history_ctx_t;
+
+static int add_history_record(const co2_log_record_t *record, void *arg) {
+    co2_history_ctx_t *ctx = (co2_history_ctx_t *) arg;
+    const avs_time_real_t timestamp =
+            avs_time_real_from_scalar(record->timestamp, AVS_TIME_S);
+
+    if (anjay_send_batch_add_double(ctx->builder, OID_AIR_QUALITY, ctx->iid,
+                                    RID_CO2, ANJAY_ID_INVALID, timestamp,
+                                    (double) record->co2)
+            || anjay_send_batch_add_double(ctx->builder, OID_TEMPERATURE, 0,
+                                           RID_SENSOR_VALUE, ANJAY_ID_INVALID,
+                                           timestamp,
+                                           record->temperature / 10.0)
+            || anjay_send_batch_add_double(ctx->builder, OID_HUMIDITY, 0,
+                                           RID_SENSOR_VALUE, ANJAY_ID_INVALID,
+                                           timestamp,
+                                           record->humidity / 10.0)) {
+        return -1;
+    }
+    return ++ctx->count >= CO2_HISTORY_MAX_RECORDS;
+}
+
+static int read_history_range(anjay_execute_ctx_t *arg_ctx,
+                              int64_t *out_from,
+                              int64_t *out_to) {
+    int arg;
+    bool has_value;
+    int result;
+
+    while (!(result = anjay_execute_get_next_arg(arg_ctx, &arg, &has_value))) {
+        char value[24];
+        if (!has_value || (arg != 0 && arg != 1)
+                || anjay_execute_get_arg_value(arg_ctx, NULL, value,
+                                               sizeof(value))) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        char *endptr = NULL;
+        long long timestamp = strtoll(value, &endptr, 10);
+        if (!*value || *endptr) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        *(arg == 0 ? out_from : out_to) = (int64_t) timestamp;
+    }
+    return result == ANJAY_EXECUTE_GET_ARG_END ? 0 : ANJAY_ERR_BAD_REQUEST;
+}
+
+static int send_co2_history(anjay_t *anjay,
+                            anjay_iid_t iid,
+                            anjay_execute_ctx_t *arg_ctx) {
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+    int result = read_history_range(arg_ctx, &from, &to);
+    if (result) {
+        return result;
+    }
+
+    co2_history_ctx_t ctx = {
+        .builder = anjay_send_batch_builder_new(),
+        .iid = iid
+    };
+    if (!ctx.builder) {
+        return ANJAY_ERR_INTERNAL;
+    }
+    if (co2_log_query(from, to, add_history_record, &ctx) < 0) {
+        anjay_send_batch_builder_cleanup(&ctx.builder);
+        return ANJAY_ERR_SERVICE_UNAVAILABLE;
+    }
+
+    anjay_send_batch_t *batch = anjay_send_batch_builder_compile(&ctx.builder);
+    if (!batch) {
+        anjay_send_batch_builder_cleanup(&ctx.builder);
+        return ANJAY_ERR_INTERNAL;
+    }
+    if (ctx.count
+            && anjay_send(anjay, MAIN_SERVER_SSID, batch, NULL, NULL)
+                           != ANJAY_SEND_OK) {
+        result = ANJAY_ERR_INTERNAL;
+    }
+    anjay_send_batch_release(&batch);
+    return result;
+}
+
+static int resource_execute(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            anjay_rid_t rid,
+                            anjay_execute_ctx_t *arg_ctx) {
+    air_quality_object_t *obj = get_obj(obj_ptr);
+    assert(obj);
+    assert(iid < AVS_ARRAY_SIZE(obj->instances));
+
+    switch (rid) {
+    case RID_RESET_MIN_AND_MAX_MEASURED_VALUES:
+        pthread_mutex_lock(&obj->mutex);
+        rolling_stats_reset_min_max(&obj->instances[iid].carbon_dioxide_stats);
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(STATS_RESOURCES); i++) {
+            if (STATS_RESOURCES[i].kind != CO2_STATS_AVG) {
+                change_filter_reset(&obj->instances[iid].stats_filters[i]);
+            }
+        }
+        pthread_mutex_unlock(&obj->mutex);
+
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(STATS_RESOURCES); i++) {
+            if (STATS_RESOURCES[i].kind != CO2_STATS_AVG) {
+                anjay_notify_changed(anjay, OID_AIR_QUALITY, iid,
+                                     STATS_RESOURCES[i].rid);
+            }
+        }
+        return 0;
+
+    case RID_SEND_CO2_HISTORY:
+        if (iid != AIR_QUALITY_ONBOARD_IID) {
+            return ANJAY_ERR_METHOD_NOT_ALLOWED;
+        }
+        return send_co2_history(anjay, iid, arg_ctx);
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
 static const anjay_dm_object_def_t OBJ_DEF = {
     .oid = OID_AIR_QUALITY,
     .handlers = {
         .list_instances = list_instances,
         .list_resources = list_resources,
         .resource_read = resource_read,
+        .resource_execute = resource_execute
     }
 };
 
+/**
+ * The state is restored only if its age is known, so that the rolling
+ * windows can be aged by the time the sensor was not sampled. It is, if the
+ * clock was set both when the state was saved and now; after a warm reset
+ * the clock keeps running, after a power loss the state is not restored, as
+ * it is too early for the clock to be set again.
+ */
+static bool get_state_age(const air_quality_state_t *state,
+                          uint32_t *out_age_s) {
+    const int64_t now = avs_time_real_now().since_real_epoch.seconds;
+    if (!time_sync_is_valid() || state->saved_at < TIME_SYNC_MIN_VALID_TIME
+            || now < state->saved_at
+            || now - state->saved_at >= STATE_MAX_AGE_S) {
+        return false;
+    }
+    *out_age_s = (uint32_t) (now - state->saved_at);
+    return true;
+}
+
+static bool is_outlier_filter_valid(const hampel_filter_t *filter) {
+    return filter->window_size == CONFIG_ANJAY_CLIENT_CO2_OUTLIER_WINDOW
+           && filter->threshold == CONFIG_ANJAY_CLIENT_CO2_OUTLIER_THRESHOLD
+           && filter->min_deviation
+                      == CONFIG_ANJAY_CLIENT_CO2_OUTLIER_MIN_DEVIATION
+           && filter->head < filter->window_size
+           && filter->count <= filter->window_size;
+}
+
+static void restore_instance_state(nvs_handle_t nvs_h,
+                                   anjay_iid_t iid,
+                                   air_quality_instance_t *inst,
+                                   air_quality_state_t *state) {
+    char key[16];
+    snprintf(key, sizeof(key), STATE_KEY_FORMAT, (unsigned) iid);
+    size_t size = sizeof(*state);
+    if (nvs_get_blob(nvs_h, key, state, &size) || size != sizeof(*state)
+            || state->magic != STATE_MAGIC) {
+        return;
+    }
+    uint32_t age_s;
+    if (!get_state_age(state, &age_s)) {
+        avs_log(air_quality, INFO,
+                "Saved state of instance %u is stale or of unknown age",
+                (unsigned) iid);
+        return;
+    }
+    if (rolling_stats_load(&inst->carbon_dioxide_stats,
+                           &state->carbon_dioxide_stats)) {
+        avs_log(air_quality, WARNING,
+                "Saved state of instance %u is corrupted", (unsigned) iid);
+        return;
+    }
+    // no samples were taken since the state was saved
+    rolling_stats_skip(&inst->carbon_dioxide_stats, age_s);
+    // filter parameters may have changed with the firmware
+    if (is_outlier_filter_valid(&state->carbon_dioxide_outlier_filter)) {
+        inst->carbon_dioxide_outlier_filter =
+                state->carbon_dioxide_outlier_filter;
+    }
+    inst->carbon_dioxide_outliers = state->carbon_dioxide_outliers;
+    avs_log(air_quality, INFO, "Restored state of instance %u",
+            (unsigned) iid);
+}
+
+static bool state_storage_init(void) {
+    const esp_partition_t *partition = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS,
+            MAIN_NVS_AIR_QUALITY_PARTITION);
+    if (!partition || partition->size < MAIN_NVS_AIR_QUALITY_PARTITION_SIZE) {
+        avs_log(air_quality, WARNING,
+                "No " MAIN_NVS_AIR_QUALITY_PARTITION
+                " partition large enough, state will not be saved");
+        return false;
+    }
+
+    esp_err_t err = nvs_flash_init_partition(MAIN_NVS_AIR_QUALITY_PARTITION);
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES
+            || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // nothing but the saved state is lost
+        err = nvs_flash_erase_partition(MAIN_NVS_AIR_QUALITY_PARTITION);
+        if (!err) {
+            err = nvs_flash_init_partition(MAIN_NVS_AIR_QUALITY_PARTITION);
+        }
+    }
+    return !err;
+}
+
+static void restore_state(air_quality_object_t *obj) {
+    nvs_handle_t nvs_h;
+    if (!obj->state_storage_ready
+            || nvs_open_from_partition(MAIN_NVS_AIR_QUALITY_PARTITION,
+                                       MAIN_NVS_AIR_QUALITY_NAMESPACE,
+                                       NVS_READONLY, &nvs_h)) {
+        return;
+    }
+    // too big for the stack of the calling task
+    air_quality_state_t *state =
+            (air_quality_state_t *) avs_malloc(sizeof(air_quality_state_t));
+    if (state) {
+        for (anjay_iid_t iid = 0; iid < AVS_ARRAY_SIZE(obj->instances);
+             iid++) {
+            restore_instance_state(nvs_h, iid, &obj->instances[iid], state);
+        }
+        avs_free(state);
+    }
+    nvs_close(nvs_h);
+}
+
+int air_quality_save_state(const anjay_dm_object_def_t *const *obj_ptr) {
+    air_quality_object_t *obj = get_obj(obj_ptr);
+    assert(obj);
+
+    if (!obj->state_storage_ready) {
+        return -1;
+    }
+    if (!time_sync_is_valid()) {
+        // a state of unknown age would never be restored
+        return 0;
+    }
+    air_quality_state_t *state =
+            (air_quality_state_t *) avs_malloc(sizeof(air_quality_state_t));
+    if (!state) {
+        return -1;
+    }
+    nvs_handle_t nvs_h;
+    if (nvs_open_from_partition(MAIN_NVS_AIR_QUALITY_PARTITION,
+                                MAIN_NVS_AIR_QUALITY_NAMESPACE, NVS_READWRITE,
+                                &nvs_h)) {
+        avs_free(state);
+        return -1;
+    }
+
+    int result = 0;
+    for (anjay_iid_t iid = 0; iid < AVS_ARRAY_SIZE(obj->instances) && !result;
+         iid++) {
+        const air_quality_instance_t *inst = &obj->instances[iid];
+        // copy under the lock, write to flash without holding it
+        pthread_mutex_lock(&obj->mutex);
+        state->magic = STATE_MAGIC;
+        state->saved_at = avs_time_real_now().since_real_epoch.seconds;
+        state->carbon_dioxide_outliers = inst->carbon_dioxide_outliers;
+        state->carbon_dioxide_outlier_filter =
+                inst->carbon_dioxide_outlier_filter;
+        rolling_stats_save(&inst->carbon_dioxide_stats,
+                           &state->carbon_dioxide_stats);
+        pthread_mutex_unlock(&obj->mutex);
+
+        char key[16];
+        snprintf(key, sizeof(key), STATE_KEY_FORMAT, (unsigned) iid);
+        result = nvs_set_blob(nvs_h, key, state, sizeof(*state)) ? -1 : 0;
+    }
+    if (!result && nvs_commit(nvs_h)) {
+        result = -1;
+    }
+    nvs_close(nvs_h);
+    avs_free(state);
+    return result;
+}
+
+int air_quality_bind_sensor(const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            pasco2_t *sensor) {
+    air_quality_object_t *obj = get_obj(obj_ptr);
+    assert(obj);
+    if (iid >= AVS_ARRAY_SIZE(obj->instances)) {
+        return -1;
+    }
+    pthread_mutex_lock(&obj->mutex);
+    obj->instances[iid].sensor = sensor;
+    pthread_mutex_unlock(&obj->mutex);
+    return 0;
+}
+
 const anjay_dm_object_def_t **air_quality_object_create(void) {
     pthread_mutexattr_t attr;
     if (pthread_mutexattr_init(&attr)) {
@@ -165,6 +880,26 @@ const anjay_dm_object_def_t **air_quality_object_create(void) {
 
     pthread_mutexattr_destroy(&attr);
 
+    for (anjay_iid_t iid = 0; iid < AVS_ARRAY_SIZE(obj->instances); iid++) {
+        air_quality_instance_t *inst = &obj->instances[iid];
+        hampel_filter_init(&inst->carbon_dioxide_outlier_filter,
+                           CONFIG_ANJAY_CLIENT_CO2_OUTLIER_WINDOW,
+                           CONFIG_ANJAY_CLIENT_CO2_OUTLIER_THRESHOLD,
+                           CONFIG_ANJAY_CLIENT_CO2_OUTLIER_MIN_DEVIATION);
+        change_filter_init(&inst->carbon_dioxide_raw_filter,
+                           &CO2_CHANGE_FILTER);
+        rolling_stats_init(&inst->carbon_dioxide_stats);
+        change_filter_init(&inst->carbon_dioxide_filter, &CO2_CHANGE_FILTER);
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(inst->stats_filters); i++) {
+            change_filter_init(&inst->stats_filters[i], &CO2_CHANGE_FILTER);
+        }
+        co2_analytics_init(&inst->carbon_dioxide_analytics);
+        change_filter_init(&inst->carbon_dioxide_rate_filter,
+                           &CO2_CHANGE_FILTER);
+    }
+
+    obj->state_storage_ready = state_storage_init();
+    restore_state(obj);
     return &obj->def;
 }
 
@@ -176,41 +911,117 @@ void air_quality_object_release(const anjay_dm_object_def_t **def) {
     }
 }
 
+static void send_band_transition(anjay_t *anjay,
+                                 anjay_iid_t iid,
+                                 avs_time_real_t timestamp,
+                                 co2_analytics_band_t band,
+                                 uint16_t co2) {
+    // Send is a confirmable request, unlike a default Notify, and it is not
+    // held back by the pmin attribute
+    anjay_send_batch_builder_t *builder = anjay_send_batch_builder_new();
+    anjay_send_batch_t *batch = NULL;
+    if (builder
+            && !anjay_send_batch_add_int(builder, OID_AIR_QUALITY, iid,
+                                         RID_CO2_BAND, ANJAY_ID_INVALID,
+                                         timestamp, (int64_t) band)
+            && !anjay_send_batch_add_double(builder, OID_AIR_QUALITY, iid,
+                                            RID_CO2, ANJAY_ID_INVALID,
+                                            timestamp, (double) co2)) {
+        batch = anjay_send_batch_builder_compile(&builder);
+    }
+    anjay_send_batch_builder_cleanup(&builder);
+    if (!batch
+            || anjay_send(anjay, MAIN_SERVER_SSID, batch, NULL, NULL)
+                           != ANJAY_SEND_OK) {
+        avs_log(air_quality, WARNING,
+                "Could not send CO2 band transition of instance %u",
+                (unsigned) iid);
+    }
+    anjay_send_batch_release(&batch);
+}
+
 void air_quality_update_measurment_val(
         const anjay_t *anjay,
         const anjay_dm_object_def_t *const *obj_ptr,
-        const uint16_t val) {
+        const anjay_iid_t iid,
+        const uint16_t val,
+        const uint16_t period,
+        const avs_time_real_t timestamp) {
     air_quality_object_t *obj = get_obj(obj_ptr);
     assert(obj);
+    if (iid >= AVS_ARRAY_SIZE(obj->instances)) {
+        return;
+    }
     pthread_mutex_lock(&obj->mutex);
-    air_quality_instance_t *inst = &obj->instances[0];
+    air_quality_instance_t *inst = &obj->instances[iid];
 
-    inst->carbon_dioxide_level[inst->current_measurment_array_field++] = val;
+    // resources are notified only when their value changed significantly
+    anjay_rid_t changed[AVS_ARRAY_SIZE(STATS_RESOURCES) + 7];
+    size_t changed_count = 0;
 
-    if (!(inst->current_measurment_array_field %=
-          CO2_NUMBER_OF_MEASURMENTS_PER_HOUR)) {
-        inst->measurment_array_filled =
-                true; // the entire table is filled with measurements
+    inst->has_carbon_dioxide_raw = true;
+    inst->carbon_dioxide_raw = val;
+    if (change_filter_update(&inst->carbon_dioxide_raw_filter, val)) {
+        changed[changed_count++] = RID_CO2_RAW;
     }
 
-    inst->carbon_dioxide_level_avg = 0;
-    for (uint32_t meas = 0U;
-         meas < (inst->measurment_array_filled
-                         ? CO2_NUMBER_OF_MEASURMENTS_PER_HOUR
-                         : inst->current_measurment_array_field);
-         meas++) {
-        inst->carbon_dioxide_level_avg += inst->carbon_dioxide_level[meas];
+    bool is_outlier;
+    const uint16_t filtered =
+            hampel_filter_update(&inst->carbon_dioxide_outlier_filter, val,
+                                 &is_outlier);
+    if (is_outlier) {
+        inst->carbon_dioxide_outliers++;
+        changed[changed_count++] = RID_CO2_OUTLIERS;
     }
-    inst->carbon_dioxide_level_avg /=
-            (inst->measurment_array_filled
-                     ? CO2_NUMBER_OF_MEASURMENTS_PER_HOUR
-                     : inst->current_measurment_array_field);
+    rolling_stats_add(&inst->carbon_dioxide_stats, filtered, period);
 
-    anjay_notify_changed((anjay_t *) anjay, OID_AIR_QUALITY, 0, RID_CO2);
+    // observers are served even if samples are also reported in batches
+    if (change_filter_update(&inst->carbon_dioxide_filter, filtered)) {
+        changed[changed_count++] = RID_CO2;
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(STATS_RESOURCES); i++) {
+        double value;
+        if (!get_stats_value(&inst->carbon_dioxide_stats,
+                             STATS_RESOURCES[i].window, STATS_RESOURCES[i].kind,
+                             &value)
+                && change_filter_update(&inst->stats_filters[i],
+                                        (int32_t) lround(value))) {
+            changed[changed_count++] = STATS_RESOURCES[i].rid;
+        }
+    }
 
-    anjay_notify_changed((anjay_t *) anjay, OID_AIR_QUALITY, 0,
-                         RID_CO2_1_HOUR_AVERAGE);
+    co2_analytics_t *analytics = &inst->carbon_dioxide_analytics;
+    const int analytics_changed =
+            co2_analytics_update(analytics, filtered, period);
+    const co2_analytics_band_t band = analytics->band;
+    if (analytics_changed & CO2_ANALYTICS_BAND_CHANGED) {
+        changed[changed_count++] = RID_CO2_BAND;
+    }
+    if (analytics_changed & CO2_ANALYTICS_RISING_CHANGED) {
+        changed[changed_count++] = RID_CO2_RISING;
+    }
+    if (analytics_changed & CO2_ANALYTICS_OCCUPANCY_CHANGED) {
+        changed[changed_count++] = RID_ESTIMATED_OCCUPANCY;
+    }
+    if (change_filter_update(&inst->carbon_dioxide_rate_filter,
+                             co2_analytics_get_rate(analytics))) {
+        changed[changed_count++] = RID_CO2_RATE;
+    }
     pthread_mutex_unlock(&obj->mutex);
+
+    if (analytics_changed & CO2_ANALYTICS_BAND_CHANGED) {
+        send_band_transition((anjay_t *) anjay, iid, timestamp, band,
+                             filtered);
+    }
+
+#    if CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE > 0
+    // raw samples are reported in batches, see uplink_batch.h
+    uplink_batch_add(OID_AIR_QUALITY, iid, RID_CO2, timestamp, filtered);
+#    endif // CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE > 0
+    for (size_t i = 0; i < changed_count; i++) {
+        anjay_notify_changed((anjay_t *) anjay, OID_AIR_QUALITY, iid,
+                             changed[i]);
+    }
 }
 
 #else // ANJAY_CLIENT_AIR_QUALITY_SENSOR
@@ -223,13 +1034,33 @@ void air_quality_object_release(const anjay_dm_object_def_t **def) {
     (void) def;
 }
 
+int air_quality_bind_sensor(const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            pasco2_t *sensor) {
+    (void) obj_ptr;
+    (void) iid;
+    (void) sensor;
+    return -1;
+}
+
 void air_quality_update_measurment_val(
         const anjay_t *anjay,
         const anjay_dm_object_def_t *const *obj_ptr,
-        const uint16_t val) {
+        const anjay_iid_t iid,
+        const uint16_t val,
+        const uint16_t period,
+        const avs_time_real_t timestamp) {
     (void) anjay;
     (void) obj_ptr;
+    (void) iid;
     (void) val;
+    (void) period;
+    (void) timestamp;
+}
+
+int air_quality_save_state(const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) obj_ptr;
+    return -1;
 }
 
 #endif // ANJAY_CLIENT_AIR_QUALITY_SENSOR
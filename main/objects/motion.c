@@ -0,0 +1,179 @@
+/**
+ * LwM2M Object: Motion
+ * ID: 26242, Single
+ *
+ * Wake-on-motion state of the accelerometer and counters quantifying the
+ * sensor reads and wakeups saved while the device did not move. Object ID
+ * from the range of objects not registered with OMNA.
+ */
+#include <assert.h>
+#include <stdbool.h>
+
+#include <anjay/anjay.h>
+#include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_memory.h>
+
+#include "motion_monitor.h"
+#include "mpu6886.h"
+#include "objects.h"
+
+/**
+ * Idle: R, Single, Mandatory
+ * type: boolean, range: N/A, unit: N/A
+ * True while no motion was detected for the configured idle timeout and the
+ * motion sensors are suspended.
+ */
+#define RID_IDLE 0
+
+/**
+ * Motion events: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of times motion was detected since boot, at most twice a second.
+ */
+#define RID_MOTION_EVENTS 1
+
+/**
+ * Idle time: R, Single, Mandatory
+ * type: float, range: N/A, unit: s
+ * Time spent idle since boot, including the current idle period.
+ */
+#define RID_IDLE_TIME 2
+
+/**
+ * Suspended reads: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of motion sensor reads served from the last sample, without waking
+ * up the sensor, since boot.
+ */
+#define RID_SUSPENDED_READS 3
+
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+
+#    define MOTION_IID 0
+
+typedef struct motion_object_struct {
+    const anjay_dm_object_def_t *def;
+
+    bool idle_last;
+} motion_object_t;
+
+static inline motion_object_t *
+get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
+    assert(obj_ptr);
+    return AVS_CONTAINER_OF(obj_ptr, motion_object_t, def);
+}
+
+static int list_resources(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+
+    anjay_dm_emit_res(ctx, RID_IDLE, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_MOTION_EVENTS, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_IDLE_TIME, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_SUSPENDED_READS, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int resource_read(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr,
+                         anjay_iid_t iid,
+                         anjay_rid_t rid,
+                         anjay_riid_t riid,
+                         anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) riid;
+
+    assert(iid == MOTION_IID);
+
+    motion_monitor_stats_t stats;
+    motion_monitor_get_stats(&stats);
+
+    switch (rid) {
+    case RID_IDLE:
+        return anjay_ret_bool(ctx, stats.idle);
+
+    case RID_MOTION_EVENTS:
+        return anjay_ret_i64(ctx, stats.motion_events);
+
+    case RID_IDLE_TIME:
+        return anjay_ret_double(ctx, stats.idle_time_ms / 1000.0);
+
+    case RID_SUSPENDED_READS:
+        return anjay_ret_i64(ctx, mpu6886_get_suspended_reads());
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static const anjay_dm_object_def_t OBJ_DEF = {
+    .oid = 26242,
+    .handlers = {
+        .list_instances = anjay_dm_list_instances_SINGLE,
+        .list_resources = list_resources,
+        .resource_read = resource_read
+    }
+};
+
+const anjay_dm_object_def_t **motion_object_create(void) {
+    motion_object_t *obj =
+            (motion_object_t *) avs_calloc(1, sizeof(motion_object_t));
+    if (!obj) {
+        return NULL;
+    }
+    obj->def = &OBJ_DEF;
+    return &obj->def;
+}
+
+void motion_object_release(const anjay_dm_object_def_t **def) {
+    if (def) {
+        avs_free(get_obj(def));
+    }
+}
+
+void motion_object_update(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *def) {
+    if (!anjay || !def) {
+        return;
+    }
+
+    motion_object_t *obj = get_obj(def);
+
+    // counters change continuously, they are notified along with the state
+    motion_monitor_stats_t stats;
+    motion_monitor_get_stats(&stats);
+    if (stats.idle != obj->idle_last) {
+        obj->idle_last = stats.idle;
+        (void) anjay_notify_changed(anjay, obj->def->oid, MOTION_IID,
+                                    RID_IDLE);
+        (void) anjay_notify_changed(anjay, obj->def->oid, MOTION_IID,
+                                    RID_MOTION_EVENTS);
+        (void) anjay_notify_changed(anjay, obj->def->oid, MOTION_IID,
+                                    RID_IDLE_TIME);
+        (void) anjay_notify_changed(anjay, obj->def->oid, MOTION_IID,
+                                    RID_SUSPENDED_READS);
+    }
+}
+#else  // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+const anjay_dm_object_def_t **motion_object_create(void) {
+    return NULL;
+}
+
+void motion_object_release(const anjay_dm_object_def_t **def) {
+    (void) def;
+}
+
+void motion_object_update(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *def) {
+    (void) anjay;
+    (void) def;
+}
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
@@ -21,15 +21,21 @@
  *  - I2C driver for ESP-IDF:
  *    https://gist.github.com/code0100fun/9e5335e9a36a3db9bd45453d77b336e4
  */
+#include <assert.h>
+#include <stdatomic.h>
+
 #include "mpu6886.h"
 #include "driver/gpio.h"
 #include "driver/i2c.h"
 #include "esp_err.h"
+#include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "i2c_wrapper.h"
 #include "objects.h"
 #include "sdkconfig.h"
+#include "sensor_cache.h"
+#include "seqlock.h"
 #include "stdbool.h"
 #include "stdint.h"
 
@@ -39,19 +45,27 @@
 #    define I2C_SDA_PIN (21)
 #    define I2C_SCL_PIN (22)
 #    define I2C_CLOCK_SPEED_HZ (400000)
-#    define I2C_TIMEOUT_MS (10)
-#    define I2C_TIMEOUT_TICKS (I2C_TIMEOUT_MS / portTICK_PERIOD_MS)
+// time given to the sensor to apply each configuration register
+#    define CONFIG_DELAY_TICKS (10 / portTICK_PERIOD_MS)
+
+static const char *TAG = "mpu6886";
 
 /*
  * MPU6886 registers addresses.
  *  - see datasheet, Table 15. MPU-6886 Register Map
  */
+#    define MPU6886_REG_ADDR_SMPLRT_DIV (0x19)
 #    define MPU6886_REG_ADDR_CONFIG (0x1A)
 #    define MPU6886_REG_ADDR_GYRO_CONFIG (0x1B)
 #    define MPU6886_REG_ADDR_ACCEL_CONFIG (0x1C)
 #    define MPU6886_REG_ADDR_ACCEL_CONFIG2 (0x1D)
+#    define MPU6886_REG_ADDR_ACCEL_WOM_X_THR (0x20)
+#    define MPU6886_REG_ADDR_ACCEL_WOM_Y_THR (0x21)
+#    define MPU6886_REG_ADDR_ACCEL_WOM_Z_THR (0x22)
+#    define MPU6886_REG_ADDR_FIFO_EN (0x23)
 #    define MPU6886_REG_ADDR_INTERRUPT_PIN (0x37)
 #    define MPU6886_REG_ADDR_INTERRUPT_ENABLE (0x38)
+#    define MPU6886_REG_ADDR_INTERRUPT_STATUS (0x3A)
 #    define MPU6886_REG_ADDR_ACCEL_XOUT_H (0x3B)
 #    define MPU6886_REG_ADDR_ACCEL_XOUT_L (0x3C)
 #    define MPU6886_REG_ADDR_ACCEL_YOUT_H (0x3D)
@@ -66,8 +80,14 @@
 #    define MPU6886_REG_ADDR_GYRO_YOUT_L (0x46)
 #    define MPU6886_REG_ADDR_GYRO_ZOUT_H (0x47)
 #    define MPU6886_REG_ADDR_GYRO_ZOUT_L (0x48)
+#    define MPU6886_REG_ADDR_FIFO_WM_TH1 (0x60)
+#    define MPU6886_REG_ADDR_FIFO_WM_TH2 (0x61)
+#    define MPU6886_REG_ADDR_ACCEL_INTEL_CTRL (0x69)
+#    define MPU6886_REG_ADDR_USER_CTRL (0x6A)
 #    define MPU6886_REG_ADDR_PWR_MGMT_1 (0x6B)
 #    define MPU6886_REG_ADDR_PWR_MGMT_2 (0x6C)
+#    define MPU6886_REG_ADDR_FIFO_COUNTH (0x72)
+#    define MPU6886_REG_ADDR_FIFO_R_W (0x74)
 #    define MPU6886_REG_ADDR_WHO_AM_I (0x75)
 
 /*
@@ -86,6 +106,41 @@
 #    define MPU6886_REG_PWR_MGMT_2_EN_ALL (0x00)
 #    define MPU6886_REG_WHO_AM_I_VAL (0x19)
 #    define MPU6886_REG_PWR_MGMT_1_AUTO_SELECT_CLOCK (0x01)
+#    define MPU6886_REG_CONFIG_FIFO_MODE_STOP_WHEN_FULL (0x40)
+#    define MPU6886_REG_FIFO_EN_ACCEL_AND_GYRO (0x18)
+#    define MPU6886_REG_INTERRUPT_ENABLE_FIFO_OFLOW (0x10)
+#    define MPU6886_REG_INTERRUPT_STATUS_FIFO_OFLOW (0x10)
+#    define MPU6886_REG_INTERRUPT_PIN_LATCH (0x20)
+#    define MPU6886_REG_INTERRUPT_ENABLE_WOM_XYZ (0xE0)
+#    define MPU6886_REG_INTERRUPT_STATUS_WOM_XYZ (0xE0)
+#    define MPU6886_REG_ACCEL_INTEL_CTRL_COMPARE_PREVIOUS (0xC0)
+#    define MPU6886_REG_PWR_MGMT_1_CYCLE (0x20)
+#    define MPU6886_REG_PWR_MGMT_2_GYRO_STANDBY (0x07)
+#    define MPU6886_REG_USER_CTRL_FIFO_EN (0x40)
+#    define MPU6886_REG_USER_CTRL_FIFO_RST (0x04)
+#    define MPU6886_REG_FIFO_COUNTH_MASK (0x1F)
+
+/*
+ * With both accelerometer and gyroscope enabled, every FIFO packet holds
+ * accelerometer, temperature and gyroscope outputs, like the data registers.
+ */
+#    define MPU6886_FIFO_PACKET_SIZE (14)
+// sample rate with the digital low pass filter enabled
+#    define MPU6886_INTERNAL_SAMPLE_RATE_HZ (1000)
+#    define MPU6886_DLPF_CFG_MIN (1)
+#    define MPU6886_DLPF_CFG_MAX (6)
+
+/*
+ * Accelerometer 3 dB bandwidth for each A_DLPF_CFG value, in Hz; gyroscope
+ * bandwidths for the same DLPF_CFG values are similar.
+ *  - see datasheet, Chapter 8. Register Descriptions, ACCEL_CONFIG2
+ */
+static const uint16_t DLPF_BANDWIDTH_HZ[] = { 218, 218, 99, 45, 21, 10, 5 };
+
+// wake-on-motion threshold resolution
+#    define MPU6886_WOM_THRESHOLD_MG_PER_LSB (4)
+// accelerometer sample rate in low power mode: 1 kHz / (1 + divider)
+#    define MPU6886_LOW_POWER_SMPLRT_DIV (39)
 
 /*
  * MPU6886 LSB output to real unit scaling factors.
@@ -100,27 +155,50 @@
 #    define TEMPERATURE_ZERO_LSB_OFFSET (25.0)
 
 /*
- * Macros for data structures access control
- * Mutexes guarantee datasets consistence
+ * Samples are converted to sensor_value_t thousandths by multiplying by these
+ * factors, in Q16 fixed point; they are computed at compile time, so no
+ * floating point arithmetic is done at run time.
  */
-#    define MUTEX_LOCK(struct) ((struct) .mutex = true)
-#    define MUTEX_UNLOCK(struct) ((struct) .mutex = false)
-#    define MUTEX_IS_LOCKED(struct) ((struct) .mutex)
+#    define Q16_FACTOR(Factor) ((int32_t) ((Factor) * 65536.0 + 0.5))
+#    define ACCELEROMETER_FACTOR_Q16                     \
+        Q16_FACTOR(SENSOR_VALUE_SCALE * GRAVITY_CONSTANT \
+                   / ACCELEROMETER_LSB_TO_G_FACTOR_2G)
+#    define GYROSCOPE_FACTOR_Q16 \
+        Q16_FACTOR(SENSOR_VALUE_SCALE / GYROSCOPE_LSB_TO_DPS_FACTOR_500DPS)
+#    define TEMPERATURE_FACTOR_Q16 \
+        Q16_FACTOR(SENSOR_VALUE_SCALE / TEMPERATURE_LSB_TO_C_FACTOR)
+#    define TEMPERATURE_OFFSET \
+        ((sensor_value_t) (TEMPERATURE_ZERO_LSB_OFFSET * SENSOR_VALUE_SCALE))
 
-typedef struct mems_sensor_data_struct {
-    double x_value;
-    double y_value;
-    double z_value;
-    bool mutex;
-} mems_sensor_data_t;
+/*
+ * Accelerometer, temperature and gyroscope outputs are adjacent, so all of
+ * them are read in a single transaction and come from the same instant.
+ */
+#    define MPU6886_DATA_SIZE (14)
+#    define MPU6886_DATA_ACCEL_OFFSET (0)
+#    define MPU6886_DATA_TEMP_OFFSET (6)
+#    define MPU6886_DATA_GYRO_OFFSET (8)
+
+typedef struct mpu6886_data_struct {
+    three_axis_sensor_data_t accelerometer;
+    three_axis_sensor_data_t gyroscope;
+    sensor_value_t temperature;
+} mpu6886_data_t;
 
-typedef struct temperature_sensor_data_struct {
-    double value;
-    bool mutex;
-} temperature_sensor_data_t;
+/*
+ * Last sample. It is published only by mpu6886_read_data(), which the sensor
+ * cache never runs concurrently; readers never block, so they may run at any
+ * rate and in any task.
+ */
+static struct {
+    seqlock_t lock;
+    mpu6886_data_t copies[2];
+    atomic_bool valid;
+} mpu6886_data;
 
-static mems_sensor_data_t accelerometer_data, gyroscope_data;
-static temperature_sensor_data_t temperature_sensor_data;
+// set while the sensor is in low power mode
+static atomic_bool low_power;
+static atomic_uint suspended_reads;
 
 static i2c_device_t mpu6886_device = {
     .config = {
@@ -135,102 +213,242 @@ static i2c_device_t mpu6886_device = {
     .address = I2C_MPU6886_ADDRESS
 };
 
-int accelerometer_read_data(void) {
-    uint8_t acc[6];
-    if ((i2c_master_read_slave_reg(&mpu6886_device,
-                                   MPU6886_REG_ADDR_ACCEL_XOUT_H, acc, 6)
-         == ESP_OK)
-            || !MUTEX_IS_LOCKED(accelerometer_data)) {
-        MUTEX_LOCK(accelerometer_data);
-        accelerometer_data.x_value =
-                ((double) (int16_t) ((acc[0] << 8) | acc[1]))
-                / ACCELEROMETER_LSB_TO_G_FACTOR_2G * GRAVITY_CONSTANT;
-        accelerometer_data.y_value =
-                ((double) (int16_t) ((acc[2] << 8) | acc[3]))
-                / ACCELEROMETER_LSB_TO_G_FACTOR_2G * GRAVITY_CONSTANT;
-        accelerometer_data.z_value =
-                ((double) (int16_t) ((acc[4] << 8) | acc[5]))
-                / ACCELEROMETER_LSB_TO_G_FACTOR_2G * GRAVITY_CONSTANT;
-        MUTEX_UNLOCK(accelerometer_data);
-        return 0;
-    } else {
+static int16_t get_be16(const uint8_t *data) {
+    return (int16_t) ((data[0] << 8) | data[1]);
+}
+
+// in 64 bits, as the product may overflow 32 bits; rounded to nearest
+static sensor_value_t scale_q16(int16_t raw, int32_t factor_q16) {
+    return (sensor_value_t) (((int64_t) raw * factor_q16 + (1 << 15)) >> 16);
+}
+
+static void decode_three_axis(const uint8_t *data,
+                              int32_t factor_q16,
+                              three_axis_sensor_data_t *out_data) {
+    out_data->x_value = scale_q16(get_be16(&data[0]), factor_q16);
+    out_data->y_value = scale_q16(get_be16(&data[2]), factor_q16);
+    out_data->z_value = scale_q16(get_be16(&data[4]), factor_q16);
+}
+
+static int sensor_read_data(void) {
+    uint8_t raw[MPU6886_DATA_SIZE];
+    if (i2c_master_read_slave_reg(&mpu6886_device,
+                                  MPU6886_REG_ADDR_ACCEL_XOUT_H, raw,
+                                  sizeof(raw))) {
         return -1;
     }
+    mpu6886_data_t data;
+    decode_three_axis(&raw[MPU6886_DATA_ACCEL_OFFSET], ACCELEROMETER_FACTOR_Q16,
+                      &data.accelerometer);
+    decode_three_axis(&raw[MPU6886_DATA_GYRO_OFFSET], GYROSCOPE_FACTOR_Q16,
+                      &data.gyroscope);
+    data.temperature = scale_q16(get_be16(&raw[MPU6886_DATA_TEMP_OFFSET]),
+                                 TEMPERATURE_FACTOR_Q16)
+                       + TEMPERATURE_OFFSET;
+    seqlock_write(&mpu6886_data.lock, mpu6886_data.copies, &data,
+                  sizeof(data));
+    atomic_store_explicit(&mpu6886_data.valid, true, memory_order_release);
+    return 0;
 }
 
-int accelerometer_get_data(three_axis_sensor_data_t *sensor_data) {
-    if (!MUTEX_IS_LOCKED(accelerometer_data)) {
-        MUTEX_LOCK(accelerometer_data);
-        sensor_data->x_value = accelerometer_data.x_value;
-        sensor_data->y_value = accelerometer_data.y_value;
-        sensor_data->z_value = accelerometer_data.z_value;
-        MUTEX_UNLOCK(accelerometer_data);
-        return 0;
-    } else {
+static int sensor_get_data(mpu6886_data_t *sensor_data) {
+    if (!atomic_load_explicit(&mpu6886_data.valid, memory_order_acquire)) {
         return -1;
     }
+    seqlock_read(&mpu6886_data.lock, mpu6886_data.copies, sensor_data,
+                 sizeof(*sensor_data));
+    return 0;
 }
 
-int temperature_read_data(void) {
-    uint8_t temp[2];
-    if ((i2c_master_read_slave_reg(&mpu6886_device, MPU6886_REG_ADDR_TEMP_OUT_H,
-                                   temp, 2)
-         == ESP_OK)
-            || !MUTEX_IS_LOCKED(temperature_sensor_data)) {
-        MUTEX_LOCK(temperature_sensor_data);
-        temperature_sensor_data.value =
-                ((double) ((int16_t) ((temp[0] << 8) | temp[1]))
-                 / TEMPERATURE_LSB_TO_C_FACTOR)
-                + TEMPERATURE_ZERO_LSB_OFFSET;
-        MUTEX_UNLOCK(temperature_sensor_data);
-        return 0;
-    } else {
+int mpu6886_read_data(sensor_value_t *out_values) {
+    mpu6886_data_t data;
+    if (atomic_load(&low_power)) {
+        // the sensor does not move, the last sample is still accurate
+        atomic_fetch_add(&suspended_reads, 1);
+    } else if (sensor_read_data()) {
+        return -1;
+    }
+    if (sensor_get_data(&data)) {
         return -1;
     }
+    out_values[SENSOR_CACHE_MPU6886_ACCEL_X] = data.accelerometer.x_value;
+    out_values[SENSOR_CACHE_MPU6886_ACCEL_Y] = data.accelerometer.y_value;
+    out_values[SENSOR_CACHE_MPU6886_ACCEL_Z] = data.accelerometer.z_value;
+    out_values[SENSOR_CACHE_MPU6886_GYRO_X] = data.gyroscope.x_value;
+    out_values[SENSOR_CACHE_MPU6886_GYRO_Y] = data.gyroscope.y_value;
+    out_values[SENSOR_CACHE_MPU6886_GYRO_Z] = data.gyroscope.z_value;
+    out_values[SENSOR_CACHE_MPU6886_TEMPERATURE] = data.temperature;
+    return 0;
 }
 
-int temperature_get_data(double *sensor_data) {
-    if (!MUTEX_IS_LOCKED(temperature_sensor_data)) {
-        MUTEX_LOCK(temperature_sensor_data);
-        *sensor_data = temperature_sensor_data.value;
-        MUTEX_UNLOCK(temperature_sensor_data);
-        return 0;
-    } else {
+static int write_reg(uint8_t reg, uint8_t value) {
+    return i2c_master_write_slave_reg(&mpu6886_device, reg, &value, 1);
+}
+
+int mpu6886_fifo_start(uint16_t sample_rate_hz,
+                       uint16_t watermark,
+                       uint16_t *out_sample_rate_hz) {
+    assert(sample_rate_hz > 0
+           && sample_rate_hz <= MPU6886_INTERNAL_SAMPLE_RATE_HZ);
+    assert(out_sample_rate_hz);
+
+    const uint8_t divider =
+            MPU6886_INTERNAL_SAMPLE_RATE_HZ / sample_rate_hz - 1;
+    const uint16_t rate = MPU6886_INTERNAL_SAMPLE_RATE_HZ / (divider + 1);
+    // the widest filter whose bandwidth ends below the Nyquist frequency,
+    // so that vibrations above it do not alias
+    uint8_t dlpf = MPU6886_DLPF_CFG_MIN;
+    while (dlpf < MPU6886_DLPF_CFG_MAX && DLPF_BANDWIDTH_HZ[dlpf] * 2 > rate) {
+        dlpf++;
+    }
+    const uint16_t threshold = watermark * MPU6886_FIFO_PACKET_SIZE;
+
+    // when full, the FIFO stops accepting packets, so that it never holds a
+    // partially overwritten one
+    if (write_reg(MPU6886_REG_ADDR_USER_CTRL, 0)
+            || write_reg(MPU6886_REG_ADDR_SMPLRT_DIV, divider)
+            || write_reg(MPU6886_REG_ADDR_CONFIG,
+                         MPU6886_REG_CONFIG_FIFO_MODE_STOP_WHEN_FULL | dlpf)
+            || write_reg(MPU6886_REG_ADDR_ACCEL_CONFIG2, dlpf)
+            || write_reg(MPU6886_REG_ADDR_FIFO_WM_TH1, threshold >> 8)
+            || write_reg(MPU6886_REG_ADDR_FIFO_WM_TH2, threshold & 0xFF)
+            || write_reg(MPU6886_REG_ADDR_FIFO_EN,
+                         MPU6886_REG_FIFO_EN_ACCEL_AND_GYRO)
+            || write_reg(MPU6886_REG_ADDR_INTERRUPT_ENABLE,
+                         MPU6886_REG_INTERRUPT_ENABLE_FIFO_OFLOW)
+            || write_reg(MPU6886_REG_ADDR_USER_CTRL,
+                         MPU6886_REG_USER_CTRL_FIFO_RST)
+            || write_reg(MPU6886_REG_ADDR_USER_CTRL,
+                         MPU6886_REG_USER_CTRL_FIFO_EN)) {
         return -1;
     }
+    *out_sample_rate_hz = rate;
+    return 0;
 }
 
-int gyroscope_read_data(void) {
-    uint8_t dps[6];
-    if ((i2c_master_read_slave_reg(&mpu6886_device,
-                                   MPU6886_REG_ADDR_GYRO_XOUT_H, dps, 6)
-         == ESP_OK)
-            || !MUTEX_IS_LOCKED(gyroscope_data)) {
-        MUTEX_LOCK(gyroscope_data);
-        gyroscope_data.x_value = ((double) (int16_t) ((dps[0] << 8) | dps[1]))
-                                 / GYROSCOPE_LSB_TO_DPS_FACTOR_500DPS;
-        gyroscope_data.y_value = ((double) (int16_t) ((dps[2] << 8) | dps[3]))
-                                 / GYROSCOPE_LSB_TO_DPS_FACTOR_500DPS;
-        gyroscope_data.z_value = ((double) (int16_t) ((dps[4] << 8) | dps[5]))
-                                 / GYROSCOPE_LSB_TO_DPS_FACTOR_500DPS;
-        MUTEX_UNLOCK(gyroscope_data);
+void mpu6886_fifo_stop(void) {
+    if (write_reg(MPU6886_REG_ADDR_USER_CTRL, 0)
+            || write_reg(MPU6886_REG_ADDR_FIFO_EN, 0)
+            || write_reg(MPU6886_REG_ADDR_INTERRUPT_ENABLE, 0)
+            || write_reg(MPU6886_REG_ADDR_FIFO_WM_TH1, 0)
+            || write_reg(MPU6886_REG_ADDR_FIFO_WM_TH2, 0)
+            || write_reg(MPU6886_REG_ADDR_CONFIG, MPU6886_REG_CONFIG_DEFAULT)
+            || write_reg(MPU6886_REG_ADDR_SMPLRT_DIV, 0)) {
+        ESP_LOGW(TAG, "MPU6886 FIFO could not be disabled");
+    }
+}
+
+int mpu6886_fifo_read(int16_t (*out_accel)[3],
+                      size_t max_samples,
+                      size_t *out_count,
+                      bool *out_overflow) {
+    assert(out_accel);
+    assert(max_samples <= MPU6886_FIFO_MAX_BURST);
+    assert(out_count);
+    assert(out_overflow);
+
+    *out_count = 0;
+    *out_overflow = false;
+
+    // reading the interrupt status clears it
+    uint8_t status;
+    if (i2c_master_read_slave_reg(&mpu6886_device,
+                                  MPU6886_REG_ADDR_INTERRUPT_STATUS, &status,
+                                  1)) {
+        return -1;
+    }
+    if (status & MPU6886_REG_INTERRUPT_STATUS_FIFO_OFLOW) {
+        *out_overflow = true;
+        return write_reg(MPU6886_REG_ADDR_USER_CTRL,
+                         MPU6886_REG_USER_CTRL_FIFO_EN
+                                 | MPU6886_REG_USER_CTRL_FIFO_RST);
+    }
+
+    uint8_t count[2];
+    if (i2c_master_read_slave_reg(&mpu6886_device,
+                                  MPU6886_REG_ADDR_FIFO_COUNTH, count, 2)) {
+        return -1;
+    }
+    size_t samples =
+            (((count[0] & MPU6886_REG_FIFO_COUNTH_MASK) << 8) | count[1])
+            / MPU6886_FIFO_PACKET_SIZE;
+    if (samples > max_samples) {
+        samples = max_samples;
+    }
+    if (!samples) {
         return 0;
-    } else {
+    }
+
+    uint8_t data[MPU6886_FIFO_MAX_BURST * MPU6886_FIFO_PACKET_SIZE];
+    if (i2c_master_read_slave_reg(&mpu6886_device, MPU6886_REG_ADDR_FIFO_R_W,
+                                  data,
+                                  samples * MPU6886_FIFO_PACKET_SIZE)) {
         return -1;
     }
+    for (size_t i = 0; i < samples; i++) {
+        const uint8_t *packet = &data[i * MPU6886_FIFO_PACKET_SIZE];
+        for (int axis = 0; axis < 3; axis++) {
+            out_accel[i][axis] =
+                    get_be16(&packet[MPU6886_DATA_ACCEL_OFFSET + 2 * axis]);
+        }
+    }
+    *out_count = samples;
+    return 0;
 }
 
-int gyroscope_get_data(three_axis_sensor_data_t *sensor_data) {
-    if (!MUTEX_IS_LOCKED(gyroscope_data)) {
-        MUTEX_LOCK(gyroscope_data);
-        sensor_data->x_value = gyroscope_data.x_value;
-        sensor_data->y_value = gyroscope_data.y_value;
-        sensor_data->z_value = gyroscope_data.z_value;
-        MUTEX_UNLOCK(gyroscope_data);
-        return 0;
-    } else {
+int mpu6886_motion_interrupt_enable(uint16_t threshold_mg) {
+    uint16_t threshold = threshold_mg / MPU6886_WOM_THRESHOLD_MG_PER_LSB;
+    if (threshold > UINT8_MAX) {
+        threshold = UINT8_MAX;
+    }
+    // the interrupt is latched, so that it is still pending once the CPU
+    // wakes up from light sleep, in which GPIO edges are not detected
+    if (write_reg(MPU6886_REG_ADDR_INTERRUPT_PIN,
+                  MPU6886_REG_INTERRUPT_PIN_LATCH)
+            || write_reg(MPU6886_REG_ADDR_ACCEL_WOM_X_THR, threshold)
+            || write_reg(MPU6886_REG_ADDR_ACCEL_WOM_Y_THR, threshold)
+            || write_reg(MPU6886_REG_ADDR_ACCEL_WOM_Z_THR, threshold)
+            || write_reg(MPU6886_REG_ADDR_ACCEL_INTEL_CTRL,
+                         MPU6886_REG_ACCEL_INTEL_CTRL_COMPARE_PREVIOUS)
+            || write_reg(MPU6886_REG_ADDR_INTERRUPT_ENABLE,
+                         MPU6886_REG_INTERRUPT_ENABLE_WOM_XYZ)) {
         return -1;
     }
+    return 0;
+}
+
+int mpu6886_motion_clear(bool *out_motion) {
+    assert(out_motion);
+
+    // reading the interrupt status clears it and releases the pin
+    uint8_t status;
+    if (i2c_master_read_slave_reg(&mpu6886_device,
+                                  MPU6886_REG_ADDR_INTERRUPT_STATUS, &status,
+                                  1)) {
+        return -1;
+    }
+    *out_motion = status & MPU6886_REG_INTERRUPT_STATUS_WOM_XYZ;
+    return 0;
+}
+
+int mpu6886_set_low_power(bool enable) {
+    const uint8_t divider = enable ? MPU6886_LOW_POWER_SMPLRT_DIV : 0;
+    const uint8_t pwr_mgmt_1 =
+            MPU6886_REG_PWR_MGMT_1_AUTO_SELECT_CLOCK
+            | (enable ? MPU6886_REG_PWR_MGMT_1_CYCLE : 0);
+    const uint8_t pwr_mgmt_2 = enable ? MPU6886_REG_PWR_MGMT_2_GYRO_STANDBY
+                                      : MPU6886_REG_PWR_MGMT_2_EN_ALL;
+    if (write_reg(MPU6886_REG_ADDR_SMPLRT_DIV, divider)
+            || write_reg(MPU6886_REG_ADDR_PWR_MGMT_2, pwr_mgmt_2)
+            || write_reg(MPU6886_REG_ADDR_PWR_MGMT_1, pwr_mgmt_1)) {
+        return -1;
+    }
+    atomic_store(&low_power, enable);
+    return 0;
+}
+
+uint32_t mpu6886_get_suspended_reads(void) {
+    return atomic_load(&suspended_reads);
 }
 
 int mpu6886_device_init(void) {
@@ -243,44 +461,46 @@ int mpu6886_device_init(void) {
         return -1;
     }
 
-    if (i2c_master_write_slave_reg(&mpu6886_device, MPU6886_REG_ADDR_CONFIG,
-                                   MPU6886_REG_CONFIG_DEFAULT)) {
+    if (write_reg(MPU6886_REG_ADDR_CONFIG, MPU6886_REG_CONFIG_DEFAULT)) {
         return -1;
     }
-    vTaskDelay(I2C_TIMEOUT_TICKS);
+    vTaskDelay(CONFIG_DELAY_TICKS);
 
-    if (i2c_master_write_slave_reg(&mpu6886_device,
-                                   MPU6886_REG_ADDR_ACCEL_CONFIG,
-                                   MPU6886_REG_ACCEL_CONFIG_FS_2G)) {
+    if (write_reg(MPU6886_REG_ADDR_ACCEL_CONFIG,
+                  MPU6886_REG_ACCEL_CONFIG_FS_2G)) {
         return -1;
     }
-    vTaskDelay(I2C_TIMEOUT_TICKS);
+    vTaskDelay(CONFIG_DELAY_TICKS);
 
-    if (i2c_master_write_slave_reg(&mpu6886_device,
-                                   MPU6886_REG_ADDR_GYRO_CONFIG,
-                                   MPU6886_REG_GYRO_CONFIG_FS_500DPS)) {
+    if (write_reg(MPU6886_REG_ADDR_GYRO_CONFIG,
+                  MPU6886_REG_GYRO_CONFIG_FS_500DPS)) {
         return -1;
     }
-    vTaskDelay(I2C_TIMEOUT_TICKS);
+    vTaskDelay(CONFIG_DELAY_TICKS);
 
-    if (i2c_master_write_slave_reg(&mpu6886_device, MPU6886_REG_ADDR_PWR_MGMT_2,
-                                   MPU6886_REG_PWR_MGMT_2_EN_ALL)) {
+    if (write_reg(MPU6886_REG_ADDR_PWR_MGMT_2, MPU6886_REG_PWR_MGMT_2_EN_ALL)) {
         return -1;
     }
-    vTaskDelay(I2C_TIMEOUT_TICKS);
+    vTaskDelay(CONFIG_DELAY_TICKS);
 
-    if (i2c_master_write_slave_reg(&mpu6886_device, MPU6886_REG_ADDR_PWR_MGMT_1,
-                                   MPU6886_REG_PWR_MGMT_1_AUTO_SELECT_CLOCK)) {
+    if (write_reg(MPU6886_REG_ADDR_PWR_MGMT_1,
+                  MPU6886_REG_PWR_MGMT_1_AUTO_SELECT_CLOCK)) {
         return -1;
     }
+    atomic_store(&low_power, false);
 
-    MUTEX_UNLOCK(accelerometer_data);
-    MUTEX_UNLOCK(gyroscope_data);
-    MUTEX_UNLOCK(temperature_sensor_data);
+#    if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+    vTaskDelay(CONFIG_DELAY_TICKS);
+    if (mpu6886_motion_interrupt_enable(
+                CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION_THRESHOLD)) {
+        return -1;
+    }
+#    endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
     return 0;
 }
 
 void mpu6886_driver_release(void) {
+    atomic_store(&mpu6886_data.valid, false);
     i2c_driver_delete(I2C_MASTER_PORT);
 }
 
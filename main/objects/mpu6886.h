@@ -16,6 +16,10 @@
 #ifndef _MPU6886_H_
 #define _MPU6886_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "objects.h"
 #include "sdkconfig.h"
 
@@ -25,14 +29,61 @@
 #    define ACCELEROMETER_RANGE (2.0)
 #    define GYROSCOPE_RANGE (500.0)
 
-int accelerometer_read_data(void);
-int gyroscope_read_data(void);
-int temperature_read_data(void);
+/**
+ * Reads all values of the sensor, indexed by SENSOR_CACHE_MPU6886_*, in
+ * thousandths of m/s2, deg/s and Cel.
+ */
+int mpu6886_read_data(sensor_value_t *out_values);
+
+// samples read from the FIFO in a single transaction at most
+#    define MPU6886_FIFO_MAX_BURST (18)
 
-int accelerometer_get_data(three_axis_sensor_data_t *sensor_data);
-int gyroscope_get_data(three_axis_sensor_data_t *sensor_data);
-int temperature_get_data(double *sensor_data);
+/**
+ * Starts putting samples into the FIFO at @p sample_rate_hz, rounded to
+ * 1 kHz divided by an integer, and sets @p out_sample_rate_hz to the actual
+ * rate. The interrupt pin is pulsed whenever the FIFO holds at least
+ * @p watermark samples.
+ */
+int mpu6886_fifo_start(uint16_t sample_rate_hz,
+                       uint16_t watermark,
+                       uint16_t *out_sample_rate_hz);
+void mpu6886_fifo_stop(void);
+/**
+ * Takes up to @p max_samples accelerometer samples, in LSB, out of the FIFO.
+ * If the FIFO has overflown, it is emptied, @p out_overflow is set and no
+ * samples are returned, as samples around the gap are lost.
+ */
+int mpu6886_fifo_read(int16_t (*out_accel)[3],
+                      size_t max_samples,
+                      size_t *out_count,
+                      bool *out_overflow);
 
+/**
+ * Makes the interrupt pin go high whenever acceleration along any axis
+ * changes by more than @p threshold_mg between consecutive samples. The pin
+ * stays high until mpu6886_motion_clear() is called.
+ */
+int mpu6886_motion_interrupt_enable(uint16_t threshold_mg);
+/**
+ * Releases the interrupt pin; @p out_motion is set if motion was detected
+ * since the previous call.
+ */
+int mpu6886_motion_clear(bool *out_motion);
+/**
+ * In low power mode the gyroscope is off and the accelerometer is sampled
+ * just often enough to detect motion. mpu6886_read_data() does not access the
+ * bus then; it returns the last sample read before entering low power mode.
+ */
+int mpu6886_set_low_power(bool enable);
+/**
+ * Number of mpu6886_read_data() calls served in low power mode.
+ */
+uint32_t mpu6886_get_suspended_reads(void);
+
+/**
+ * Configures the sensor; with CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION, also
+ * enables the motion interrupt.
+ */
 int mpu6886_device_init(void);
 void mpu6886_driver_release(void);
 
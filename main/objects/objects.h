@@ -19,10 +19,14 @@
 #include "esp_wifi.h"
 #include <anjay/dm.h>
 
+#include "pasco2.h"
+#include "sensor_value.h"
+#include "window_stats.h"
+
 typedef struct three_axis_sensor_data_struct {
-    double x_value;
-    double y_value;
-    double z_value;
+    sensor_value_t x_value;
+    sensor_value_t y_value;
+    sensor_value_t z_value;
 } three_axis_sensor_data_t;
 
 typedef enum {
@@ -64,14 +68,76 @@ void wlan_object_set_writable_iface_failed(
         const anjay_dm_object_def_t *const *obj_ptr,
         bool val);
 
+/**
+ * Installs the IPSO sensor objects and starts sampling every sensor with its
+ * own period in a dedicated task, until sensors_stop() is called.
+ */
 void sensors_install(anjay_t *anjay);
+/**
+ * Notifies the samples published by the sampling task and adapts sampling
+ * periods to the observations. Must be called periodically from the Anjay
+ * thread.
+ */
 void sensors_update(anjay_t *anjay);
+void sensors_stop(void);
 void sensors_release(void);
 void sensors_read_data(void);
 
+#define SENSORS_STATS_MAX_AXES 3
+
+typedef struct sensors_stats_struct {
+    anjay_oid_t oid; // of the IPSO object of the sensor
+    uint8_t axis_count;
+    // number of complete windows, since sensors_install()
+    uint32_t windows;
+    // of the last complete window, in the order of the IPSO value resources
+    window_stats_t axes[SENSORS_STATS_MAX_AXES];
+} sensors_stats_t;
+
+/**
+ * Number of sensors whose samples are aggregated over windows of
+ * CONFIG_ANJAY_CLIENT_SENSOR_STATS_WINDOW seconds, indexed from 0.
+ */
+int sensors_stats_count(void);
+int sensors_get_stats(int index, sensors_stats_t *out_stats);
+
+const anjay_dm_object_def_t **vibration_object_create(void);
+void vibration_object_release(const anjay_dm_object_def_t **def);
+void vibration_object_update(anjay_t *anjay,
+                             const anjay_dm_object_def_t *const *def);
+
+const anjay_dm_object_def_t **motion_object_create(void);
+void motion_object_release(const anjay_dm_object_def_t **def);
+void motion_object_update(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *def);
+
+const anjay_dm_object_def_t **sensor_stats_object_create(void);
+void sensor_stats_object_release(const anjay_dm_object_def_t **def);
+void sensor_stats_object_update(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *def);
+
+const anjay_dm_object_def_t **shtc3_profile_object_create(void);
+void shtc3_profile_object_release(const anjay_dm_object_def_t **def);
+
+// instance bound to the PASCO2 mounted on the board, whose samples are logged
+#define AIR_QUALITY_ONBOARD_IID 0
+
 const anjay_dm_object_def_t **air_quality_object_create(void);
 void air_quality_object_release(const anjay_dm_object_def_t **def);
+/**
+ * Makes instance @p iid, fed by @p sensor, present, with the bus statistics
+ * of the sensor. Samples of the sensor are still passed to
+ * air_quality_update_measurment_val(). Has to be called before the client
+ * registers, as the new instance is not notified.
+ */
+int air_quality_bind_sensor(const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            pasco2_t *sensor);
 void air_quality_update_measurment_val(
         const anjay_t *anjay,
         const anjay_dm_object_def_t *const *obj_ptr,
-        const uint16_t val);
+        const anjay_iid_t iid,
+        const uint16_t val,
+        const uint16_t period,
+        const avs_time_real_t timestamp);
+int air_quality_save_state(const anjay_dm_object_def_t *const *obj_ptr);
@@ -0,0 +1,249 @@
+/**
+ * LwM2M Object: Sensor statistics
+ * ID: 26243, Multiple
+ *
+ * Statistics of the samples of the IPSO sensors, computed on the device over
+ * consecutive windows, so that the server does not have to poll the sensors
+ * at a high rate to learn about their variability. Instance IDs follow the
+ * order of sensors in sensors.c; the Sensor resource tells which one an
+ * instance describes. Object ID from the range of objects not registered with
+ * OMNA.
+ */
+#include <assert.h>
+#include <stdbool.h>
+
+#include <anjay/anjay.h>
+#include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_memory.h>
+
+#include "objects.h"
+#include "sdkconfig.h"
+#include "window_stats.h"
+
+/**
+ * Sensor: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Object ID of the IPSO sensor object, whose instance 0 is described.
+ */
+#define RID_SENSOR 0
+
+/**
+ * Window: R, Single, Mandatory
+ * type: integer, range: N/A, unit: s
+ * Length of the windows the statistics are computed over.
+ */
+#define RID_WINDOW 1
+
+/**
+ * Windows: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of windows completed since boot; the remaining resources describe
+ * the last one.
+ */
+#define RID_WINDOWS 2
+
+/**
+ * Sample count: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of samples taken during the last window, which depends on how
+ * often the sensor is sampled.
+ */
+#define RID_SAMPLE_COUNT 3
+
+/**
+ * Mean: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: unit of the sensor
+ * Mean of the samples of the last window. Resource Instance IDs 0, 1 and 2
+ * stand for X, Y and Z axis of 3D sensors; other sensors have instance 0 only.
+ * Absent until a window with samples completes.
+ */
+#define RID_MEAN 4
+
+/**
+ * Standard deviation: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: unit of the sensor
+ * Population standard deviation of the samples of the last window, per axis.
+ */
+#define RID_STANDARD_DEVIATION 5
+
+typedef struct sensor_stats_object_struct {
+    const anjay_dm_object_def_t *def;
+
+    int instance_count;
+    uint32_t windows_last[]; // per instance
+} sensor_stats_object_t;
+
+static inline sensor_stats_object_t *
+get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
+    assert(obj_ptr);
+    return AVS_CONTAINER_OF(obj_ptr, sensor_stats_object_t, def);
+}
+
+static int list_instances(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+
+    sensor_stats_object_t *obj = get_obj(obj_ptr);
+    for (anjay_iid_t iid = 0; iid < obj->instance_count; iid++) {
+        anjay_dm_emit(ctx, iid);
+    }
+    return 0;
+}
+
+static int list_resources(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+
+    anjay_dm_emit_res(ctx, RID_SENSOR, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_WINDOW, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_WINDOWS, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_SAMPLE_COUNT, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_MEAN, ANJAY_DM_RES_RM, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_STANDARD_DEVIATION, ANJAY_DM_RES_RM,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int read_axis_resource(const sensors_stats_t *stats,
+                              anjay_rid_t rid,
+                              anjay_riid_t riid,
+                              anjay_output_ctx_t *ctx) {
+    if (riid >= stats->axis_count) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    // there is nothing to describe before a window with samples completes
+    const window_stats_t *axis = &stats->axes[riid];
+    if (!stats->windows || !axis->count) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    return anjay_ret_double(ctx, rid == RID_MEAN ? window_stats_mean(axis)
+                                                 : window_stats_stddev(axis));
+}
+
+static int resource_read(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr,
+                         anjay_iid_t iid,
+                         anjay_rid_t rid,
+                         anjay_riid_t riid,
+                         anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    sensors_stats_t stats;
+    if (sensors_get_stats(iid, &stats)) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+
+    switch (rid) {
+    case RID_SENSOR:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i32(ctx, stats.oid);
+
+    case RID_WINDOW:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i32(ctx, CONFIG_ANJAY_CLIENT_SENSOR_STATS_WINDOW);
+
+    case RID_WINDOWS:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i64(ctx, stats.windows);
+
+    case RID_SAMPLE_COUNT:
+        assert(riid == ANJAY_ID_INVALID);
+        // all axes are sampled together
+        return anjay_ret_i64(ctx, stats.axes[0].count);
+
+    case RID_MEAN:
+    case RID_STANDARD_DEVIATION:
+        return read_axis_resource(&stats, rid, riid, ctx);
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static int list_resource_instances(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_rid_t rid,
+                                   anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    if (rid != RID_MEAN && rid != RID_STANDARD_DEVIATION) {
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    sensors_stats_t stats;
+    if (sensors_get_stats(iid, &stats)) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    for (anjay_riid_t axis = 0; axis < stats.axis_count; axis++) {
+        // absent, like in read_axis_resource(), until there is a window
+        if (stats.windows && stats.axes[axis].count) {
+            anjay_dm_emit(ctx, axis);
+        }
+    }
+    return 0;
+}
+
+static const anjay_dm_object_def_t OBJ_DEF = {
+    .oid = 26243,
+    .handlers = {
+        .list_instances = list_instances,
+        .list_resources = list_resources,
+        .resource_read = resource_read,
+        .list_resource_instances = list_resource_instances
+    }
+};
+
+const anjay_dm_object_def_t **sensor_stats_object_create(void) {
+    const int instance_count = sensors_stats_count();
+    if (!instance_count) {
+        return NULL;
+    }
+    sensor_stats_object_t *obj = (sensor_stats_object_t *) avs_calloc(
+            1, sizeof(sensor_stats_object_t)
+                       + instance_count * sizeof(uint32_t));
+    if (!obj) {
+        return NULL;
+    }
+    obj->def = &OBJ_DEF;
+    obj->instance_count = instance_count;
+    return &obj->def;
+}
+
+void sensor_stats_object_release(const anjay_dm_object_def_t **def) {
+    if (def) {
+        avs_free(get_obj(def));
+    }
+}
+
+void sensor_stats_object_update(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *def) {
+    if (!anjay || !def) {
+        return;
+    }
+
+    sensor_stats_object_t *obj = get_obj(def);
+    for (anjay_iid_t iid = 0; iid < obj->instance_count; iid++) {
+        sensors_stats_t stats;
+        if (sensors_get_stats(iid, &stats)
+                || stats.windows == obj->windows_last[iid]) {
+            continue;
+        }
+        obj->windows_last[iid] = stats.windows;
+
+        // statistics change with every window
+        (void) anjay_notify_changed(anjay, obj->def->oid, iid, RID_WINDOWS);
+        (void) anjay_notify_changed(anjay, obj->def->oid, iid,
+                                    RID_SAMPLE_COUNT);
+        (void) anjay_notify_changed(anjay, obj->def->oid, iid, RID_MEAN);
+        (void) anjay_notify_changed(anjay, obj->def->oid, iid,
+                                    RID_STANDARD_DEVIATION);
+    }
+}
@@ -15,8 +15,15 @@
  */
 
 #include <assert.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
 #include <anjay/anjay.h>
 #include <anjay/ipso_objects.h>
 
@@ -25,21 +32,101 @@
 #include <avsystem/commons/avs_log.h>
 #include <avsystem/commons/avs_memory.h>
 
+#include "change_filter.h"
+#include "deadline_heap.h"
+#include "derived_metrics.h"
+#include "latency_histogram.h"
+#include "motion_monitor.h"
 #include "mpu6886.h"
 #include "objects/objects.h"
+#include "sample_path_benchmark.h"
 #include "sdkconfig.h"
+#include "sensor_cache.h"
+#include "seqlock.h"
+#include "vibration_monitor.h"
+#include "window_stats.h"
+
+// sensor values are not notified more often than this
+#define SENSORS_NOTIFY_MIN_INTERVAL \
+    { .seconds = 5 }
+
+/*
+ * Every sensor is sampled with its own period, adapted to the observe
+ * attributes of its value resources:
+ * - sensors nobody observes are sampled at least every
+ *   SENSORS_UNOBSERVED_PERIOD_MS, to keep the values read by the server fresh,
+ * - sampling more often than pmin is pointless, as changes cannot be notified
+ *   sooner anyway,
+ * - but at least every epmax, which is how often the server asked for the
+ *   value to be evaluated,
+ * - sensors fed by the same device share the shortest of their periods.
+ * With CONFIG_ANJAY_CLIENT_SENSOR_STATS_FULL_RATE, sensors are never sampled
+ * less often than their base period, for the sake of the statistics.
+ */
+#define SENSORS_UNOBSERVED_PERIOD_MS 30000
+#define SENSORS_MIN_PERIOD_MS 100
+#define SENSORS_MAX_PERIOD_MS 3600000
+
+/*
+ * Sensors are sampled by a task of their own, so that a slow or stuck bus
+ * never delays the Anjay thread. It runs on the core Anjay does not use.
+ */
+#if CONFIG_FREERTOS_UNICORE
+#    define ACQUISITION_TASK_CORE 0
+#else // CONFIG_FREERTOS_UNICORE
+#    define ACQUISITION_TASK_CORE 1
+#endif // CONFIG_FREERTOS_UNICORE
+#define ACQUISITION_TASK_STOP_POLL_PERIOD_MS 10
 
-#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
-#    include "shtc3.h"
-#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+// how often latency statistics are logged
+#define SENSORS_LATENCY_LOG_PERIOD \
+    { .seconds = 600 }
+
+#define SENSORS_STATS_WINDOW \
+    { .seconds = CONFIG_ANJAY_CLIENT_SENSOR_STATS_WINDOW }
+
+#define RID_SENSOR_VALUE 5700
+#define RID_X_VALUE 5702
+#define RID_Y_VALUE 5703
+#define RID_Z_VALUE 5704
+
+/*
+ * Aggregation of all samples of a sensor, not only those that passed the
+ * change filter, over consecutive windows of SENSORS_STATS_WINDOW. A window
+ * is closed by the first sample taken after its end.
+ */
+typedef struct {
+    // accessed by the acquisition task only
+    sensors_stats_t current;
+    avs_time_monotonic_t end;
+
+    // last complete window, published by the task
+    seqlock_t lock;
+    sensors_stats_t complete[2];
+} sensor_window_t;
 
 typedef struct {
     const char *name;
     const char *unit;
     anjay_oid_t oid;
-    double data;
-    int (*read_data)(void);
-    int (*get_data)(double *sensor_data);
+    change_filter_config_t filter_config;
+    sensor_cache_device_t device;
+    uint8_t value_index;
+    uint32_t period_ms; // sampling period, if observed without attributes
+
+    // accessed by the acquisition task only
+    change_filter_t filter;
+    avs_time_monotonic_t last_deadline;
+
+    // last value that passed the change filter, published by the task
+    seqlock_t lock;
+    sensor_value_t values[2];
+    atomic_bool changed;
+
+    // set by sensors_update() on the Anjay thread
+    atomic_uint sampling_period_ms;
+
+    sensor_window_t window;
 } basic_sensor_context_t;
 
 typedef struct {
@@ -48,11 +135,27 @@ typedef struct {
     anjay_oid_t oid;
     double min_value;
     double max_value;
-    three_axis_sensor_data_t data;
-    int (*read_data)(void);
-    int (*get_data)(three_axis_sensor_data_t *sensor_data);
+    change_filter_config_t filter_config;
+    sensor_cache_device_t device;
+    uint8_t value_index; // of the X axis, followed by Y and Z
+    uint32_t period_ms;  // sampling period, if observed without attributes
+
+    // accessed by the acquisition task only
+    change_filter_t filters[3];
+    avs_time_monotonic_t last_deadline;
+
+    // last value that passed the change filter, published by the task
+    seqlock_t lock;
+    three_axis_sensor_data_t values[2];
+    atomic_bool changed;
+
+    // set by sensors_update() on the Anjay thread
+    atomic_uint sampling_period_ms;
+
+    sensor_window_t window;
 } three_axis_sensor_context_t;
 
+// samples and deadbands are sensor_value_t thousandths of the unit
 static three_axis_sensor_context_t THREE_AXIS_SENSORS_DEF[] = {
 #ifdef CONFIG_ANJAY_CLIENT_ACCELEROMETER_AVAILABLE
     {
@@ -61,8 +164,13 @@ static three_axis_sensor_context_t THREE_AXIS_SENSORS_DEF[] = {
         .oid = 3313,
         .min_value = (-1.0) * ACCELEROMETER_RANGE * GRAVITY_CONSTANT,
         .max_value = ACCELEROMETER_RANGE * GRAVITY_CONSTANT,
-        .read_data = accelerometer_read_data,
-        .get_data = accelerometer_get_data,
+        .filter_config = {
+            .abs_deadband = 500,
+            .min_interval = SENSORS_NOTIFY_MIN_INTERVAL
+        },
+        .device = SENSOR_CACHE_DEVICE_MPU6886,
+        .value_index = SENSOR_CACHE_MPU6886_ACCEL_X,
+        .period_ms = 1000
     },
 #endif // CONFIG_ANJAY_CLIENT_ACCELEROMETER_AVAILABLE
 #ifdef CONFIG_ANJAY_CLIENT_GYROSCOPE_AVAILABLE
@@ -72,8 +180,13 @@ static three_axis_sensor_context_t THREE_AXIS_SENSORS_DEF[] = {
         .oid = 3334,
         .min_value = (-1.0) * GYROSCOPE_RANGE,
         .max_value = GYROSCOPE_RANGE,
-        .read_data = gyroscope_read_data,
-        .get_data = gyroscope_get_data,
+        .filter_config = {
+            .abs_deadband = 5000,
+            .min_interval = SENSORS_NOTIFY_MIN_INTERVAL
+        },
+        .device = SENSOR_CACHE_DEVICE_MPU6886,
+        .value_index = SENSOR_CACHE_MPU6886_GYRO_X,
+        .period_ms = 1000
     },
 #endif // CONFIG_ANJAY_CLIENT_GYROSCOPE_AVAILABLE
 };
@@ -84,8 +197,18 @@ static basic_sensor_context_t BASIC_SENSORS_DEF[] = {
         .name = "Temperature sensor",
         .unit = "Cel",
         .oid = 3303,
-        .read_data = temperature_read_data,
-        .get_data = temperature_get_data,
+        .filter_config = {
+            .abs_deadband = 200,
+            .min_interval = SENSORS_NOTIFY_MIN_INTERVAL
+        },
+#    if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+        .device = SENSOR_CACHE_DEVICE_SHTC3,
+        .value_index = SENSOR_CACHE_SHTC3_TEMPERATURE,
+#    else  // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+        .device = SENSOR_CACHE_DEVICE_MPU6886,
+        .value_index = SENSOR_CACHE_MPU6886_TEMPERATURE,
+#    endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+        .period_ms = 5000
     },
 #endif // CONFIG_ANJAY_CLIENT_TEMPERATURE_SENSOR_AVAILABLE
 #ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
@@ -93,25 +216,143 @@ static basic_sensor_context_t BASIC_SENSORS_DEF[] = {
         .name = "Humidity sensor",
         .unit = "%",
         .oid = 3304,
-        .read_data = humidity_read_data,
-        .get_data = humidity_get_data,
+        .filter_config = {
+            .abs_deadband = 1000,
+            .min_interval = SENSORS_NOTIFY_MIN_INTERVAL
+        },
+        .device = SENSOR_CACHE_DEVICE_SHTC3,
+        .value_index = SENSOR_CACHE_SHTC3_HUMIDITY,
+        .period_ms = 5000
     },
 #endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
 };
 
+/*
+ * All sensors fed by the same device share its sample in the sensor cache,
+ * so the device is read at most once per update.
+ */
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+/**
+ * Metrics derived from the SHTC3 sample, as instances of the IPSO Generic
+ * Sensor object, in this order. The IPSO object caches their values and
+ * serves reads from that cache; they are computed when the instances are
+ * added and, later on, only when temperature or humidity changed
+ * significantly.
+ */
+#    define OID_GENERIC_SENSOR 3300
+// sampling period of the SHTC3, if a derived value is observed
+#    define DERIVED_SENSORS_PERIOD_MS 5000
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    float (*compute)(float temp, float humi);
+} derived_sensor_def_t;
+
+static const derived_sensor_def_t DERIVED_SENSORS_DEF[] = {
+    {
+        .name = "Dew point",
+        .unit = "Cel",
+        .compute = derived_metrics_dew_point
+    },
+    {
+        .name = "Absolute humidity",
+        .unit = "g/m3",
+        .compute = derived_metrics_absolute_humidity
+    },
+    {
+        .name = "Heat index",
+        .unit = "Cel",
+        .compute = derived_metrics_heat_index
+    }
+};
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+#define BASIC_SENSORS_COUNT ((int) AVS_ARRAY_SIZE(BASIC_SENSORS_DEF))
+#define SENSORS_COUNT \
+    (BASIC_SENSORS_COUNT + (int) AVS_ARRAY_SIZE(THREE_AXIS_SENSORS_DEF))
+
+_Static_assert(SENSORS_COUNT <= DEADLINE_HEAP_CAPACITY,
+               "DEADLINE_HEAP_CAPACITY too small for all sensors");
+
+static struct {
+    TaskHandle_t task;
+    volatile bool stop_requested;
+    // set when sampling periods changed and the deadlines must be rebuilt
+    atomic_bool periods_changed;
+    // MPU6886 sensors have no deadlines while the device does not move
+    atomic_bool motion_idle;
+    /*
+     * Deadlines of the next sample of every sensor, accessed by the task
+     * only; ids below BASIC_SENSORS_COUNT index BASIC_SENSORS_DEF, the rest
+     * THREE_AXIS_SENSORS_DEF.
+     */
+    deadline_heap_t deadlines;
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    // temperature and humidity the derived sensors are computed from
+    seqlock_t shtc3_lock;
+    sensor_value_t shtc3_values[2][2];
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+    /*
+     * time spent getting a sample from the sensor cache, including the bus
+     * transactions of the device if the cached sample was stale
+     */
+    latency_histogram_t sample_latency;
+    // time spent in the value callbacks of the IPSO objects
+    latency_histogram_t callback_latency;
+    // accessed by the Anjay thread only
+    avs_time_monotonic_t next_latency_log;
+} acquisition;
+
+static uint32_t elapsed_us(int64_t since_us) {
+    return (uint32_t) (esp_timer_get_time() - since_us);
+}
+
+static int basic_sensor_sample(basic_sensor_context_t *ctx,
+                               sensor_value_t *out_value) {
+    const int64_t start_us = esp_timer_get_time();
+    const int result = sensor_cache_get(ctx->device, ctx->value_index, 1,
+                                        out_value, NULL);
+    latency_histogram_record(&acquisition.sample_latency,
+                             elapsed_us(start_us));
+    return result;
+}
+
+static int three_axis_sensor_sample(three_axis_sensor_context_t *ctx,
+                                    three_axis_sensor_data_t *out_value) {
+    const int64_t start_us = esp_timer_get_time();
+    sensor_value_t values[3];
+    const int result = sensor_cache_get(ctx->device, ctx->value_index,
+                                        AVS_ARRAY_SIZE(values), values, NULL);
+    latency_histogram_record(&acquisition.sample_latency,
+                             elapsed_us(start_us));
+    if (result) {
+        return -1;
+    }
+    out_value->x_value = values[0];
+    out_value->y_value = values[1];
+    out_value->z_value = values[2];
+    return 0;
+}
+
+/*
+ * Values are sampled by the acquisition task; the IPSO objects only see
+ * samples that passed the change filter, so reading them never touches a bus.
+ * This is the only place where they are converted to floating point.
+ */
 int basic_sensor_get_value(anjay_iid_t iid, void *_ctx, double *value) {
     basic_sensor_context_t *ctx = (basic_sensor_context_t *) _ctx;
 
-    assert(ctx->read_data);
-    assert(ctx->get_data);
     assert(value);
 
-    if (!ctx->read_data() && !ctx->get_data(&ctx->data)) {
-        *value = ctx->data;
-        return 0;
-    } else {
-        return -1;
-    }
+    const int64_t start_us = esp_timer_get_time();
+    sensor_value_t sample;
+    seqlock_read(&ctx->lock, ctx->values, &sample, sizeof(sample));
+    *value = SENSOR_VALUE_TO_DOUBLE(sample);
+    latency_histogram_record(&acquisition.callback_latency,
+                             elapsed_us(start_us));
+    return 0;
 }
 
 int three_axis_sensor_get_values(anjay_iid_t iid,
@@ -121,21 +362,518 @@ int three_axis_sensor_get_values(anjay_iid_t iid,
                                  double *z_value) {
     three_axis_sensor_context_t *ctx = (three_axis_sensor_context_t *) _ctx;
 
-    assert(ctx->read_data);
-    assert(ctx->get_data);
     assert(x_value);
     assert(y_value);
     assert(z_value);
 
-    if (!ctx->read_data() && !ctx->get_data(&ctx->data)) {
-        *x_value = ctx->data.x_value;
-        *y_value = ctx->data.y_value;
-        *z_value = ctx->data.z_value;
-        return 0;
-    } else {
-        return -1;
+    const int64_t start_us = esp_timer_get_time();
+    three_axis_sensor_data_t value;
+    seqlock_read(&ctx->lock, ctx->values, &value, sizeof(value));
+    *x_value = SENSOR_VALUE_TO_DOUBLE(value.x_value);
+    *y_value = SENSOR_VALUE_TO_DOUBLE(value.y_value);
+    *z_value = SENSOR_VALUE_TO_DOUBLE(value.z_value);
+    latency_histogram_record(&acquisition.callback_latency,
+                             elapsed_us(start_us));
+    return 0;
+}
+
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+static int
+derived_sensor_get_value(anjay_iid_t iid, void *_ctx, double *value) {
+    const derived_sensor_def_t *def = (const derived_sensor_def_t *) _ctx;
+
+    assert(value);
+
+    const int64_t start_us = esp_timer_get_time();
+    sensor_value_t values[2];
+    seqlock_read(&acquisition.shtc3_lock, acquisition.shtc3_values, values,
+                 sizeof(values));
+    // single precision is done by the FPU
+    *value = def->compute(
+            SENSOR_VALUE_TO_FLOAT(values[SENSOR_CACHE_SHTC3_TEMPERATURE]),
+            SENSOR_VALUE_TO_FLOAT(values[SENSOR_CACHE_SHTC3_HUMIDITY]));
+    latency_histogram_record(&acquisition.callback_latency,
+                             elapsed_us(start_us));
+    return 0;
+}
+
+// publishes the SHTC3 sample the derived sensors are computed from
+static void derived_sensors_publish(void) {
+    sensor_value_t values[2];
+    // the sample was just taken, it is not measured again
+    if (!sensor_cache_peek(SENSOR_CACHE_DEVICE_SHTC3, 0,
+                           AVS_ARRAY_SIZE(values), values, NULL)) {
+        seqlock_write(&acquisition.shtc3_lock, acquisition.shtc3_values,
+                      values, sizeof(values));
+    }
+}
+
+static void derived_sensors_install(anjay_t *anjay) {
+    derived_sensors_publish();
+    if (anjay_ipso_basic_sensor_install(anjay, OID_GENERIC_SENSOR,
+                                        AVS_ARRAY_SIZE(DERIVED_SENSORS_DEF))) {
+        avs_log(ipso_object, WARNING,
+                "Object: Generic sensor could not be installed");
+        return;
+    }
+    for (int i = 0; i < (int) AVS_ARRAY_SIZE(DERIVED_SENSORS_DEF); i++) {
+        const derived_sensor_def_t *def = &DERIVED_SENSORS_DEF[i];
+
+        if (anjay_ipso_basic_sensor_instance_add(
+                    anjay,
+                    OID_GENERIC_SENSOR,
+                    (anjay_iid_t) i,
+                    (anjay_ipso_basic_sensor_impl_t) {
+                        .unit = def->unit,
+                        .user_context = (void *) def,
+                        .min_range_value = NAN,
+                        .max_range_value = NAN,
+                        .get_value = derived_sensor_get_value
+                    })) {
+            avs_log(ipso_object,
+                    WARNING,
+                    "Instance of %s object could not be added",
+                    def->name);
+        }
+    }
+}
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+static uint32_t sampling_period_ms(anjay_t *anjay,
+                                   anjay_oid_t oid,
+                                   anjay_iid_t iid,
+                                   const anjay_rid_t *rids,
+                                   size_t rid_count,
+                                   uint32_t period_ms) {
+    bool observed = false;
+    int32_t min_period = INT32_MAX;
+    int32_t max_eval_period = INT32_MAX;
+    for (size_t i = 0; i < rid_count; i++) {
+        const anjay_resource_observation_status_t status =
+                anjay_resource_observation_status(anjay, oid, iid, rids[i]);
+        if (!status.is_observed) {
+            continue;
+        }
+        // the most demanding observation wins
+        observed = true;
+        if (status.min_period < min_period) {
+            min_period = status.min_period;
+        }
+        if (status.max_eval_period > 0
+                && status.max_eval_period < max_eval_period) {
+            max_eval_period = status.max_eval_period;
+        }
+    }
+
+    if (!observed) {
+        return AVS_MAX(period_ms, SENSORS_UNOBSERVED_PERIOD_MS);
+    }
+    int64_t result_ms = period_ms;
+    if (min_period > 0) {
+        result_ms = AVS_MAX(result_ms, (int64_t) min_period * 1000);
+    }
+    if (max_eval_period < INT32_MAX) {
+        result_ms = AVS_MIN(result_ms, (int64_t) max_eval_period * 1000);
+    }
+    return (uint32_t) AVS_MIN(AVS_MAX(result_ms, SENSORS_MIN_PERIOD_MS),
+                              SENSORS_MAX_PERIOD_MS);
+}
+
+static uint32_t stats_period_ms(uint32_t period_ms, uint32_t base_period_ms) {
+#if CONFIG_ANJAY_CLIENT_SENSOR_STATS_FULL_RATE
+    // samples not worth notifying are still aggregated in the statistics
+    return AVS_MIN(period_ms, base_period_ms);
+#else  // CONFIG_ANJAY_CLIENT_SENSOR_STATS_FULL_RATE
+    (void) base_period_ms;
+    return period_ms;
+#endif // CONFIG_ANJAY_CLIENT_SENSOR_STATS_FULL_RATE
+}
+
+static uint32_t basic_sensor_period_ms(anjay_t *anjay,
+                                       const basic_sensor_context_t *ctx) {
+    static const anjay_rid_t RIDS[] = { RID_SENSOR_VALUE };
+    return stats_period_ms(sampling_period_ms(anjay, ctx->oid, 0, RIDS,
+                                              AVS_ARRAY_SIZE(RIDS),
+                                              ctx->period_ms),
+                           ctx->period_ms);
+}
+
+static uint32_t
+three_axis_sensor_period_ms(anjay_t *anjay,
+                            const three_axis_sensor_context_t *ctx) {
+    static const anjay_rid_t RIDS[] = { RID_X_VALUE, RID_Y_VALUE,
+                                        RID_Z_VALUE };
+    return stats_period_ms(sampling_period_ms(anjay, ctx->oid, 0, RIDS,
+                                              AVS_ARRAY_SIZE(RIDS),
+                                              ctx->period_ms),
+                           ctx->period_ms);
+}
+
+static void sensor_window_start(sensor_window_t *window,
+                                anjay_oid_t oid,
+                                uint8_t axis_count,
+                                avs_time_monotonic_t now) {
+    window->current = (sensors_stats_t) {
+        .oid = oid,
+        .axis_count = axis_count
+    };
+    seqlock_write(&window->lock, window->complete, &window->current,
+                  sizeof(window->current));
+    window->end = avs_time_monotonic_add(
+            now, (avs_time_duration_t) SENSORS_STATS_WINDOW);
+}
+
+static void sensor_window_add(sensor_window_t *window,
+                              const sensor_value_t *values,
+                              avs_time_monotonic_t now) {
+    if (!avs_time_monotonic_before(now, window->end)) {
+        window->current.windows++;
+        seqlock_write(&window->lock, window->complete, &window->current,
+                      sizeof(window->current));
+        for (int i = 0; i < window->current.axis_count; i++) {
+            window_stats_reset(&window->current.axes[i]);
+        }
+        // windows stay aligned, unless no sample was taken for a whole one
+        const avs_time_duration_t duration =
+                (avs_time_duration_t) SENSORS_STATS_WINDOW;
+        window->end = avs_time_monotonic_add(window->end, duration);
+        if (!avs_time_monotonic_before(now, window->end)) {
+            window->end = avs_time_monotonic_add(now, duration);
+        }
+    }
+    for (int i = 0; i < window->current.axis_count; i++) {
+        window_stats_add(&window->current.axes[i], values[i]);
+    }
+}
+
+// returns true if the sensor value changed significantly
+static bool basic_sensor_acquire(basic_sensor_context_t *ctx,
+                                 avs_time_monotonic_t now) {
+    sensor_value_t value;
+    if (basic_sensor_sample(ctx, &value)) {
+        return false;
+    }
+    sensor_window_add(&ctx->window, &value, now);
+    if (!change_filter_update(&ctx->filter, value)) {
+        return false;
+    }
+    seqlock_write(&ctx->lock, ctx->values, &value, sizeof(value));
+    atomic_store(&ctx->changed, true);
+    return true;
+}
+
+static void three_axis_sensor_acquire(three_axis_sensor_context_t *ctx,
+                                      avs_time_monotonic_t now) {
+    three_axis_sensor_data_t value;
+    if (three_axis_sensor_sample(ctx, &value)) {
+        return;
+    }
+    const sensor_value_t values[] = { value.x_value, value.y_value,
+                                      value.z_value };
+    sensor_window_add(&ctx->window, values, now);
+    // the object is updated if any of the axes changed significantly
+    bool changed = change_filter_update(&ctx->filters[0], value.x_value);
+    changed |= change_filter_update(&ctx->filters[1], value.y_value);
+    changed |= change_filter_update(&ctx->filters[2], value.z_value);
+    if (changed) {
+        seqlock_write(&ctx->lock, ctx->values, &value, sizeof(value));
+        atomic_store(&ctx->changed, true);
+    }
+}
+
+static avs_time_monotonic_t *last_deadline(int id) {
+    if (id < BASIC_SENSORS_COUNT) {
+        return &BASIC_SENSORS_DEF[id].last_deadline;
+    }
+    return &THREE_AXIS_SENSORS_DEF[id - BASIC_SENSORS_COUNT].last_deadline;
+}
+
+static atomic_uint *sampling_period(int id) {
+    if (id < BASIC_SENSORS_COUNT) {
+        return &BASIC_SENSORS_DEF[id].sampling_period_ms;
+    }
+    return &THREE_AXIS_SENSORS_DEF[id - BASIC_SENSORS_COUNT]
+                    .sampling_period_ms;
+}
+
+static avs_time_duration_t sensor_period(int id) {
+    return avs_time_duration_from_scalar(atomic_load(sampling_period(id)),
+                                         AVS_TIME_MS);
+}
+
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+// the derived sensors are sampled along with the SHTC3 they are derived from
+static uint32_t derived_sensors_period_ms(anjay_t *anjay) {
+    static const anjay_rid_t RIDS[] = { RID_SENSOR_VALUE };
+    uint32_t result = UINT32_MAX;
+    for (int i = 0; i < (int) AVS_ARRAY_SIZE(DERIVED_SENSORS_DEF); i++) {
+        result = AVS_MIN(result,
+                         sampling_period_ms(anjay, OID_GENERIC_SENSOR,
+                                            (anjay_iid_t) i, RIDS,
+                                            AVS_ARRAY_SIZE(RIDS),
+                                            DERIVED_SENSORS_PERIOD_MS));
+    }
+    return result;
+}
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+static sensor_cache_device_t sensor_device(int id) {
+    if (id < BASIC_SENSORS_COUNT) {
+        return BASIC_SENSORS_DEF[id].device;
+    }
+    return THREE_AXIS_SENSORS_DEF[id - BASIC_SENSORS_COUNT].device;
+}
+
+/*
+ * All sensors fed by the same device are sampled with the shortest of their
+ * periods. As they are all started at once, their deadlines then coincide,
+ * so that a single measurement of the device serves all of them and the
+ * device is measured at that period.
+ * Returns true if any period changed.
+ */
+static bool update_sampling_periods(anjay_t *anjay) {
+    uint32_t device_periods_ms[SENSOR_CACHE_DEVICE_COUNT];
+    for (int i = 0; i < SENSOR_CACHE_DEVICE_COUNT; i++) {
+        device_periods_ms[i] = UINT32_MAX;
+    }
+    for (int id = 0; id < SENSORS_COUNT; id++) {
+        const uint32_t period_ms =
+                id < BASIC_SENSORS_COUNT
+                        ? basic_sensor_period_ms(anjay, &BASIC_SENSORS_DEF[id])
+                        : three_axis_sensor_period_ms(
+                                  anjay, &THREE_AXIS_SENSORS_DEF
+                                                 [id - BASIC_SENSORS_COUNT]);
+        uint32_t *device_period_ms = &device_periods_ms[sensor_device(id)];
+        *device_period_ms = AVS_MIN(*device_period_ms, period_ms);
+    }
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    uint32_t *shtc3_period_ms = &device_periods_ms[SENSOR_CACHE_DEVICE_SHTC3];
+    *shtc3_period_ms =
+            AVS_MIN(*shtc3_period_ms, derived_sensors_period_ms(anjay));
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+    bool changed = false;
+    for (int id = 0; id < SENSORS_COUNT; id++) {
+        const uint32_t period_ms = device_periods_ms[sensor_device(id)];
+        changed |= atomic_exchange(sampling_period(id), period_ms) != period_ms;
+    }
+    return changed;
+}
+
+/*
+ * While the device does not move, samples of the MPU6886 would be its last
+ * sample over and over again, so they are not scheduled at all and the CPU
+ * may sleep until motion resumes them.
+ */
+static bool sensor_suspended(int id) {
+    return sensor_device(id) == SENSOR_CACHE_DEVICE_MPU6886
+           && atomic_load(&acquisition.motion_idle);
+}
+
+static void push_deadline(int id, avs_time_monotonic_t deadline) {
+    int result = deadline_heap_push(&acquisition.deadlines, (uint8_t) id,
+                                    deadline);
+    assert(!result);
+    (void) result;
+}
+
+// rebuilds the deadlines after sampling periods or the motion state changed
+static void schedule_all_samples(void) {
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    acquisition.deadlines.size = 0;
+    for (int id = 0; id < SENSORS_COUNT; id++) {
+        if (sensor_suspended(id)) {
+            continue;
+        }
+        const avs_time_monotonic_t deadline =
+                avs_time_monotonic_add(*last_deadline(id), sensor_period(id));
+        push_deadline(id, avs_time_monotonic_before(now, deadline) ? deadline
+                                                                   : now);
+    }
+}
+
+static void acquire_due_samples(void) {
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    bool shtc3_changed = false;
+    deadline_heap_entry_t entry;
+    while (!deadline_heap_peek(&acquisition.deadlines, &entry)
+           && !avs_time_monotonic_before(now, entry.deadline)) {
+        deadline_heap_pop(&acquisition.deadlines);
+
+        const int id = entry.id;
+        if (id < BASIC_SENSORS_COUNT) {
+            basic_sensor_context_t *ctx = &BASIC_SENSORS_DEF[id];
+            if (basic_sensor_acquire(ctx, now)) {
+                shtc3_changed |= ctx->device == SENSOR_CACHE_DEVICE_SHTC3;
+            }
+        } else {
+            three_axis_sensor_acquire(
+                    &THREE_AXIS_SENSORS_DEF[id - BASIC_SENSORS_COUNT], now);
+        }
+        *last_deadline(id) = entry.deadline;
+        if (sensor_suspended(id)) {
+            continue;
+        }
+
+        // keep the cadence, unless the sample is late by a whole period
+        const avs_time_duration_t period = sensor_period(id);
+        avs_time_monotonic_t deadline =
+                avs_time_monotonic_add(entry.deadline, period);
+        if (!avs_time_monotonic_before(now, deadline)) {
+            deadline = avs_time_monotonic_add(now, period);
+        }
+        push_deadline(id, deadline);
+    }
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    if (shtc3_changed) {
+        derived_sensors_publish();
+    }
+#else  // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    (void) shtc3_changed;
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+}
+
+/*
+ * Samples the sensors that are due and sleeps until the next deadline, so
+ * that nothing runs while no sensor needs sampling.
+ */
+static void acquisition_task(void *arg) {
+    (void) arg;
+    schedule_all_samples();
+    while (!acquisition.stop_requested) {
+        TickType_t timeout = portMAX_DELAY;
+        deadline_heap_entry_t entry;
+        if (!deadline_heap_peek(&acquisition.deadlines, &entry)) {
+            int64_t remaining_ms = 0;
+            (void) avs_time_duration_to_scalar(
+                    &remaining_ms, AVS_TIME_MS,
+                    avs_time_monotonic_diff(entry.deadline,
+                                            avs_time_monotonic_now()));
+            // rounded up, not to wake up just before the deadline
+            timeout = remaining_ms > 0 ? pdMS_TO_TICKS(remaining_ms) + 1 : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout);
+        if (acquisition.stop_requested) {
+            break;
+        }
+        if (atomic_exchange(&acquisition.periods_changed, false)) {
+            schedule_all_samples();
+        }
+        acquire_due_samples();
+    }
+    acquisition.task = NULL;
+    vTaskDelete(NULL);
+}
+
+static void log_latency(const char *what, latency_histogram_t *histogram) {
+    uint32_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    latency_histogram_snapshot(histogram, counts);
+    avs_log(ipso_object, INFO,
+            "%s latency: p50 < %" PRIu32 " us, p99 < %" PRIu32 " us", what,
+            latency_histogram_percentile(counts, 500),
+            latency_histogram_percentile(counts, 990));
+}
+
+void sensors_update(anjay_t *anjay) {
+    bool shtc3_changed = false;
+    for (int i = 0; i < BASIC_SENSORS_COUNT; i++) {
+        basic_sensor_context_t *ctx = &BASIC_SENSORS_DEF[i];
+
+        if (atomic_exchange(&ctx->changed, false)) {
+            anjay_ipso_basic_sensor_update(anjay, ctx->oid, 0);
+            shtc3_changed |= ctx->device == SENSOR_CACHE_DEVICE_SHTC3;
+        }
+    }
+    for (int i = 0; i < (int) AVS_ARRAY_SIZE(THREE_AXIS_SENSORS_DEF); i++) {
+        three_axis_sensor_context_t *ctx = &THREE_AXIS_SENSORS_DEF[i];
+
+        if (atomic_exchange(&ctx->changed, false)) {
+            anjay_ipso_3d_sensor_update(anjay, ctx->oid, 0);
+        }
+    }
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    // derived values are recomputed only if their inputs changed
+    if (shtc3_changed) {
+        for (int i = 0; i < (int) AVS_ARRAY_SIZE(DERIVED_SENSORS_DEF); i++) {
+            anjay_ipso_basic_sensor_update(anjay, OID_GENERIC_SENSOR,
+                                           (anjay_iid_t) i);
+        }
     }
+#else  // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    (void) shtc3_changed;
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+
+    if (update_sampling_periods(anjay) && acquisition.task) {
+        atomic_store(&acquisition.periods_changed, true);
+        xTaskNotifyGive(acquisition.task);
+    }
+
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    if (!avs_time_monotonic_before(now, acquisition.next_latency_log)) {
+        acquisition.next_latency_log = avs_time_monotonic_add(
+                now, (avs_time_duration_t) SENSORS_LATENCY_LOG_PERIOD);
+        log_latency("Sensor read", &acquisition.sample_latency);
+        log_latency("Sensor callback", &acquisition.callback_latency);
+    }
+}
+
+static void acquisition_start(anjay_t *anjay) {
+    // initial values were sampled on install
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    for (int i = 0; i < BASIC_SENSORS_COUNT; i++) {
+        basic_sensor_context_t *ctx = &BASIC_SENSORS_DEF[i];
+        ctx->last_deadline = now;
+        sensor_window_start(&ctx->window, ctx->oid, 1, now);
+    }
+    for (int i = 0; i < (int) AVS_ARRAY_SIZE(THREE_AXIS_SENSORS_DEF); i++) {
+        three_axis_sensor_context_t *ctx = &THREE_AXIS_SENSORS_DEF[i];
+        ctx->last_deadline = now;
+        sensor_window_start(&ctx->window, ctx->oid, 3, now);
+    }
+    (void) update_sampling_periods(anjay);
+    acquisition.next_latency_log = avs_time_monotonic_add(
+            now, (avs_time_duration_t) SENSORS_LATENCY_LOG_PERIOD);
+
+    acquisition.stop_requested = false;
+    atomic_store(&acquisition.periods_changed, false);
+    if (xTaskCreatePinnedToCore(&acquisition_task, "sensors_task", 3072, NULL,
+                                5, &acquisition.task, ACQUISITION_TASK_CORE)
+            != pdPASS) {
+        avs_log(ipso_object, WARNING,
+                "Sensor acquisition task could not be created");
+    }
+}
+
+#if CONFIG_ANJAY_CLIENT_SAMPLE_PATH_BENCHMARK
+// a few ms of CPU time, far from a wraparound of the cycle counter
+#    define SAMPLE_PATH_BENCHMARK_SAMPLES 2000
+
+static uint32_t cpu_cycles(void) {
+    return esp_cpu_get_ccount();
+}
+
+static void log_sample_path_benchmark(void) {
+    sample_path_benchmark_result_t result;
+    sample_path_benchmark_run(cpu_cycles, SAMPLE_PATH_BENCHMARK_SAMPLES,
+                              &result);
+    avs_log(ipso_object, INFO,
+            "Sample path: %" PRIu32 " CPU cycles per sample in fixed point, "
+            "%" PRIu32 " in double",
+            result.fixed_point_ticks / SAMPLE_PATH_BENCHMARK_SAMPLES,
+            result.double_ticks / SAMPLE_PATH_BENCHMARK_SAMPLES);
 }
+#endif // CONFIG_ANJAY_CLIENT_SAMPLE_PATH_BENCHMARK
+
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+static void motion_idle_changed(bool idle) {
+    atomic_store(&acquisition.motion_idle, idle);
+    // deadlines of the MPU6886 sensors are dropped or pushed back
+    atomic_store(&acquisition.periods_changed, true);
+    if (acquisition.task) {
+        xTaskNotifyGive(acquisition.task);
+    }
+}
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
 
 void sensors_install(anjay_t *anjay) {
 #if CONFIG_ANJAY_CLIENT_BOARD_M5STICKC_PLUS
@@ -146,10 +884,32 @@ void sensors_install(anjay_t *anjay) {
         return;
     }
 #endif
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+    if (vibration_monitor_start()) {
+        avs_log(ipso_object, WARNING, "Vibration monitoring is not available");
+    }
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+    if (motion_monitor_start(motion_idle_changed)) {
+        avs_log(ipso_object, WARNING, "Wake-on-motion is not available");
+    }
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
 
     for (int i = 0; i < (int) AVS_ARRAY_SIZE(BASIC_SENSORS_DEF); i++) {
         basic_sensor_context_t *ctx = &BASIC_SENSORS_DEF[i];
 
+        change_filter_init(&ctx->filter, &ctx->filter_config);
+        sensor_value_t value;
+        if (basic_sensor_sample(ctx, &value)) {
+            avs_log(ipso_object,
+                    WARNING,
+                    "Could not read initial value of %s",
+                    ctx->name);
+        } else {
+            (void) change_filter_update(&ctx->filter, value);
+            seqlock_write(&ctx->lock, ctx->values, &value, sizeof(value));
+        }
+
         if (anjay_ipso_basic_sensor_install(anjay, ctx->oid, 1)) {
             avs_log(ipso_object,
                     WARNING,
@@ -175,9 +935,28 @@ void sensors_install(anjay_t *anjay) {
                     ctx->name);
         }
     }
+#ifdef CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
+    derived_sensors_install(anjay);
+#endif // CONFIG_ANJAY_CLIENT_HUMIDITY_SENSOR_AVAILABLE
     for (int i = 0; i < (int) AVS_ARRAY_SIZE(THREE_AXIS_SENSORS_DEF); i++) {
         three_axis_sensor_context_t *ctx = &THREE_AXIS_SENSORS_DEF[i];
 
+        for (int j = 0; j < (int) AVS_ARRAY_SIZE(ctx->filters); j++) {
+            change_filter_init(&ctx->filters[j], &ctx->filter_config);
+        }
+        three_axis_sensor_data_t value;
+        if (three_axis_sensor_sample(ctx, &value)) {
+            avs_log(ipso_object,
+                    WARNING,
+                    "Could not read initial value of %s",
+                    ctx->name);
+        } else {
+            (void) change_filter_update(&ctx->filters[0], value.x_value);
+            (void) change_filter_update(&ctx->filters[1], value.y_value);
+            (void) change_filter_update(&ctx->filters[2], value.z_value);
+            seqlock_write(&ctx->lock, ctx->values, &value, sizeof(value));
+        }
+
         if (anjay_ipso_3d_sensor_install(anjay, ctx->oid, 1)) {
             avs_log(ipso_object,
                     WARNING,
@@ -205,18 +984,51 @@ void sensors_install(anjay_t *anjay) {
                     ctx->name);
         }
     }
+
+    acquisition_start(anjay);
+#if CONFIG_ANJAY_CLIENT_SAMPLE_PATH_BENCHMARK
+    log_sample_path_benchmark();
+#endif // CONFIG_ANJAY_CLIENT_SAMPLE_PATH_BENCHMARK
 }
 
-void sensors_update(anjay_t *anjay) {
-    for (int i = 0; i < (int) AVS_ARRAY_SIZE(BASIC_SENSORS_DEF); i++) {
-        anjay_ipso_basic_sensor_update(anjay, BASIC_SENSORS_DEF[i].oid, 0);
+int sensors_stats_count(void) {
+    return SENSORS_COUNT;
+}
+
+int sensors_get_stats(int index, sensors_stats_t *out_stats) {
+    assert(out_stats);
+
+    if (index < 0 || index >= SENSORS_COUNT) {
+        return -1;
     }
-    for (int i = 0; i < (int) AVS_ARRAY_SIZE(THREE_AXIS_SENSORS_DEF); i++) {
-        anjay_ipso_3d_sensor_update(anjay, THREE_AXIS_SENSORS_DEF[i].oid, 0);
+    sensor_window_t *window =
+            index < BASIC_SENSORS_COUNT
+                    ? &BASIC_SENSORS_DEF[index].window
+                    : &THREE_AXIS_SENSORS_DEF[index - BASIC_SENSORS_COUNT]
+                               .window;
+    seqlock_read(&window->lock, window->complete, out_stats,
+                 sizeof(*out_stats));
+    return 0;
+}
+
+void sensors_stop(void) {
+    if (!acquisition.task) {
+        return;
+    }
+    acquisition.stop_requested = true;
+    xTaskNotifyGive(acquisition.task);
+    while (acquisition.task) {
+        vTaskDelay(pdMS_TO_TICKS(ACQUISITION_TASK_STOP_POLL_PERIOD_MS));
     }
 }
 
 void sensors_release(void) {
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+    vibration_monitor_stop();
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+#if CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
+    motion_monitor_stop();
+#endif // CONFIG_ANJAY_CLIENT_WAKE_ON_MOTION
 #if CONFIG_ANJAY_CLIENT_BOARD_M5STICKC_PLUS
     mpu6886_driver_release();
 #endif
@@ -0,0 +1,200 @@
+/**
+ * LwM2M Object: SHTC3 profile
+ * ID: 26244, Single
+ *
+ * Measurement profile of the SHTC3 temperature and humidity sensor mounted on
+ * the board, with the cost of the measurements taken with each profile, so
+ * that profiles can be compared on a running device. Object ID from the range
+ * of objects not registered with OMNA.
+ */
+#include <assert.h>
+#include <stdbool.h>
+
+#include <anjay/anjay.h>
+#include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_memory.h>
+
+#include "objects.h"
+#include "shtc3.h"
+
+/**
+ * Profile: RW, Single, Mandatory
+ * type: integer, range: 0..3, unit: N/A
+ * 0=Normal power, polling 1=Normal power, clock stretching 2=Low power,
+ * polling 3=Low power, clock stretching. Takes effect from the next
+ * measurement.
+ */
+#define RID_PROFILE 0
+
+/**
+ * Latency: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: us
+ * Average time from starting a measurement to reading its result, since
+ * boot. Resource Instance ID is the profile the measurements were taken
+ * with, profiles never used are absent.
+ */
+#define RID_LATENCY 1
+
+/**
+ * Bus time: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: us
+ * Average time spent on I2C transactions per measurement cycle, since boot,
+ * including wakeup and sleep. Resource Instance IDs as in Latency.
+ */
+#define RID_BUS_TIME 2
+
+#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+
+#    define SHTC3_PROFILE_IID 0
+
+typedef struct shtc3_profile_object_struct {
+    const anjay_dm_object_def_t *def;
+} shtc3_profile_object_t;
+
+static inline shtc3_profile_object_t *
+get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
+    assert(obj_ptr);
+    return AVS_CONTAINER_OF(obj_ptr, shtc3_profile_object_t, def);
+}
+
+static int list_resources(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+
+    anjay_dm_emit_res(ctx, RID_PROFILE, ANJAY_DM_RES_RW, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_LATENCY, ANJAY_DM_RES_RM, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_BUS_TIME, ANJAY_DM_RES_RM,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int resource_read(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr,
+                         anjay_iid_t iid,
+                         anjay_rid_t rid,
+                         anjay_riid_t riid,
+                         anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    assert(iid == SHTC3_PROFILE_IID);
+
+    switch (rid) {
+    case RID_PROFILE:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i32(ctx, (int32_t) shtc3_get_profile());
+
+    case RID_LATENCY:
+    case RID_BUS_TIME: {
+        double latency_us, bus_time_us;
+        if (riid >= SHTC3_PROFILE_COUNT
+                || shtc3_get_profile_stats((shtc3_profile_t) riid,
+                                           &latency_us, &bus_time_us)) {
+            return ANJAY_ERR_NOT_FOUND;
+        }
+        return anjay_ret_double(ctx,
+                                rid == RID_LATENCY ? latency_us : bus_time_us);
+    }
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static int resource_write(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_rid_t rid,
+                          anjay_riid_t riid,
+                          anjay_input_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    assert(iid == SHTC3_PROFILE_IID);
+
+    switch (rid) {
+    case RID_PROFILE: {
+        assert(riid == ANJAY_ID_INVALID);
+        int32_t profile;
+        if (anjay_get_i32(ctx, &profile)
+                || shtc3_set_profile((shtc3_profile_t) profile)) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        return 0;
+    }
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static int list_resource_instances(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_rid_t rid,
+                                   anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+
+    switch (rid) {
+    case RID_LATENCY:
+    case RID_BUS_TIME:
+        for (int profile = 0; profile < SHTC3_PROFILE_COUNT; profile++) {
+            double latency_us, bus_time_us;
+            if (!shtc3_get_profile_stats((shtc3_profile_t) profile,
+                                         &latency_us, &bus_time_us)) {
+                anjay_dm_emit(ctx, (anjay_riid_t) profile);
+            }
+        }
+        return 0;
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static const anjay_dm_object_def_t OBJ_DEF = {
+    .oid = 26244,
+    .handlers = {
+        .list_instances = anjay_dm_list_instances_SINGLE,
+        .list_resources = list_resources,
+        .resource_read = resource_read,
+        .resource_write = resource_write,
+        .list_resource_instances = list_resource_instances,
+
+        .transaction_begin = anjay_dm_transaction_NOOP,
+        .transaction_validate = anjay_dm_transaction_NOOP,
+        .transaction_commit = anjay_dm_transaction_NOOP,
+        .transaction_rollback = anjay_dm_transaction_NOOP
+    }
+};
+
+const anjay_dm_object_def_t **shtc3_profile_object_create(void) {
+    shtc3_profile_object_t *obj = (shtc3_profile_object_t *) avs_calloc(
+            1, sizeof(shtc3_profile_object_t));
+    if (!obj) {
+        return NULL;
+    }
+    obj->def = &OBJ_DEF;
+    return &obj->def;
+}
+
+void shtc3_profile_object_release(const anjay_dm_object_def_t **def) {
+    if (def) {
+        avs_free(get_obj(def));
+    }
+}
+#else  // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+const anjay_dm_object_def_t **shtc3_profile_object_create(void) {
+    return NULL;
+}
+
+void shtc3_profile_object_release(const anjay_dm_object_def_t **def) {
+    (void) def;
+}
+#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
@@ -0,0 +1,299 @@
+/**
+ * LwM2M Object: Vibration
+ * ID: 26241, Single
+ *
+ * Vibration features of the accelerometer signal, computed on the device
+ * over windows of consecutive samples. Object ID from the range of objects
+ * not registered with OMNA.
+ */
+#include <assert.h>
+#include <stdbool.h>
+
+#include <anjay/anjay.h>
+#include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_memory.h>
+
+#include "change_filter.h"
+#include "objects.h"
+#include "sensor_value.h"
+#include "vibration_monitor.h"
+
+/**
+ * RMS: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: m/s2
+ * Root mean square of the acceleration with its mean removed, over the last
+ * window. Resource Instance IDs 0, 1 and 2 stand for X, Y and Z axis.
+ */
+#define RID_RMS 0
+
+/**
+ * Peak: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: m/s2
+ * Largest deviation of the acceleration from its mean over the last window,
+ * per axis.
+ */
+#define RID_PEAK 1
+
+/**
+ * Crest factor: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: N/A
+ * Peak divided by RMS, per axis; high for impacts, about 1.41 for
+ * a sinusoidal vibration.
+ */
+#define RID_CREST_FACTOR 2
+
+/**
+ * Dominant frequency: R, Multiple, Mandatory
+ * type: float, range: N/A, unit: Hz
+ * Frequency of the strongest spectral component over the last window, per
+ * axis.
+ */
+#define RID_DOMINANT_FREQUENCY 3
+
+/**
+ * Sample rate: R, Single, Mandatory
+ * type: integer, range: N/A, unit: Hz
+ * Rate at which the accelerometer is sampled.
+ */
+#define RID_SAMPLE_RATE 4
+
+/**
+ * Windows: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of windows analysed since boot.
+ */
+#define RID_WINDOWS 5
+
+/**
+ * Overflows: R, Single, Mandatory
+ * type: integer, range: N/A, unit: N/A
+ * Number of times samples were lost since boot, because the sensor FIFO was
+ * not read in time.
+ */
+#define RID_OVERFLOWS 6
+
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+
+#    define VIBRATION_IID 0
+
+/**
+ * Changes of RMS smaller than this are not notified; features of all axes
+ * are notified together when RMS of any of them changed.
+ */
+static const change_filter_config_t RMS_CHANGE_FILTER = {
+    .abs_deadband = 50, // in mm/s2
+    .rel_deadband_permille = 100,
+    .min_interval = { .seconds = 5 }
+};
+
+typedef struct vibration_object_struct {
+    const anjay_dm_object_def_t *def;
+
+    change_filter_t rms_filters[VIBRATION_AXES];
+    uint32_t windows_last;
+    uint32_t overflows_last;
+} vibration_object_t;
+
+static inline vibration_object_t *
+get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
+    assert(obj_ptr);
+    return AVS_CONTAINER_OF(obj_ptr, vibration_object_t, def);
+}
+
+static bool is_features_resource(anjay_rid_t rid) {
+    return rid == RID_RMS || rid == RID_PEAK || rid == RID_CREST_FACTOR
+           || rid == RID_DOMINANT_FREQUENCY;
+}
+
+static int list_resources(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+
+    anjay_dm_emit_res(ctx, RID_RMS, ANJAY_DM_RES_RM, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_PEAK, ANJAY_DM_RES_RM, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_CREST_FACTOR, ANJAY_DM_RES_RM,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_DOMINANT_FREQUENCY, ANJAY_DM_RES_RM,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_SAMPLE_RATE, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_WINDOWS, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_OVERFLOWS, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int read_features_resource(anjay_rid_t rid,
+                                  anjay_riid_t riid,
+                                  anjay_output_ctx_t *ctx) {
+    vibration_features_t features;
+    uint32_t windows;
+    if (riid >= VIBRATION_AXES) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    if (vibration_monitor_get_features(&features, &windows)) {
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+
+    const vibration_axis_features_t *axis = &features.axes[riid];
+    sensor_value_t value;
+    switch (rid) {
+    case RID_RMS:
+        value = axis->rms;
+        break;
+    case RID_PEAK:
+        value = axis->peak;
+        break;
+    case RID_CREST_FACTOR:
+        value = axis->crest_factor;
+        break;
+    default:
+        value = axis->dominant_frequency;
+    }
+    return anjay_ret_double(ctx, SENSOR_VALUE_TO_DOUBLE(value));
+}
+
+static int resource_read(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr,
+                         anjay_iid_t iid,
+                         anjay_rid_t rid,
+                         anjay_riid_t riid,
+                         anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    assert(iid == VIBRATION_IID);
+
+    switch (rid) {
+    case RID_RMS:
+    case RID_PEAK:
+    case RID_CREST_FACTOR:
+    case RID_DOMINANT_FREQUENCY:
+        return read_features_resource(rid, riid, ctx);
+
+    case RID_SAMPLE_RATE:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i32(ctx, vibration_monitor_get_sample_rate());
+
+    case RID_WINDOWS: {
+        assert(riid == ANJAY_ID_INVALID);
+        vibration_features_t features;
+        uint32_t windows = 0;
+        (void) vibration_monitor_get_features(&features, &windows);
+        return anjay_ret_i64(ctx, windows);
+    }
+
+    case RID_OVERFLOWS:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i64(ctx, vibration_monitor_get_overflows());
+
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static int list_resource_instances(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_rid_t rid,
+                                   anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+
+    assert(iid == VIBRATION_IID);
+
+    if (!is_features_resource(rid)) {
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    for (anjay_riid_t axis = 0; axis < VIBRATION_AXES; axis++) {
+        anjay_dm_emit(ctx, axis);
+    }
+    return 0;
+}
+
+static const anjay_dm_object_def_t OBJ_DEF = {
+    .oid = 26241,
+    .handlers = {
+        .list_instances = anjay_dm_list_instances_SINGLE,
+        .list_resources = list_resources,
+        .resource_read = resource_read,
+        .list_resource_instances = list_resource_instances
+    }
+};
+
+const anjay_dm_object_def_t **vibration_object_create(void) {
+    vibration_object_t *obj =
+            (vibration_object_t *) avs_calloc(1, sizeof(vibration_object_t));
+    if (!obj) {
+        return NULL;
+    }
+    obj->def = &OBJ_DEF;
+    for (int axis = 0; axis < VIBRATION_AXES; axis++) {
+        change_filter_init(&obj->rms_filters[axis], &RMS_CHANGE_FILTER);
+    }
+    return &obj->def;
+}
+
+void vibration_object_release(const anjay_dm_object_def_t **def) {
+    if (def) {
+        avs_free(get_obj(def));
+    }
+}
+
+void vibration_object_update(anjay_t *anjay,
+                             const anjay_dm_object_def_t *const *def) {
+    if (!anjay || !def) {
+        return;
+    }
+
+    vibration_object_t *obj = get_obj(def);
+
+    vibration_features_t features;
+    uint32_t windows;
+    if (!vibration_monitor_get_features(&features, &windows)
+            && windows != obj->windows_last) {
+        obj->windows_last = windows;
+
+        bool changed = false;
+        for (int axis = 0; axis < VIBRATION_AXES; axis++) {
+            changed |= change_filter_update(&obj->rms_filters[axis],
+                                            features.axes[axis].rms);
+        }
+        if (changed) {
+            (void) anjay_notify_changed(anjay, obj->def->oid, VIBRATION_IID,
+                                        RID_RMS);
+            (void) anjay_notify_changed(anjay, obj->def->oid, VIBRATION_IID,
+                                        RID_PEAK);
+            (void) anjay_notify_changed(anjay, obj->def->oid, VIBRATION_IID,
+                                        RID_CREST_FACTOR);
+            (void) anjay_notify_changed(anjay, obj->def->oid, VIBRATION_IID,
+                                        RID_DOMINANT_FREQUENCY);
+        }
+    }
+
+    const uint32_t overflows = vibration_monitor_get_overflows();
+    if (overflows != obj->overflows_last) {
+        obj->overflows_last = overflows;
+        (void) anjay_notify_changed(anjay, obj->def->oid, VIBRATION_IID,
+                                    RID_OVERFLOWS);
+    }
+}
+#else  // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+const anjay_dm_object_def_t **vibration_object_create(void) {
+    return NULL;
+}
+
+void vibration_object_release(const anjay_dm_object_def_t **def) {
+    (void) def;
+}
+
+void vibration_object_update(anjay_t *anjay,
+                             const anjay_dm_object_def_t *const *def) {
+    (void) anjay;
+    (void) def;
+}
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
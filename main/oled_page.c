@@ -2,6 +2,7 @@
 #include <stdio.h>
 
 #include "oled.h"
+#include "oled_page.h"
 
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
@@ -64,16 +65,24 @@ int oled_page_update_co2(uint16_t measurement) {
     return 0;
 }
 
-int oled_update_temp(double measurement) {
-    snprintf(temp_meas_txt, OLED_MAX_CHAR_PER_LINE + 1, "%.1fC", measurement);
+// prints @p value with one decimal, without floating point formatting
+static void format_tenths(char *buf, sensor_value_t value, const char *unit) {
+    const int32_t tenths = SENSOR_VALUE_ROUND(value, 10);
+    const uint32_t magnitude = (uint32_t) (tenths < 0 ? -tenths : tenths);
+    snprintf(buf, OLED_MAX_CHAR_PER_LINE + 1, "%s%" PRIu32 ".%" PRIu32 "%s",
+             tenths < 0 ? "-" : "", magnitude / 10, magnitude % 10, unit);
+}
+
+int oled_update_temp(sensor_value_t measurement) {
+    format_tenths(temp_meas_txt, measurement, "C");
 
     oled_update();
 
     return 0;
 }
 
-int oled_update_humi(double measurement) {
-    snprintf(humi_meas_txt, OLED_MAX_CHAR_PER_LINE + 1, "%.1f%%", measurement);
+int oled_update_humi(sensor_value_t measurement) {
+    format_tenths(humi_meas_txt, measurement, "%");
 
     oled_update();
 
@@ -5,10 +5,12 @@
 
 #include <stdint.h>
 
+#include "sensor_value.h"
+
 int oled_page_init(void);
 int oled_page_update_co2(uint16_t measurement);
-int oled_update_temp(double measurement);
-int oled_update_humi(double measurement);
+int oled_update_temp(sensor_value_t measurement);
+int oled_update_humi(sensor_value_t measurement);
 int oled_avs_icon(bool enable);
 int oled_wifi_icon(bool enable);
 int oled_page_deinit(void);
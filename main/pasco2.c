@@ -1,8 +1,12 @@
 #include "pasco2.h"
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "i2c_wrapper.h"
+#include "main.h"
 #include <anjay/anjay.h>
+#include <assert.h>
+#include <pthread.h>
 
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
@@ -25,12 +29,20 @@
 
 #    define SENS_STS_CORRECT_VAL 0xC0
 #    define MEAS_STS_MEASUR_RDY_VAL 0x10
+#    define MEAS_STS_INT_STS_CLR_VAL 0x02
 
 #    define RESET_VAL 0xA3
 
+// Continuous mode enable, ABOC enabled, PWM sf disabled
+#    define MEAS_CFG_CONTINUOUS_VAL \
+        ((((1 << 1) & ~(1 << 0)) | ((1 << 2) & ~(1 << 3))) & ~(1 << 5))
+#    define MEAS_CFG_IDLE_VAL 0x00
+// Single shot measurement, ABOC enabled, PWM sf disabled
+#    define MEAS_CFG_SINGLE_SHOT_VAL ((1 << 0) | (1 << 2))
+
 static const char *TAG = "pasco2";
 
-static i2c_device_t pasco2_device = {
+static const i2c_device_t PASCO2_ONBOARD_DEVICE = {
     .config = {
         .mode = I2C_MODE_MASTER,
         .sda_io_num = I2C_SDA_PASCO2,
@@ -43,10 +55,47 @@ static i2c_device_t pasco2_device = {
     .address = I2C_ADDRESS_PASCO2
 };
 
-static int pasco2_check_sts_reg(void) {
+void pasco2_setup(pasco2_t *sensor, const i2c_device_t *device) {
+    assert(sensor);
+    assert(device);
+    sensor->device = *device;
+    pthread_mutex_init(&sensor->bus_stats_mutex, NULL);
+    sensor->cycles = 0;
+    sensor->transactions = 0;
+    sensor->bus_time_us = 0;
+}
+
+const i2c_device_t *pasco2_onboard_device(void) {
+    return &PASCO2_ONBOARD_DEVICE;
+}
+
+static void bus_stats_add(pasco2_t *sensor, int64_t start_us) {
+    const int64_t duration_us = esp_timer_get_time() - start_us;
+    pthread_mutex_lock(&sensor->bus_stats_mutex);
+    sensor->transactions++;
+    sensor->bus_time_us += duration_us;
+    pthread_mutex_unlock(&sensor->bus_stats_mutex);
+}
+
+static int
+bus_read(pasco2_t *sensor, uint8_t reg, uint8_t *data, uint8_t size) {
+    const int64_t start_us = esp_timer_get_time();
+    int result = i2c_master_read_slave_reg(&sensor->device, reg, data, size);
+    bus_stats_add(sensor, start_us);
+    return result;
+}
+
+static int
+bus_write(pasco2_t *sensor, uint8_t reg, const uint8_t *data, uint32_t size) {
+    const int64_t start_us = esp_timer_get_time();
+    int result = i2c_master_write_slave_reg(&sensor->device, reg, data, size);
+    bus_stats_add(sensor, start_us);
+    return result;
+}
+
+static int pasco2_check_sts_reg(pasco2_t *sensor) {
     uint8_t reg_val = 0;
-    if (i2c_master_read_slave_reg(&pasco2_device, REG_ADDR_SENS_STS, &reg_val,
-                                  1U)
+    if (bus_read(sensor, REG_ADDR_SENS_STS, &reg_val, 1U)
             || SENS_STS_CORRECT_VAL != reg_val) {
         ESP_LOGW(TAG,
                  "Cannot read PASCO2 sensor status register or wrong status "
@@ -57,14 +106,32 @@ static int pasco2_check_sts_reg(void) {
     return 0;
 }
 
-int pasco2_init(void) {
+static int pasco2_write_measur_rate(pasco2_t *sensor, uint16_t period) {
+    uint8_t aux = (uint8_t) (period >> 8);
+    if (bus_write(sensor, REG_ADDR_MEAS_RATE_H, &aux, 1)) {
+        return -1;
+    }
+    aux = (uint8_t) (period & 0x00FF);
+    if (bus_write(sensor, REG_ADDR_MEAS_RATE_L, &aux, 1)) {
+        return -1;
+    }
+    return 0;
+}
+
+int pasco2_init(pasco2_t *sensor) {
+    assert(sensor);
+
     // check if status register have corrected value
     uint8_t aux = 0;
-    if (pasco2_reset()) {
+    // the ABOC context cannot be read out of the sensor, so it survives a
+    // reboot only if the sensor stayed powered and is not reset
+    const bool keep_context =
+            main_is_warm_reset() && !pasco2_check_sts_reg(sensor);
+    if (!keep_context && pasco2_reset(sensor)) {
         return -1;
     }
 
-    if (pasco2_check_sts_reg()) {
+    if (pasco2_check_sts_reg(sensor)) {
         return -1;
     }
 
@@ -76,82 +143,133 @@ int pasco2_init(void) {
     // }
 
     // Idle mode
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_MEAS_CFG, &aux,
-                                   1)) {
+    if (bus_write(sensor, REG_ADDR_MEAS_CFG, &aux, 1)) {
         return -1;
     }
 
     vTaskDelay(pdMS_TO_TICKS(1000UL));
 
     // Set measurment period
-    aux = (uint8_t) (PASCO2_MEASURMENTS_PERIOD >> 8);
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_MEAS_RATE_H, &aux,
-                                   1)) {
-        return -1;
-    }
-    // uint8_t aux = 0x3C;
-    aux = (uint8_t) (PASCO2_MEASURMENTS_PERIOD & 0x00FF);
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_MEAS_RATE_L, &aux,
-                                   1)) {
+    if (pasco2_write_measur_rate(sensor, PASCO2_MEASURMENTS_PERIOD)) {
         return -1;
     }
 
     // low active, data ready notification
     aux = (1 << 2);
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_INT_CFG, &aux, 1)) {
+    if (bus_write(sensor, REG_ADDR_INT_CFG, &aux, 1)) {
         return -1;
     }
 
-    // Continuous mode enable, ABOC enabled, PWM sf disabled
-    aux = (((1 << 1) & ~(1 << 0)) | ((1 << 2) & ~(1 << 3))) & ~(1 << 5);
-
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_MEAS_CFG, &aux,
-                                   1)) {
+#    if !CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
+    aux = MEAS_CFG_CONTINUOUS_VAL;
+    if (bus_write(sensor, REG_ADDR_MEAS_CFG, &aux, 1)) {
         return -1;
     }
+#    endif // !CONFIG_ANJAY_CLIENT_CO2_SINGLE_SHOT
 
     return 0;
 }
 
-int pasco2_is_measur_rdy(void) {
-    uint8_t reg_val = 0;
-    if (i2c_master_read_slave_reg(&pasco2_device, REG_ADDR_MEAS_STS, &reg_val,
-                                  1U)
-            || !(reg_val & (1 << 4))) {
+int pasco2_read_measur_val_and_clear(pasco2_t *sensor,
+                                     uint16_t *val,
+                                     bool *out_ready) {
+    assert(sensor);
+    assert(val);
+    assert(out_ready);
+
+    // CO2PPM_H, CO2PPM_L and MEAS_STS are adjacent, so one read fetches
+    // both the value and the data ready flag; the interrupt status is
+    // cleared within the same transaction
+    uint8_t aux[3];
+    const uint8_t clear = MEAS_STS_INT_STS_CLR_VAL;
+    const int64_t start_us = esp_timer_get_time();
+    int result = i2c_master_read_write_slave_reg(&sensor->device,
+                                                 REG_ADDR_CO2PPM_H, aux,
+                                                 sizeof(aux), REG_ADDR_MEAS_STS,
+                                                 &clear, 1);
+    bus_stats_add(sensor, start_us);
+
+    pthread_mutex_lock(&sensor->bus_stats_mutex);
+    sensor->cycles++;
+    pthread_mutex_unlock(&sensor->bus_stats_mutex);
+
+    if (result) {
         return -1;
     }
+    *out_ready = aux[2] & MEAS_STS_MEASUR_RDY_VAL;
+    *val = ((uint32_t) aux[0] << 8) + aux[1];
     return 0;
 }
 
-int pasco2_get_measur_val(uint16_t *val) {
-    assert(val);
+int pasco2_get_bus_stats(pasco2_t *sensor,
+                         double *out_transactions_per_cycle,
+                         double *out_bus_time_us_per_cycle) {
+    assert(sensor);
+    assert(out_transactions_per_cycle);
+    assert(out_bus_time_us_per_cycle);
+
+    pthread_mutex_lock(&sensor->bus_stats_mutex);
+    const uint32_t cycles = sensor->cycles;
+    const uint32_t transactions = sensor->transactions;
+    const int64_t bus_time_us = sensor->bus_time_us;
+    pthread_mutex_unlock(&sensor->bus_stats_mutex);
 
-    uint8_t aux[2];
-    if (i2c_master_read_slave_reg(&pasco2_device, REG_ADDR_CO2PPM_H, aux, 2U)) {
+    if (!cycles) {
         return -1;
     }
-
-    *val = ((uint32_t) aux[0] << 8) + aux[1];
+    *out_transactions_per_cycle = (double) transactions / cycles;
+    *out_bus_time_us_per_cycle = (double) bus_time_us / cycles;
     return 0;
 }
 
-int pasco2_reset_int_status_clear(void) {
+int pasco2_reset_int_status_clear(pasco2_t *sensor) {
     uint8_t aux;
 
-    aux = (1 << 1);
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_MEAS_STS, &aux,
-                                   1)) {
+    aux = MEAS_STS_INT_STS_CLR_VAL;
+    if (bus_write(sensor, REG_ADDR_MEAS_STS, &aux, 1)) {
         return -1;
     }
 
     return 0;
 }
 
-int pasco2_reset(void) {
+int pasco2_set_measur_period(pasco2_t *sensor, uint16_t period) {
+    if (period < PASCO2_MIN_MEASURMENTS_PERIOD
+            || period > PASCO2_MAX_MEASURMENTS_PERIOD) {
+        return -1;
+    }
+
+    // measurement rate may be changed in idle mode only
+    uint8_t aux = MEAS_CFG_IDLE_VAL;
+    if (bus_write(sensor, REG_ADDR_MEAS_CFG, &aux, 1)) {
+        return -1;
+    }
+    int result = pasco2_write_measur_rate(sensor, period);
+    if (result) {
+        ESP_LOGW(TAG, "Cannot set measurment period to %u s",
+                 (unsigned) period);
+    }
+    // restore continuous mode even if writing the rate failed
+    aux = MEAS_CFG_CONTINUOUS_VAL;
+    if (bus_write(sensor, REG_ADDR_MEAS_CFG, &aux, 1)) {
+        return -1;
+    }
+    return result;
+}
+
+int pasco2_start_single_shot(pasco2_t *sensor) {
+    // the sensor returns to idle mode once the measurement is done
+    uint8_t aux = MEAS_CFG_SINGLE_SHOT_VAL;
+    if (bus_write(sensor, REG_ADDR_MEAS_CFG, &aux, 1)) {
+        return -1;
+    }
+    return 0;
+}
+
+int pasco2_reset(pasco2_t *sensor) {
     uint8_t aux = RESET_VAL;
 
-    if (i2c_master_write_slave_reg(&pasco2_device, REG_ADDR_SENS_RST, &aux,
-                                   1)) {
+    if (bus_write(sensor, REG_ADDR_SENS_RST, &aux, 1)) {
         return -1;
     }
     return 0;
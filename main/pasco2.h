@@ -1,15 +1,59 @@
 #ifndef _PASCO2_H_
 #define _PASCO2_H_
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 
-#define PASCO2_MEASURMENTS_PERIOD 10 // in seconds
-#define CO2_NUMBER_OF_MEASURMENTS_PER_HOUR 3600U / (PASCO2_MEASURMENTS_PERIOD)
+#include "i2c_wrapper.h"
 
-int pasco2_init(void);
-int pasco2_is_measur_rdy(void);
-int pasco2_get_measur_val(uint16_t *val);
-int pasco2_reset_int_status_clear(void);
-int pasco2_reset(void);
+#define PASCO2_MEASURMENTS_PERIOD 10 // in seconds, used after init
+#define PASCO2_MIN_MEASURMENTS_PERIOD 5
+#define PASCO2_MAX_MEASURMENTS_PERIOD 4095
+// single shot measurement takes about 1.15 s
+#define PASCO2_SINGLE_SHOT_TIMEOUT_MS 3000
+
+/**
+ * Context of a single PASCO2 sensor. Each sensor keeps its own bus
+ * statistics, so several of them may be driven independently.
+ */
+typedef struct pasco2_struct {
+    i2c_device_t device;
+    pthread_mutex_t bus_stats_mutex;
+    uint32_t cycles;
+    uint32_t transactions;
+    int64_t bus_time_us;
+} pasco2_t;
+
+/**
+ * Binds @p sensor to a PASCO2 reachable as @p device. Must be called before
+ * any other function on @p sensor.
+ */
+void pasco2_setup(pasco2_t *sensor, const i2c_device_t *device);
+/**
+ * I2C configuration of the PASCO2 mounted on the board.
+ */
+const i2c_device_t *pasco2_onboard_device(void);
+
+int pasco2_init(pasco2_t *sensor);
+int pasco2_reset_int_status_clear(pasco2_t *sensor);
+/**
+ * Reads the CO2 value together with the data ready flag and clears the
+ * interrupt status, all in a single I2C transaction. *val is valid only if
+ * *out_ready is set.
+ */
+int pasco2_read_measur_val_and_clear(pasco2_t *sensor,
+                                     uint16_t *val,
+                                     bool *out_ready);
+/**
+ * Average number and duration of PASCO2 I2C transactions (including
+ * configuration ones) per measurement cycle since boot.
+ */
+int pasco2_get_bus_stats(pasco2_t *sensor,
+                         double *out_transactions_per_cycle,
+                         double *out_bus_time_us_per_cycle);
+int pasco2_set_measur_period(pasco2_t *sensor, uint16_t period);
+int pasco2_start_single_shot(pasco2_t *sensor);
+int pasco2_reset(pasco2_t *sensor);
 
 #endif // _PASCO2_H_
@@ -0,0 +1,482 @@
+#include <assert.h>
+#include <string.h>
+
+#include "rolling_stats.h"
+
+/*
+ * Length of each window expressed in buckets. A window of N buckets consists
+ * of N - 1 completed buckets and the bucket that is currently being filled.
+ * The shortest window is served directly from the raw sample ring.
+ */
+static const uint16_t WINDOW_BUCKETS[ROLLING_STATS_WINDOW_COUNT] = {
+    [ROLLING_STATS_WINDOW_5_MIN] = 300 / ROLLING_STATS_BUCKET_PERIOD,
+    [ROLLING_STATS_WINDOW_1_HOUR] = 3600 / ROLLING_STATS_BUCKET_PERIOD,
+    [ROLLING_STATS_WINDOW_8_HOURS] = 8 * 3600 / ROLLING_STATS_BUCKET_PERIOD,
+    [ROLLING_STATS_WINDOW_24_HOURS] = 24 * 3600 / ROLLING_STATS_BUCKET_PERIOD
+};
+
+/*
+ * Each deque can hold at most as many indices as there are ring entries
+ * inside its window; all of them share a single slot pool.
+ */
+static const uint16_t DEQUE_CAPACITY[ROLLING_STATS_WINDOW_COUNT] = {
+    [ROLLING_STATS_WINDOW_5_MIN] = ROLLING_STATS_MAX_RAW_SAMPLES,
+    [ROLLING_STATS_WINDOW_1_HOUR] = ROLLING_STATS_COMPLETED_BUCKETS(3600),
+    [ROLLING_STATS_WINDOW_8_HOURS] = ROLLING_STATS_COMPLETED_BUCKETS(8 * 3600),
+    [ROLLING_STATS_WINDOW_24_HOURS] =
+            ROLLING_STATS_COMPLETED_BUCKETS(24 * 3600)
+};
+
+static const uint16_t DEQUE_OFFSET[ROLLING_STATS_WINDOW_COUNT] = {
+    [ROLLING_STATS_WINDOW_5_MIN] = 0,
+    [ROLLING_STATS_WINDOW_1_HOUR] = ROLLING_STATS_MAX_RAW_SAMPLES,
+    [ROLLING_STATS_WINDOW_8_HOURS] = ROLLING_STATS_MAX_RAW_SAMPLES
+                                     + ROLLING_STATS_COMPLETED_BUCKETS(3600),
+    [ROLLING_STATS_WINDOW_24_HOURS] =
+            ROLLING_STATS_MAX_RAW_SAMPLES
+            + ROLLING_STATS_COMPLETED_BUCKETS(3600)
+            + ROLLING_STATS_COMPLETED_BUCKETS(8 * 3600)
+};
+
+static inline bool bucket_has_min_max(const rolling_stats_bucket_t *bucket) {
+    return bucket->min <= bucket->max;
+}
+
+static inline void bucket_reset_min_max(rolling_stats_bucket_t *bucket) {
+    bucket->min = UINT16_MAX;
+    bucket->max = 0;
+}
+
+static inline uint16_t *deque_slots(rolling_stats_t *stats,
+                                    rolling_stats_window_t window,
+                                    bool is_max) {
+    return (is_max ? stats->max_deque_slots : stats->min_deque_slots)
+           + DEQUE_OFFSET[window];
+}
+
+static inline rolling_stats_deque_t *
+deque_get(rolling_stats_t *stats, rolling_stats_window_t window, bool is_max) {
+    return is_max ? &stats->max_deque[window] : &stats->min_deque[window];
+}
+
+// value of a ring entry, as seen by the deque of given window
+static inline uint16_t entry_value(const rolling_stats_t *stats,
+                                   rolling_stats_window_t window,
+                                   bool is_max,
+                                   uint16_t index) {
+    if (window == ROLLING_STATS_WINDOW_5_MIN) {
+        return stats->samples[index].value;
+    }
+    return is_max ? stats->buckets[index].max : stats->buckets[index].min;
+}
+
+static inline uint16_t deque_front(const rolling_stats_t *stats,
+                                   rolling_stats_window_t window,
+                                   bool is_max) {
+    const rolling_stats_deque_t *dq =
+            is_max ? &stats->max_deque[window] : &stats->min_deque[window];
+    const uint16_t *slots =
+            (is_max ? stats->max_deque_slots : stats->min_deque_slots)
+            + DEQUE_OFFSET[window];
+    assert(dq->size);
+    return slots[dq->head];
+}
+
+static inline void deque_pop_front(rolling_stats_t *stats,
+                                   rolling_stats_window_t window,
+                                   bool is_max) {
+    rolling_stats_deque_t *dq = deque_get(stats, window, is_max);
+    assert(dq->size);
+    dq->head = (dq->head + 1) % DEQUE_CAPACITY[window];
+    dq->size--;
+}
+
+static void deque_push_back(rolling_stats_t *stats,
+                            rolling_stats_window_t window,
+                            bool is_max,
+                            uint16_t index) {
+    rolling_stats_deque_t *dq = deque_get(stats, window, is_max);
+    uint16_t *slots = deque_slots(stats, window, is_max);
+    const uint16_t capacity = DEQUE_CAPACITY[window];
+    const uint16_t value = entry_value(stats, window, is_max, index);
+
+    // entries dominated by the new one can never become the extreme again
+    while (dq->size) {
+        const uint16_t back = slots[(dq->head + dq->size - 1) % capacity];
+        const uint16_t back_value = entry_value(stats, window, is_max, back);
+        if (is_max ? back_value > value : back_value < value) {
+            break;
+        }
+        dq->size--;
+    }
+    assert(dq->size < capacity);
+    slots[(dq->head + dq->size) % capacity] = index;
+    dq->size++;
+}
+
+void rolling_stats_init(rolling_stats_t *stats) {
+    assert(stats);
+    memset(stats, 0, sizeof(*stats));
+    bucket_reset_min_max(&stats->current_bucket);
+}
+
+static void expire_bucket_deques(rolling_stats_t *stats,
+                                 rolling_stats_window_t window) {
+    // bucket_head points one past the newest completed bucket
+    for (int is_max = 0; is_max < 2; is_max++) {
+        while (deque_get(stats, window, is_max)->size) {
+            const uint16_t age =
+                    (stats->bucket_head + ROLLING_STATS_BUCKETS - 1
+                     - deque_front(stats, window, is_max))
+                    % ROLLING_STATS_BUCKETS;
+            if (age < DEQUE_CAPACITY[window]) {
+                break;
+            }
+            deque_pop_front(stats, window, is_max);
+        }
+    }
+}
+
+static void close_current_bucket(rolling_stats_t *stats) {
+    const rolling_stats_bucket_t *bucket = &stats->current_bucket;
+    const uint16_t index = stats->bucket_head;
+
+    for (int w = ROLLING_STATS_WINDOW_5_MIN + 1; w < ROLLING_STATS_WINDOW_COUNT;
+         w++) {
+        const uint16_t completed = WINDOW_BUCKETS[w] - 1;
+
+        stats->window_sum[w] += bucket->sum;
+        stats->window_weight[w] += bucket->weight;
+        if (stats->bucket_count >= completed) {
+            // bucket leaving the window
+            const rolling_stats_bucket_t *oldest =
+                    &stats->buckets[(index + ROLLING_STATS_BUCKETS - completed)
+                                    % ROLLING_STATS_BUCKETS];
+            stats->window_sum[w] -= oldest->sum;
+            stats->window_weight[w] -= oldest->weight;
+        }
+    }
+
+    stats->buckets[index] = *bucket;
+    stats->bucket_head = (index + 1) % ROLLING_STATS_BUCKETS;
+    if (stats->bucket_count < ROLLING_STATS_BUCKETS) {
+        stats->bucket_count++;
+    }
+
+    for (int w = ROLLING_STATS_WINDOW_5_MIN + 1; w < ROLLING_STATS_WINDOW_COUNT;
+         w++) {
+        expire_bucket_deques(stats, (rolling_stats_window_t) w);
+        if (bucket_has_min_max(bucket)) {
+            deque_push_back(stats, (rolling_stats_window_t) w, false, index);
+            deque_push_back(stats, (rolling_stats_window_t) w, true, index);
+        }
+    }
+
+    memset(&stats->current_bucket, 0, sizeof(stats->current_bucket));
+    bucket_reset_min_max(&stats->current_bucket);
+}
+
+// removes the raw samples that no longer fit in the 5 minute window, if
+// a sample of given weight is added
+static void trim_samples(rolling_stats_t *stats, uint16_t weight) {
+    uint32_t excess = (uint32_t) stats->sample_weight + weight;
+    if (excess <= ROLLING_STATS_BUCKET_PERIOD) {
+        return;
+    }
+    excess -= ROLLING_STATS_BUCKET_PERIOD;
+
+    while (excess && stats->sample_count) {
+        const uint16_t index = stats->sample_head;
+        rolling_stats_sample_t *oldest = &stats->samples[index];
+
+        if (oldest->weight > excess) {
+            // only part of the oldest sample leaves the window
+            oldest->weight -= excess;
+            stats->sample_weight -= excess;
+            stats->sample_sum -= (uint32_t) oldest->value * excess;
+            return;
+        }
+
+        excess -= oldest->weight;
+        stats->sample_weight -= oldest->weight;
+        stats->sample_sum -= (uint32_t) oldest->value * oldest->weight;
+        stats->sample_head = (index + 1) % ROLLING_STATS_MAX_RAW_SAMPLES;
+        stats->sample_count--;
+        for (int is_max = 0; is_max < 2; is_max++) {
+            if (deque_get(stats, ROLLING_STATS_WINDOW_5_MIN, is_max)->size
+                    && deque_front(stats, ROLLING_STATS_WINDOW_5_MIN, is_max)
+                                   == index) {
+                deque_pop_front(stats, ROLLING_STATS_WINDOW_5_MIN, is_max);
+            }
+        }
+    }
+}
+
+static void add_to_buckets(rolling_stats_t *stats,
+                           uint16_t val,
+                           uint16_t weight) {
+    while (weight) {
+        rolling_stats_bucket_t *bucket = &stats->current_bucket;
+        const uint16_t remaining = ROLLING_STATS_BUCKET_PERIOD - bucket->weight;
+        const uint16_t part = weight < remaining ? weight : remaining;
+
+        bucket->sum += (uint32_t) val * part;
+        bucket->weight += part;
+        if (val < bucket->min) {
+            bucket->min = val;
+        }
+        if (val > bucket->max) {
+            bucket->max = val;
+        }
+        if (bucket->weight == ROLLING_STATS_BUCKET_PERIOD) {
+            close_current_bucket(stats);
+        }
+        weight -= part;
+    }
+}
+
+void rolling_stats_add(rolling_stats_t *stats, uint16_t val, uint16_t weight) {
+    assert(stats);
+
+    if (weight < ROLLING_STATS_MIN_SAMPLE_WEIGHT) {
+        weight = ROLLING_STATS_MIN_SAMPLE_WEIGHT;
+    }
+    const uint16_t raw_weight = weight < ROLLING_STATS_BUCKET_PERIOD
+                                        ? weight
+                                        : ROLLING_STATS_BUCKET_PERIOD;
+
+    trim_samples(stats, raw_weight);
+    // every sample but the oldest one weighs at least
+    // ROLLING_STATS_MIN_SAMPLE_WEIGHT, and there is room for raw_weight
+    assert(stats->sample_count < ROLLING_STATS_MAX_RAW_SAMPLES);
+    const uint16_t index = (stats->sample_head + stats->sample_count)
+                           % ROLLING_STATS_MAX_RAW_SAMPLES;
+    stats->samples[index] = (rolling_stats_sample_t) {
+        .value = val,
+        .weight = raw_weight
+    };
+    stats->sample_count++;
+    stats->sample_weight += raw_weight;
+    stats->sample_sum += (uint32_t) val * raw_weight;
+    deque_push_back(stats, ROLLING_STATS_WINDOW_5_MIN, false, index);
+    deque_push_back(stats, ROLLING_STATS_WINDOW_5_MIN, true, index);
+
+    add_to_buckets(stats, val, weight);
+}
+
+bool rolling_stats_is_empty(const rolling_stats_t *stats) {
+    assert(stats);
+    return !stats->sample_count;
+}
+
+uint16_t rolling_stats_get_last(const rolling_stats_t *stats) {
+    assert(stats);
+    assert(stats->sample_count);
+    return stats->samples[(stats->sample_head + stats->sample_count - 1)
+                          % ROLLING_STATS_MAX_RAW_SAMPLES]
+            .value;
+}
+
+int rolling_stats_get_avg(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          double *out_avg) {
+    assert(stats);
+    assert(out_avg);
+    assert(window < ROLLING_STATS_WINDOW_COUNT);
+
+    if (rolling_stats_is_empty(stats)) {
+        return -1;
+    }
+
+    if (window == ROLLING_STATS_WINDOW_5_MIN) {
+        *out_avg = (double) stats->sample_sum / stats->sample_weight;
+    } else {
+        const uint64_t sum =
+                stats->window_sum[window] + stats->current_bucket.sum;
+        const uint32_t weight =
+                stats->window_weight[window] + stats->current_bucket.weight;
+        *out_avg = (double) sum / weight;
+    }
+    return 0;
+}
+
+static int get_extreme(const rolling_stats_t *stats,
+                       rolling_stats_window_t window,
+                       bool is_max,
+                       uint16_t *out_val) {
+    assert(stats);
+    assert(out_val);
+    assert(window < ROLLING_STATS_WINDOW_COUNT);
+
+    const rolling_stats_deque_t *dq =
+            is_max ? &stats->max_deque[window] : &stats->min_deque[window];
+    bool found = false;
+    uint16_t result = 0;
+
+    if (dq->size) {
+        result = entry_value(stats, window, is_max,
+                             deque_front(stats, window, is_max));
+        found = true;
+    }
+    if (window != ROLLING_STATS_WINDOW_5_MIN
+            && bucket_has_min_max(&stats->current_bucket)) {
+        const uint16_t current = is_max ? stats->current_bucket.max
+                                        : stats->current_bucket.min;
+        if (!found || (is_max ? current > result : current < result)) {
+            result = current;
+        }
+        found = true;
+    }
+    if (!found) {
+        return -1;
+    }
+    *out_val = result;
+    return 0;
+}
+
+int rolling_stats_get_min(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          uint16_t *out_min) {
+    return get_extreme(stats, window, false, out_min);
+}
+
+int rolling_stats_get_max(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          uint16_t *out_max) {
+    return get_extreme(stats, window, true, out_max);
+}
+
+void rolling_stats_reset_min_max(rolling_stats_t *stats) {
+    assert(stats);
+    memset(stats->min_deque, 0, sizeof(stats->min_deque));
+    memset(stats->max_deque, 0, sizeof(stats->max_deque));
+    bucket_reset_min_max(&stats->current_bucket);
+}
+
+void rolling_stats_skip(rolling_stats_t *stats, uint32_t seconds) {
+    assert(stats);
+
+    stats->sample_head = 0;
+    stats->sample_count = 0;
+    stats->sample_weight = 0;
+    stats->sample_sum = 0;
+    stats->min_deque[ROLLING_STATS_WINDOW_5_MIN] =
+            (rolling_stats_deque_t) { 0 };
+    stats->max_deque[ROLLING_STATS_WINDOW_5_MIN] =
+            (rolling_stats_deque_t) { 0 };
+
+    close_current_bucket(stats);
+    // more empty buckets than the ring holds would not change anything
+    uint32_t empty_buckets = seconds / ROLLING_STATS_BUCKET_PERIOD;
+    if (empty_buckets > ROLLING_STATS_BUCKETS) {
+        empty_buckets = ROLLING_STATS_BUCKETS;
+    }
+    for (uint32_t i = 0; i < empty_buckets; i++) {
+        close_current_bucket(stats);
+    }
+}
+
+void rolling_stats_save(const rolling_stats_t *stats,
+                        rolling_stats_snapshot_t *out_snapshot) {
+    assert(stats);
+    assert(out_snapshot);
+    memcpy(out_snapshot->samples, stats->samples, sizeof(stats->samples));
+    out_snapshot->sample_head = stats->sample_head;
+    out_snapshot->sample_count = stats->sample_count;
+    memcpy(out_snapshot->buckets, stats->buckets, sizeof(stats->buckets));
+    out_snapshot->bucket_head = stats->bucket_head;
+    out_snapshot->bucket_count = stats->bucket_count;
+    out_snapshot->current_bucket = stats->current_bucket;
+}
+
+static bool bucket_valid(const rolling_stats_bucket_t *bucket) {
+    return bucket->weight <= ROLLING_STATS_BUCKET_PERIOD
+           && bucket->sum <= (uint32_t) UINT16_MAX * bucket->weight;
+}
+
+static bool snapshot_valid(const rolling_stats_snapshot_t *snapshot) {
+    if (snapshot->sample_head >= ROLLING_STATS_MAX_RAW_SAMPLES
+            || snapshot->sample_count > ROLLING_STATS_MAX_RAW_SAMPLES
+            || snapshot->bucket_head >= ROLLING_STATS_BUCKETS
+            || snapshot->bucket_count > ROLLING_STATS_BUCKETS
+            || !bucket_valid(&snapshot->current_bucket)
+            || snapshot->current_bucket.weight == ROLLING_STATS_BUCKET_PERIOD) {
+        return false;
+    }
+    uint32_t weight = 0;
+    for (uint16_t i = 0; i < snapshot->sample_count; i++) {
+        const rolling_stats_sample_t *sample =
+                &snapshot->samples[(snapshot->sample_head + i)
+                                   % ROLLING_STATS_MAX_RAW_SAMPLES];
+        // only the oldest sample may have been trimmed below the minimum,
+        // otherwise the ring may run out of room
+        if (!sample->weight
+                || (i > 0
+                    && sample->weight < ROLLING_STATS_MIN_SAMPLE_WEIGHT)) {
+            return false;
+        }
+        weight += sample->weight;
+    }
+    if (weight > ROLLING_STATS_BUCKET_PERIOD) {
+        return false;
+    }
+    for (uint16_t i = 0; i < ROLLING_STATS_BUCKETS; i++) {
+        if (!bucket_valid(&snapshot->buckets[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int rolling_stats_load(rolling_stats_t *stats,
+                       const rolling_stats_snapshot_t *snapshot) {
+    assert(stats);
+    assert(snapshot);
+
+    rolling_stats_init(stats);
+    if (!snapshot_valid(snapshot)) {
+        return -1;
+    }
+
+    memcpy(stats->samples, snapshot->samples, sizeof(stats->samples));
+    stats->sample_head = snapshot->sample_head;
+    stats->sample_count = snapshot->sample_count;
+    memcpy(stats->buckets, snapshot->buckets, sizeof(stats->buckets));
+    stats->bucket_head = snapshot->bucket_head;
+    stats->bucket_count = snapshot->bucket_count;
+    stats->current_bucket = snapshot->current_bucket;
+
+    for (uint16_t i = 0; i < stats->sample_count; i++) {
+        const uint16_t index =
+                (stats->sample_head + i) % ROLLING_STATS_MAX_RAW_SAMPLES;
+        const rolling_stats_sample_t *sample = &stats->samples[index];
+        stats->sample_weight += sample->weight;
+        stats->sample_sum += (uint32_t) sample->value * sample->weight;
+        deque_push_back(stats, ROLLING_STATS_WINDOW_5_MIN, false, index);
+        deque_push_back(stats, ROLLING_STATS_WINDOW_5_MIN, true, index);
+    }
+
+    for (int w = ROLLING_STATS_WINDOW_5_MIN + 1; w < ROLLING_STATS_WINDOW_COUNT;
+         w++) {
+        const uint16_t completed = WINDOW_BUCKETS[w] - 1;
+        const uint16_t count =
+                stats->bucket_count < completed ? stats->bucket_count
+                                                : completed;
+        // oldest bucket of the window first, as close_current_bucket() would
+        for (uint16_t age = count; age > 0; age--) {
+            const uint16_t index =
+                    (stats->bucket_head + ROLLING_STATS_BUCKETS - age)
+                    % ROLLING_STATS_BUCKETS;
+            const rolling_stats_bucket_t *bucket = &stats->buckets[index];
+            stats->window_sum[w] += bucket->sum;
+            stats->window_weight[w] += bucket->weight;
+            if (bucket_has_min_max(bucket)) {
+                deque_push_back(stats, (rolling_stats_window_t) w, false,
+                                index);
+                deque_push_back(stats, (rolling_stats_window_t) w, true,
+                                index);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#ifndef _ROLLING_STATS_H_
+#define _ROLLING_STATS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Rolling time-weighted statistics over a stream of samples.
+ *
+ * Every sample carries the number of seconds it stands for (the measurement
+ * period in effect when it was taken), so samples do not need to be evenly
+ * spaced; averages are weighted by time rather than by sample count.
+ *
+ * The most recent bucket worth of raw samples is kept in a ring, which serves
+ * the shortest window exactly, with the oldest sample trimmed to the part of
+ * it that is still inside the window. Longer windows are built from a ring of
+ * completed buckets plus the bucket currently being filled; a sample that
+ * crosses a bucket boundary is split between the buckets. Every window keeps
+ * a running sum, so adding a sample costs O(1) regardless of window length.
+ *
+ * Minimum and maximum of each window are tracked with monotonic deques of
+ * indices into the same rings (amortized O(1) per sample).
+ */
+#define ROLLING_STATS_BUCKET_PERIOD 300 // in seconds
+// shortest period samples are expected at, in seconds; bounds the raw ring
+#define ROLLING_STATS_MIN_SAMPLE_WEIGHT 5
+#define ROLLING_STATS_MAX_RAW_SAMPLES \
+    (ROLLING_STATS_BUCKET_PERIOD / ROLLING_STATS_MIN_SAMPLE_WEIGHT)
+#define ROLLING_STATS_MAX_WINDOW_PERIOD (24 * 3600) // in seconds
+#define ROLLING_STATS_BUCKETS \
+    (ROLLING_STATS_MAX_WINDOW_PERIOD / ROLLING_STATS_BUCKET_PERIOD)
+
+// number of completed buckets belonging to a window of given period
+#define ROLLING_STATS_COMPLETED_BUCKETS(period) \
+    ((period) / ROLLING_STATS_BUCKET_PERIOD - 1)
+#define ROLLING_STATS_DEQUE_SLOTS                     \
+    (ROLLING_STATS_MAX_RAW_SAMPLES                    \
+     + ROLLING_STATS_COMPLETED_BUCKETS(3600)          \
+     + ROLLING_STATS_COMPLETED_BUCKETS(8 * 3600)      \
+     + ROLLING_STATS_COMPLETED_BUCKETS(24 * 3600))
+
+typedef enum {
+    ROLLING_STATS_WINDOW_5_MIN,
+    ROLLING_STATS_WINDOW_1_HOUR,
+    ROLLING_STATS_WINDOW_8_HOURS,
+    ROLLING_STATS_WINDOW_24_HOURS,
+    ROLLING_STATS_WINDOW_COUNT
+} rolling_stats_window_t;
+
+typedef struct rolling_stats_sample_struct {
+    uint16_t value;
+    uint16_t weight; // in seconds
+} rolling_stats_sample_t;
+
+typedef struct rolling_stats_bucket_struct {
+    uint32_t sum; // of values multiplied by their weights
+    uint16_t weight;
+    // min > max if no sample arrived since the last min/max reset
+    uint16_t min;
+    uint16_t max;
+} rolling_stats_bucket_t;
+
+typedef struct rolling_stats_deque_struct {
+    uint16_t head;
+    uint16_t size;
+} rolling_stats_deque_t;
+
+typedef struct rolling_stats_struct {
+    rolling_stats_sample_t samples[ROLLING_STATS_MAX_RAW_SAMPLES];
+    uint16_t sample_head; // oldest sample
+    uint16_t sample_count;
+    uint16_t sample_weight;
+    uint32_t sample_sum;
+
+    rolling_stats_bucket_t buckets[ROLLING_STATS_BUCKETS];
+    uint16_t bucket_head;
+    uint16_t bucket_count;
+    rolling_stats_bucket_t current_bucket;
+
+    // sums of the completed buckets belonging to each window
+    uint64_t window_sum[ROLLING_STATS_WINDOW_COUNT];
+    uint32_t window_weight[ROLLING_STATS_WINDOW_COUNT];
+
+    // ring indices ordered by increasing (min) or decreasing (max) value
+    rolling_stats_deque_t min_deque[ROLLING_STATS_WINDOW_COUNT];
+    rolling_stats_deque_t max_deque[ROLLING_STATS_WINDOW_COUNT];
+    uint16_t min_deque_slots[ROLLING_STATS_DEQUE_SLOTS];
+    uint16_t max_deque_slots[ROLLING_STATS_DEQUE_SLOTS];
+} rolling_stats_t;
+
+/**
+ * Part of rolling_stats_t needed to rebuild it, e.g. after a reboot. Running
+ * sums and min/max deques are derived from it on load.
+ */
+typedef struct rolling_stats_snapshot_struct {
+    rolling_stats_sample_t samples[ROLLING_STATS_MAX_RAW_SAMPLES];
+    uint16_t sample_head;
+    uint16_t sample_count;
+    rolling_stats_bucket_t buckets[ROLLING_STATS_BUCKETS];
+    uint16_t bucket_head;
+    uint16_t bucket_count;
+    rolling_stats_bucket_t current_bucket;
+} rolling_stats_snapshot_t;
+
+void rolling_stats_init(rolling_stats_t *stats);
+/**
+ * Adds a sample standing for @p weight seconds. Weights below
+ * ROLLING_STATS_MIN_SAMPLE_WEIGHT are rounded up to it.
+ */
+void rolling_stats_add(rolling_stats_t *stats, uint16_t val, uint16_t weight);
+bool rolling_stats_is_empty(const rolling_stats_t *stats);
+uint16_t rolling_stats_get_last(const rolling_stats_t *stats);
+int rolling_stats_get_avg(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          double *out_avg);
+int rolling_stats_get_min(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          uint16_t *out_min);
+int rolling_stats_get_max(const rolling_stats_t *stats,
+                          rolling_stats_window_t window,
+                          uint16_t *out_max);
+void rolling_stats_reset_min_max(rolling_stats_t *stats);
+/**
+ * Accounts for @p seconds without samples, e.g. while the device was off.
+ * The raw samples are dropped, as the 5 minute window no longer holds them
+ * all, and the gap is added to the longer windows in whole buckets of empty
+ * time, starting with the current bucket.
+ */
+void rolling_stats_skip(rolling_stats_t *stats, uint32_t seconds);
+
+void rolling_stats_save(const rolling_stats_t *stats,
+                        rolling_stats_snapshot_t *out_snapshot);
+/**
+ * Replaces the contents of @p stats with @p snapshot. If the snapshot is not
+ * consistent, @p stats is left empty and -1 is returned.
+ */
+int rolling_stats_load(rolling_stats_t *stats,
+                       const rolling_stats_snapshot_t *snapshot);
+
+#endif // _ROLLING_STATS_H_
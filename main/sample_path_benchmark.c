@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+
+#include "change_filter.h"
+#include "sample_path_benchmark.h"
+#include "window_stats.h"
+
+// deadband of the temperature sensor, in thousandths of Cel
+#define ABS_DEADBAND 200
+
+static const change_filter_config_t FILTER_CONFIG = {
+    .abs_deadband = ABS_DEADBAND,
+    .min_interval = { .seconds = 5 }
+};
+
+// keeps the results, so that the compiler does not drop the computations
+static volatile double sink;
+
+// raw readings about 24 Cel, with noise mostly below the deadband
+static uint16_t raw_sample(uint32_t i) {
+    return (uint16_t) (26000 + ((i * 2654435761U) >> 26));
+}
+
+// same formula as in shtc3.c
+static int32_t fixed_point_temperature(uint16_t raw) {
+    return (int32_t) ((21875U * raw + (1U << 12)) >> 13) - 45000;
+}
+
+static uint32_t run_fixed_point(sample_path_benchmark_clock_t *clock,
+                                uint32_t samples) {
+    change_filter_t filter;
+    change_filter_init(&filter, &FILTER_CONFIG);
+    window_stats_t stats;
+    window_stats_reset(&stats);
+
+    const uint32_t start = clock();
+    for (uint32_t i = 0; i < samples; i++) {
+        const int32_t value = fixed_point_temperature(raw_sample(i));
+        (void) change_filter_update(&filter, value);
+        window_stats_add(&stats, value);
+    }
+    const uint32_t ticks = clock() - start;
+    sink = window_stats_stddev(&stats);
+    return ticks;
+}
+
+/*
+ * The same steps as done before samples were fixed point: the conversion
+ * and the change filter in double, statistics with Welford's algorithm.
+ */
+typedef struct {
+    bool has_reported;
+    double reported_value;
+} double_filter_t;
+
+typedef struct {
+    uint32_t count;
+    double mean;
+    double m2;
+} double_stats_t;
+
+static double double_temperature(uint16_t raw) {
+    return -45.0 + 175.0 * raw / 65536.0;
+}
+
+static bool double_filter_update(double_filter_t *filter, double value) {
+    if (filter->has_reported
+            && fabs(value - filter->reported_value)
+                           < ABS_DEADBAND / 1000.0) {
+        return false;
+    }
+    filter->has_reported = true;
+    filter->reported_value = value;
+    return true;
+}
+
+static void double_stats_add(double_stats_t *stats, double value) {
+    stats->count++;
+    const double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+static uint32_t run_double(sample_path_benchmark_clock_t *clock,
+                           uint32_t samples) {
+    double_filter_t filter = { 0 };
+    double_stats_t stats = { 0 };
+
+    const uint32_t start = clock();
+    for (uint32_t i = 0; i < samples; i++) {
+        const double value = double_temperature(raw_sample(i));
+        (void) double_filter_update(&filter, value);
+        double_stats_add(&stats, value);
+    }
+    const uint32_t ticks = clock() - start;
+    sink = sqrt(stats.m2 / stats.count) + filter.reported_value;
+    return ticks;
+}
+
+void sample_path_benchmark_run(sample_path_benchmark_clock_t *clock,
+                               uint32_t samples,
+                               sample_path_benchmark_result_t *out_result) {
+    assert(clock);
+    assert(samples);
+    assert(out_result);
+
+    out_result->fixed_point_ticks = UINT32_MAX;
+    out_result->double_ticks = UINT32_MAX;
+    for (int i = 0; i < SAMPLE_PATH_BENCHMARK_REPEATS; i++) {
+        const uint32_t fixed_point_ticks = run_fixed_point(clock, samples);
+        if (fixed_point_ticks < out_result->fixed_point_ticks) {
+            out_result->fixed_point_ticks = fixed_point_ticks;
+        }
+        const uint32_t double_ticks = run_double(clock, samples);
+        if (double_ticks < out_result->double_ticks) {
+            out_result->double_ticks = double_ticks;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef _SAMPLE_PATH_BENCHMARK_H_
+#define _SAMPLE_PATH_BENCHMARK_H_
+
+#include <stdint.h>
+
+/*
+ * Microbenchmark of the work done for every sensor sample: converting a raw
+ * SHTC3 temperature reading, passing it through the change filter and adding
+ * it to the window statistics. It is run once in fixed point, as the firmware
+ * does, and once with the same steps in double precision, which the ESP32
+ * emulates in software. Shared by the host benchmark in test/ and the
+ * on-target one enabled with CONFIG_ANJAY_CLIENT_SAMPLE_PATH_BENCHMARK.
+ */
+#define SAMPLE_PATH_BENCHMARK_REPEATS 5
+
+// a free running counter, e.g. of CPU cycles, allowed to wrap around
+typedef uint32_t sample_path_benchmark_clock_t(void);
+
+typedef struct sample_path_benchmark_result_struct {
+    // best of SAMPLE_PATH_BENCHMARK_REPEATS runs, in ticks of the clock
+    uint32_t fixed_point_ticks;
+    uint32_t double_ticks;
+} sample_path_benchmark_result_t;
+
+/**
+ * Runs both variants over @p samples samples, timed with @p clock. The whole
+ * run must take less than a wraparound of the clock.
+ */
+void sample_path_benchmark_run(sample_path_benchmark_clock_t *clock,
+                               uint32_t samples,
+                               sample_path_benchmark_result_t *out_result);
+
+#endif // _SAMPLE_PATH_BENCHMARK_H_
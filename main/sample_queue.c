@@ -0,0 +1,49 @@
+#include <assert.h>
+
+#include "sample_queue.h"
+
+#define INDEX(Counter) ((Counter) & (SAMPLE_QUEUE_CAPACITY - 1))
+
+_Static_assert(!(SAMPLE_QUEUE_CAPACITY & (SAMPLE_QUEUE_CAPACITY - 1)),
+               "SAMPLE_QUEUE_CAPACITY must be a power of 2");
+
+bool sample_queue_push(sample_queue_t *queue,
+                       const sample_queue_entry_t *entry) {
+    assert(queue);
+    assert(entry);
+
+    const unsigned head =
+            atomic_load_explicit(&queue->head, memory_order_relaxed);
+    const unsigned tail =
+            atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == SAMPLE_QUEUE_CAPACITY) {
+        atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    queue->entries[INDEX(head)] = *entry;
+    // publish the entry only once it is fully written
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool sample_queue_pop(sample_queue_t *queue, sample_queue_entry_t *out_entry) {
+    assert(queue);
+    assert(out_entry);
+
+    const unsigned tail =
+            atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    const unsigned head =
+            atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    *out_entry = queue->entries[INDEX(tail)];
+    // the slot may be reused by the producer from now on
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+unsigned sample_queue_dropped(sample_queue_t *queue) {
+    assert(queue);
+    return atomic_load_explicit(&queue->dropped, memory_order_relaxed);
+}
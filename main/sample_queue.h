@@ -0,0 +1,41 @@
+#ifndef _SAMPLE_QUEUE_H_
+#define _SAMPLE_QUEUE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <avsystem/commons/avs_time.h>
+
+/*
+ * Lock-free single producer, single consumer ring of timestamped CO2 samples.
+ *
+ * Exactly one task may call sample_queue_push() and exactly one (other) task
+ * may call sample_queue_pop(); neither of them ever blocks. If the ring is
+ * full, the new sample is dropped and counted. A zero-initialized queue is
+ * empty and ready to use.
+ */
+#define SAMPLE_QUEUE_CAPACITY 16 // must be a power of 2
+
+typedef struct sample_queue_entry_struct {
+    avs_time_real_t timestamp;
+    uint16_t iid;    // Air quality object instance the sample belongs to
+    uint16_t co2;    // in ppm
+    uint16_t period; // in seconds, measurement period of the sample
+} sample_queue_entry_t;
+
+typedef struct sample_queue_struct {
+    sample_queue_entry_t entries[SAMPLE_QUEUE_CAPACITY];
+    // free-running counters, only the producer writes head and only the
+    // consumer writes tail
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint dropped;
+} sample_queue_t;
+
+bool sample_queue_push(sample_queue_t *queue,
+                       const sample_queue_entry_t *entry);
+bool sample_queue_pop(sample_queue_t *queue, sample_queue_entry_t *out_entry);
+unsigned sample_queue_dropped(sample_queue_t *queue);
+
+#endif // _SAMPLE_QUEUE_H_
@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#include "objects/mpu6886.h"
+#include "sensor_cache.h"
+#include "shtc3.h"
+
+typedef struct {
+    // reads all values of the device
+    int (*read)(sensor_value_t *out_values);
+    uint32_t max_age_ms;
+    bool valid;
+    avs_time_monotonic_t timestamp;
+    sensor_value_t values[SENSOR_CACHE_MAX_VALUES];
+} sensor_cache_entry_t;
+
+static struct {
+    pthread_mutex_t mutex;
+    sensor_cache_entry_t entries[SENSOR_CACHE_DEVICE_COUNT];
+} cache = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .entries = {
+#if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+        [SENSOR_CACHE_DEVICE_SHTC3] = {
+            .read = shtc3_read_data,
+            .max_age_ms = CONFIG_ANJAY_CLIENT_SENSOR_CACHE_MAX_AGE
+        },
+#endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
+#if CONFIG_ANJAY_CLIENT_BOARD_M5STICKC_PLUS
+        [SENSOR_CACHE_DEVICE_MPU6886] = {
+            .read = mpu6886_read_data,
+            .max_age_ms = CONFIG_ANJAY_CLIENT_SENSOR_CACHE_MAX_AGE
+        },
+#endif // CONFIG_ANJAY_CLIENT_BOARD_M5STICKC_PLUS
+    }
+};
+
+static bool is_fresh(const sensor_cache_entry_t *entry,
+                     avs_time_monotonic_t now) {
+    return entry->valid
+           && avs_time_duration_less(
+                      avs_time_monotonic_diff(now, entry->timestamp),
+                      avs_time_duration_from_scalar(entry->max_age_ms,
+                                                    AVS_TIME_MS));
+}
+
+void sensor_cache_put(sensor_cache_device_t device,
+                      const sensor_value_t *values,
+                      uint8_t count,
+                      avs_time_monotonic_t timestamp) {
+    assert(device < SENSOR_CACHE_DEVICE_COUNT);
+    assert(count <= SENSOR_CACHE_MAX_VALUES);
+    assert(values);
+
+    pthread_mutex_lock(&cache.mutex);
+    sensor_cache_entry_t *entry = &cache.entries[device];
+    memcpy(entry->values, values, count * sizeof(sensor_value_t));
+    entry->timestamp = timestamp;
+    entry->valid = true;
+    pthread_mutex_unlock(&cache.mutex);
+}
+
+static void copy_sample(const sensor_cache_entry_t *entry,
+                        uint8_t first,
+                        uint8_t count,
+                        sensor_value_t *out_values,
+                        avs_time_monotonic_t *out_timestamp) {
+    memcpy(out_values, &entry->values[first], count * sizeof(sensor_value_t));
+    if (out_timestamp) {
+        *out_timestamp = entry->timestamp;
+    }
+}
+
+int sensor_cache_get(sensor_cache_device_t device,
+                     uint8_t first,
+                     uint8_t count,
+                     sensor_value_t *out_values,
+                     avs_time_monotonic_t *out_timestamp) {
+    assert(device < SENSOR_CACHE_DEVICE_COUNT);
+    assert(first + count <= SENSOR_CACHE_MAX_VALUES);
+    assert(out_values);
+
+    // the lock is held during the read, so that concurrent readers of
+    // a stale sample do not read the device twice
+    pthread_mutex_lock(&cache.mutex);
+    sensor_cache_entry_t *entry = &cache.entries[device];
+    avs_time_monotonic_t now = avs_time_monotonic_now();
+    sensor_value_t values[SENSOR_CACHE_MAX_VALUES];
+    if (!is_fresh(entry, now) && entry->read && !entry->read(values)) {
+        memcpy(entry->values, values, sizeof(values));
+        entry->timestamp = now;
+        entry->valid = true;
+    }
+
+    int result = -1;
+    if (is_fresh(entry, now)) {
+        copy_sample(entry, first, count, out_values, out_timestamp);
+        result = 0;
+    }
+    pthread_mutex_unlock(&cache.mutex);
+    return result;
+}
+
+int sensor_cache_peek(sensor_cache_device_t device,
+                      uint8_t first,
+                      uint8_t count,
+                      sensor_value_t *out_values,
+                      avs_time_monotonic_t *out_timestamp) {
+    assert(device < SENSOR_CACHE_DEVICE_COUNT);
+    assert(first + count <= SENSOR_CACHE_MAX_VALUES);
+    assert(out_values);
+
+    pthread_mutex_lock(&cache.mutex);
+    const sensor_cache_entry_t *entry = &cache.entries[device];
+    int result = -1;
+    if (entry->valid) {
+        copy_sample(entry, first, count, out_values, out_timestamp);
+        result = 0;
+    }
+    pthread_mutex_unlock(&cache.mutex);
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef _SENSOR_CACHE_H_
+#define _SENSOR_CACHE_H_
+
+#include <stdint.h>
+
+#include <avsystem/commons/avs_time.h>
+
+#include "sensor_value.h"
+
+/*
+ * Timestamped cache of the values measured by each physical sensor device.
+ *
+ * A device feeds several logical sensors (e.g. SHTC3 measures temperature
+ * and humidity at once), all of which read their values from here, so a
+ * single bus transaction serves all of them. Devices are read on demand,
+ * again only once their sample is older than
+ * CONFIG_ANJAY_CLIENT_SENSOR_CACHE_MAX_AGE; samples taken elsewhere, e.g.
+ * during initialization, may be stored with sensor_cache_put().
+ */
+#define SENSOR_CACHE_MAX_VALUES 7
+
+typedef enum {
+    SENSOR_CACHE_DEVICE_SHTC3,
+    SENSOR_CACHE_DEVICE_MPU6886,
+    SENSOR_CACHE_DEVICE_COUNT
+} sensor_cache_device_t;
+
+// indices of values measured by each device
+enum {
+    SENSOR_CACHE_SHTC3_TEMPERATURE,
+    SENSOR_CACHE_SHTC3_HUMIDITY
+};
+enum {
+    SENSOR_CACHE_MPU6886_ACCEL_X,
+    SENSOR_CACHE_MPU6886_ACCEL_Y,
+    SENSOR_CACHE_MPU6886_ACCEL_Z,
+    SENSOR_CACHE_MPU6886_GYRO_X,
+    SENSOR_CACHE_MPU6886_GYRO_Y,
+    SENSOR_CACHE_MPU6886_GYRO_Z,
+    SENSOR_CACHE_MPU6886_TEMPERATURE
+};
+
+/**
+ * Stores the first @p count values of a sample of @p device taken at
+ * @p timestamp.
+ */
+void sensor_cache_put(sensor_cache_device_t device,
+                      const sensor_value_t *values,
+                      uint8_t count,
+                      avs_time_monotonic_t timestamp);
+
+/**
+ * Copies @p count values of @p device, starting at @p first, to
+ * @p out_values, reading the device first if the cached sample is too old.
+ * @p out_timestamp, if not NULL, is set to the time the sample was taken.
+ * Returns -1 if no fresh sample is available.
+ */
+int sensor_cache_get(sensor_cache_device_t device,
+                     uint8_t first,
+                     uint8_t count,
+                     sensor_value_t *out_values,
+                     avs_time_monotonic_t *out_timestamp);
+
+/**
+ * Like sensor_cache_get(), but never reads the device: the last sample is
+ * returned however old it is. Returns -1 if there is no sample yet.
+ */
+int sensor_cache_peek(sensor_cache_device_t device,
+                      uint8_t first,
+                      uint8_t count,
+                      sensor_value_t *out_values,
+                      avs_time_monotonic_t *out_timestamp);
+
+#endif // _SENSOR_CACHE_H_
@@ -0,0 +1,28 @@
+#ifndef _SENSOR_VALUE_H_
+#define _SENSOR_VALUE_H_
+
+#include <stdint.h>
+
+/*
+ * Sensor samples are fixed-point numbers of thousandths of their unit, e.g.
+ * 21500 stands for 21.5 Cel. The FPU of the ESP32 handles single precision
+ * only, so double arithmetic is emulated in software; samples are acquired,
+ * filtered and aggregated as integers and converted only when handed over to
+ * Anjay or displayed.
+ */
+typedef int32_t sensor_value_t;
+
+#define SENSOR_VALUE_SCALE 1000
+
+#define SENSOR_VALUE_TO_DOUBLE(Value) ((double) (Value) / SENSOR_VALUE_SCALE)
+#define SENSOR_VALUE_TO_FLOAT(Value) ((float) (Value) / SENSOR_VALUE_SCALE)
+
+/**
+ * Rounds @p Value to the nearest multiple of 1/@p Scale of the unit, which
+ * must divide SENSOR_VALUE_SCALE, e.g. to tenths with @p Scale 10.
+ */
+#define SENSOR_VALUE_ROUND(Value, Scale)                                     \
+    (((Value) + ((Value) < 0 ? -1 : 1) * (SENSOR_VALUE_SCALE / (Scale) / 2)) \
+     / (SENSOR_VALUE_SCALE / (Scale)))
+
+#endif // _SENSOR_VALUE_H_
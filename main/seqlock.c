@@ -0,0 +1,45 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "seqlock.h"
+
+// copy that readers take at given sequence
+#define COPY(Copies, Sequence, Size) ((Copies) + ((Sequence) % 2) * (Size))
+
+void seqlock_write(seqlock_t *lock,
+                   void *copies,
+                   const void *value,
+                   size_t size) {
+    assert(lock);
+    assert(copies);
+    assert(value);
+
+    for (int i = 0; i < 2; i++) {
+        // readers move to the other copy before this one is touched; full
+        // fences order the sequence update against the data stores around it
+        const unsigned sequence = atomic_fetch_add_explicit(
+                &lock->sequence, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        memcpy(COPY((uint8_t *) copies, sequence, size), value, size);
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+}
+
+void seqlock_read(seqlock_t *lock,
+                  const void *copies,
+                  void *out_value,
+                  size_t size) {
+    assert(lock);
+    assert(copies);
+    assert(out_value);
+
+    unsigned sequence;
+    do {
+        sequence = atomic_load_explicit(&lock->sequence, memory_order_acquire);
+        memcpy(out_value, COPY((const uint8_t *) copies, sequence, size),
+               size);
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&lock->sequence, memory_order_relaxed)
+             != sequence);
+}
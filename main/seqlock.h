@@ -0,0 +1,40 @@
+#ifndef _SEQLOCK_H_
+#define _SEQLOCK_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Lock-free publication of a value by a single writer to any number of
+ * readers, none of which ever blocks.
+ *
+ * The value is kept in two copies. The writer increments the sequence before
+ * updating each of them, so that readers always take the copy that is not
+ * being written (the one selected by the lowest bit of the sequence). A
+ * reader retries only if the writer updated both copies while it was reading,
+ * so a writer preempted in the middle of an update never stalls readers.
+ *
+ * A zero-initialized seqlock holds a zero-initialized value.
+ */
+typedef struct seqlock_struct {
+    atomic_uint sequence;
+} seqlock_t;
+
+/**
+ * Stores @p value in @p copies, an array of two values of @p size bytes
+ * guarded by @p lock. Must not be called concurrently for the same @p lock.
+ */
+void seqlock_write(seqlock_t *lock,
+                   void *copies,
+                   const void *value,
+                   size_t size);
+
+/**
+ * Copies the last value stored with seqlock_write() to @p out_value.
+ */
+void seqlock_read(seqlock_t *lock,
+                  const void *copies,
+                  void *out_value,
+                  size_t size);
+
+#endif // _SEQLOCK_H_
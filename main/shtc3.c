@@ -13,10 +13,19 @@
 
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "i2c_wrapper.h"
 #include "oled_page.h"
+#include "sensor_cache.h"
 #include "shtc3.h"
 
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include <avsystem/commons/avs_defs.h>
+#include <avsystem/commons/avs_time.h>
+
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
 #    define CRC_POLYNOMIAL 0x131 // P(x) = x^8 + x^5 + x^4 + 1 = 100110001
@@ -33,13 +42,38 @@
         0x58E0 // meas. read RH first, clock stretching disabled
 #    define MEAS_RH_T_CLOCKSTR \
         0x5C24 // meas. read RH first, clock stretching enabled
+#    define MEAS_T_RH_POLLING_LP \
+        0x609C // low power meas. read T first, clock stretching disabled
+#    define MEAS_T_RH_CLOCKSTR_LP \
+        0x6458 // low power meas. read T first, clock stretching enabled
+
+// wakeup takes at most 240 us
+#    define WAKEUP_TIME_MS 1
+#    define READ_RETRY_DELAY_MS 1
+#    define MAX_READ_ATTEMPTS 20
+/*
+ * SCL may be held low by the sensor for the whole normal mode measurement
+ * (at most 12.1 ms); this is the longest timeout of the ESP32 I2C controller,
+ * in APB clock cycles (about 13 ms).
+ */
+#    define CLOCK_STRETCHING_BUS_TIMEOUT 0xFFFFF
+
+#    if CONFIG_ANJAY_CLIENT_SHTC3_PROFILE_NORMAL_CLOCK_STRETCHING
+#        define DEFAULT_PROFILE SHTC3_PROFILE_NORMAL_CLOCK_STRETCHING
+#    elif CONFIG_ANJAY_CLIENT_SHTC3_PROFILE_LOW_POWER_POLLING
+#        define DEFAULT_PROFILE SHTC3_PROFILE_LOW_POWER_POLLING
+#    elif CONFIG_ANJAY_CLIENT_SHTC3_PROFILE_LOW_POWER_CLOCK_STRETCHING
+#        define DEFAULT_PROFILE SHTC3_PROFILE_LOW_POWER_CLOCK_STRETCHING
+#    else
+#        define DEFAULT_PROFILE SHTC3_PROFILE_NORMAL_POLLING
+#    endif
 
 static const char *TAG = "shtc3";
 
 static int
 shtc3_check_crc(uint8_t data[], uint8_t nbrOfBytes, uint8_t checksum);
-static double shtc3_calc_temperature(uint16_t rawValue);
-static double shtc3_calc_humidity(uint16_t rawValue);
+static sensor_value_t shtc3_calc_temperature(uint16_t rawValue);
+static sensor_value_t shtc3_calc_humidity(uint16_t rawValue);
 
 #    define I2C_ADDRESS_SHTC3 0x70
 #    define I2C_SDA_SHTC3 21
@@ -59,6 +93,47 @@ static i2c_device_t shtc3_device = {
     .address = I2C_ADDRESS_SHTC3
 };
 
+static const struct {
+    uint16_t command;
+    // time after which the result is read; clock stretched reads are issued
+    // right away, as the sensor holds the bus until the result is ready
+    uint32_t measurement_time_ms;
+} PROFILES[SHTC3_PROFILE_COUNT] = {
+    // normal mode measurement takes at most 12.1 ms, low power one 0.8 ms
+    [SHTC3_PROFILE_NORMAL_POLLING] = { MEAS_T_RH_POLLING, 13 },
+    [SHTC3_PROFILE_NORMAL_CLOCK_STRETCHING] = { MEAS_T_RH_CLOCKSTR, 0 },
+    [SHTC3_PROFILE_LOW_POWER_POLLING] = { MEAS_T_RH_POLLING_LP, 1 },
+    [SHTC3_PROFILE_LOW_POWER_CLOCK_STRETCHING] = { MEAS_T_RH_CLOCKSTR_LP, 0 }
+};
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t measurements; // successful ones
+    int64_t latency_us;
+    int64_t bus_time_us;
+} profile_stats_t;
+
+static struct {
+    pthread_mutex_t mutex;
+    shtc3_profile_t selected;
+    profile_stats_t stats[SHTC3_PROFILE_COUNT];
+} profiles = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .selected = DEFAULT_PROFILE
+};
+
+/*
+ * A measurement cycle wakes the sensor up, measures with the selected profile
+ * and puts the sensor back to sleep. Cycles are run on demand by the sensor
+ * cache, i.e. by the sensor acquisition task, so that only that task ever
+ * waits for the sensor.
+ */
+typedef struct {
+    shtc3_profile_t profile;
+    int64_t latency_us;  // -1 until the result is read
+    int64_t bus_time_us;
+} measurement_cycle_t;
+
 static int shtc3_write_command(const i2c_device_t *const device,
                                const uint16_t command) {
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -118,14 +193,68 @@ static int shtc3_read_hum_temp(const i2c_device_t *const device,
     }
 }
 
-int shtc3_get_temp_and_humi(double *temp, double *humi) {
-    uint8_t data[6];
+static void store_measurement(sensor_value_t temp, sensor_value_t humi) {
+    sensor_value_t values[2];
+    values[SENSOR_CACHE_SHTC3_TEMPERATURE] = temp;
+    values[SENSOR_CACHE_SHTC3_HUMIDITY] = humi;
+    sensor_cache_put(SENSOR_CACHE_DEVICE_SHTC3, values,
+                     AVS_ARRAY_SIZE(values), avs_time_monotonic_now());
+}
 
-    if (shtc3_write_command(&shtc3_device, MEAS_T_RH_CLOCKSTR)
-            || shtc3_read_hum_temp(&shtc3_device, data)) {
+static int measurement_command(measurement_cycle_t *cycle,
+                               uint16_t command) {
+    const int64_t start_us = esp_timer_get_time();
+    int result = shtc3_write_command(&shtc3_device, command);
+    cycle->bus_time_us += esp_timer_get_time() - start_us;
+    return result;
+}
+
+static int measurement_read(measurement_cycle_t *cycle, uint8_t *data) {
+    const int64_t start_us = esp_timer_get_time();
+    int result = shtc3_read_hum_temp(&shtc3_device, data);
+    cycle->bus_time_us += esp_timer_get_time() - start_us;
+    return result;
+}
+
+/*
+ * The sensor holds SCL low until the result is ready, so the bus timeout is
+ * raised for this transaction only; the PASCO2 on the same bus keeps the
+ * default one. Only this transaction stretches the clock, so a PASCO2
+ * transaction overlapping the change at most gets a longer timeout.
+ */
+static int stretched_read(measurement_cycle_t *cycle, uint8_t *data) {
+    int timeout;
+    if (i2c_get_timeout(shtc3_device.port, &timeout)
+            || i2c_set_timeout(shtc3_device.port,
+                               CLOCK_STRETCHING_BUS_TIMEOUT)) {
+        ESP_LOGW(TAG, "shtc3 clock stretching timeout could not be set");
         return -1;
     }
+    int result = measurement_read(cycle, data);
+    if (i2c_set_timeout(shtc3_device.port, timeout)) {
+        ESP_LOGW(TAG, "shtc3 bus timeout could not be restored");
+    }
+    return result;
+}
 
+static void finish_measurement(measurement_cycle_t *cycle) {
+    if (measurement_command(cycle, SLEEP)) {
+        ESP_LOGW(TAG, "shtc3_sleep has failed");
+    }
+
+    pthread_mutex_lock(&profiles.mutex);
+    profile_stats_t *stats = &profiles.stats[cycle->profile];
+    stats->cycles++;
+    stats->bus_time_us += cycle->bus_time_us;
+    if (cycle->latency_us >= 0) {
+        stats->measurements++;
+        stats->latency_us += cycle->latency_us;
+    }
+    pthread_mutex_unlock(&profiles.mutex);
+}
+
+static int
+shtc3_decode(uint8_t *data, sensor_value_t *temp, sensor_value_t *humi) {
     if (shtc3_check_crc(data, 2, data[2])
             || shtc3_check_crc(&data[3], 2, data[5])) {
         return -1;
@@ -137,7 +266,19 @@ int shtc3_get_temp_and_humi(double *temp, double *humi) {
     return 0;
 }
 
-int shtc3_get_temp_and_humi_polling(double *temp, double *humi) {
+int shtc3_get_temp_and_humi(sensor_value_t *temp, sensor_value_t *humi) {
+    uint8_t data[6];
+
+    if (shtc3_write_command(&shtc3_device, MEAS_T_RH_CLOCKSTR)
+            || shtc3_read_hum_temp(&shtc3_device, data)) {
+        return -1;
+    }
+
+    return shtc3_decode(data, temp, humi);
+}
+
+int shtc3_get_temp_and_humi_polling(sensor_value_t *temp,
+                                    sensor_value_t *humi) {
     int error;
     uint8_t maxPolling = 20;
     uint8_t data[6];
@@ -156,51 +297,128 @@ int shtc3_get_temp_and_humi_polling(double *temp, double *humi) {
         }
         vTaskDelay(pdMS_TO_TICKS(1));
     }
-
-    if (shtc3_check_crc(data, 2, data[2])
-            || shtc3_check_crc(&data[3], 2, data[5])) {
+    if (error || shtc3_decode(data, temp, humi)) {
         return -1;
     }
 
-    *temp = shtc3_calc_temperature(((uint16_t) data[0] << 8) + data[1]);
-    *humi = shtc3_calc_humidity(((uint16_t) data[3] << 8) + data[4]);
-
+    store_measurement(*temp, *humi);
     return 0;
 }
 
-static double current_temp, current_humi;
+// waits at least @p ms, rounded up to whole ticks
+static void wait_ms(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms) + 1);
+}
 
-int temperature_read_data(void) {
-    if (shtc3_wakeup()) {
-        ESP_LOGW(TAG, "shtc3_wakeup has failed");
+static int measure(measurement_cycle_t *cycle,
+                   sensor_value_t *temp,
+                   sensor_value_t *humi) {
+    if (measurement_command(cycle, WAKEUP)) {
+        ESP_LOGW(TAG, "shtc3 wakeup has failed");
         return -1;
     }
+    wait_ms(WAKEUP_TIME_MS);
 
-    if (shtc3_get_temp_and_humi_polling(&current_temp, &current_humi)) {
-        ESP_LOGW(TAG, "shtc3_get_temp_and_humi has failed");
+    // measure, read temperature first
+    const int64_t started_at_us = esp_timer_get_time();
+    if (measurement_command(cycle, PROFILES[cycle->profile].command)) {
+        ESP_LOGW(TAG, "shtc3 measurement start has failed");
         return -1;
     }
 
-    if (shtc3_sleep()) {
-        ESP_LOGW(TAG, "shtc3_sleep has failed");
+    uint8_t data[6];
+    if (!PROFILES[cycle->profile].measurement_time_ms) {
+        if (stretched_read(cycle, data)) {
+            ESP_LOGW(TAG, "shtc3 measurement has timed out");
+            return -1;
+        }
+    } else {
+        wait_ms(PROFILES[cycle->profile].measurement_time_ms);
+        // the sensor does not acknowledge reads until the measurement is done
+        int read_attempts = 1;
+        while (measurement_read(cycle, data)) {
+            if (++read_attempts > MAX_READ_ATTEMPTS) {
+                ESP_LOGW(TAG, "shtc3 measurement has timed out");
+                return -1;
+            }
+            wait_ms(READ_RETRY_DELAY_MS);
+        }
+    }
+    if (shtc3_decode(data, temp, humi)) {
+        ESP_LOGW(TAG, "shtc3 measurement CRC check has failed");
+        return -1;
+    }
+    cycle->latency_us = esp_timer_get_time() - started_at_us;
+    return 0;
+}
+
+int shtc3_read_data(sensor_value_t *out_values) {
+    assert(out_values);
+
+    // a profile change takes effect from the next measurement
+    measurement_cycle_t cycle = {
+        .profile = shtc3_get_profile(),
+        .latency_us = -1
+    };
+    sensor_value_t temp, humi;
+    const int result = measure(&cycle, &temp, &humi);
+    finish_measurement(&cycle);
+    if (result) {
+        return -1;
+    }
+
+    out_values[SENSOR_CACHE_SHTC3_TEMPERATURE] = temp;
+    out_values[SENSOR_CACHE_SHTC3_HUMIDITY] = humi;
+    oled_update_temp(temp);
+    oled_update_humi(humi);
+    return 0;
+}
+
+int shtc3_set_profile(shtc3_profile_t profile) {
+    if (profile < 0 || profile >= SHTC3_PROFILE_COUNT) {
         return -1;
     }
+    pthread_mutex_lock(&profiles.mutex);
+    profiles.selected = profile;
+    pthread_mutex_unlock(&profiles.mutex);
     return 0;
 }
 
-int humidity_read_data(void) {
-    return temperature_read_data();
+shtc3_profile_t shtc3_get_profile(void) {
+    pthread_mutex_lock(&profiles.mutex);
+    const shtc3_profile_t profile = profiles.selected;
+    pthread_mutex_unlock(&profiles.mutex);
+    return profile;
 }
 
-int temperature_get_data(double *sensor_data) {
-    oled_update_temp(current_temp);
-    *sensor_data = current_temp;
+int shtc3_get_profile_stats(shtc3_profile_t profile,
+                            double *out_latency_us,
+                            double *out_bus_time_us_per_cycle) {
+    assert(profile >= 0 && profile < SHTC3_PROFILE_COUNT);
+    assert(out_latency_us);
+    assert(out_bus_time_us_per_cycle);
+
+    pthread_mutex_lock(&profiles.mutex);
+    const profile_stats_t stats = profiles.stats[profile];
+    pthread_mutex_unlock(&profiles.mutex);
+
+    if (!stats.measurements) {
+        return -1;
+    }
+    *out_latency_us = (double) stats.latency_us / stats.measurements;
+    *out_bus_time_us_per_cycle = (double) stats.bus_time_us / stats.cycles;
     return 0;
 }
 
-int humidity_get_data(double *sensor_data) {
-    oled_update_humi(current_humi);
-    *sensor_data = current_humi;
+int shtc3_get_last_temp_and_humi(sensor_value_t *temp,
+                                 sensor_value_t *humi) {
+    sensor_value_t values[2];
+    if (sensor_cache_peek(SENSOR_CACHE_DEVICE_SHTC3, 0, AVS_ARRAY_SIZE(values),
+                          values, NULL)) {
+        return -1;
+    }
+    *temp = values[SENSOR_CACHE_SHTC3_TEMPERATURE];
+    *humi = values[SENSOR_CACHE_SHTC3_HUMIDITY];
     return 0;
 }
 
@@ -245,16 +463,16 @@ shtc3_check_crc(uint8_t data[], uint8_t nbrOfBytes, uint8_t checksum) {
     return 0;
 }
 
-static double shtc3_calc_temperature(uint16_t rawValue) {
-    // calculate temperature
-    // T = -45 + 175 * rawValue / 2^16
-    return 175 * (double) rawValue / 65536.0f - 45.0f;
+static sensor_value_t shtc3_calc_temperature(uint16_t rawValue) {
+    // calculate temperature in mCel, rounded to nearest
+    // T = -45 + 175 * rawValue / 2^16 = -45 + 21.875 * rawValue / 2^13
+    return (sensor_value_t) ((21875U * rawValue + (1U << 12)) >> 13) - 45000;
 }
 
-static double shtc3_calc_humidity(uint16_t rawValue) {
-    // calculate relative humidity
-    // RH = rawValue / 2^16 * 100
-    return 100 * (double) rawValue / 65536.0f;
+static sensor_value_t shtc3_calc_humidity(uint16_t rawValue) {
+    // calculate relative humidity in thousandths of %, rounded to nearest
+    // RH = rawValue / 2^16 * 100 = 3.125 * rawValue / 2^11
+    return (sensor_value_t) ((3125U * rawValue + (1U << 10)) >> 11);
 }
 
 #endif // CONFIG_ANJAY_CLIENT_BOARD_PASCO2
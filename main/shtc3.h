@@ -3,15 +3,63 @@
 
 #include <stdint.h>
 
+#include "sensor_value.h"
+
 #if CONFIG_ANJAY_CLIENT_BOARD_PASCO2
 
-int temperature_read_data(void);
-int humidity_read_data(void);
-int temperature_get_data(double *sensor_data);
-int humidity_get_data(double *sensor_data);
+/*
+ * Low power measurements take less than 1 ms instead of about 12 ms, at the
+ * cost of higher noise. With clock stretching the sensor holds SCL low until
+ * the result is ready, so it is read in a single transaction instead of being
+ * polled, but the bus is blocked for the whole measurement.
+ */
+typedef enum {
+    SHTC3_PROFILE_NORMAL_POLLING,
+    SHTC3_PROFILE_NORMAL_CLOCK_STRETCHING,
+    SHTC3_PROFILE_LOW_POWER_POLLING,
+    SHTC3_PROFILE_LOW_POWER_CLOCK_STRETCHING,
+    SHTC3_PROFILE_COUNT
+} shtc3_profile_t;
+
+/**
+ * Wakes the sensor up, takes a measurement with the selected profile and puts
+ * the sensor back to sleep, blocking for the whole cycle (up to about 15 ms in
+ * normal mode). Temperature and humidity are stored at their
+ * SENSOR_CACHE_SHTC3_* indices of @p out_values. This is the on-demand read
+ * of SENSOR_CACHE_DEVICE_SHTC3, so it is called by the sensor acquisition
+ * task only.
+ */
+int shtc3_read_data(sensor_value_t *out_values);
+
+/**
+ * Selects the profile of measurements taken by shtc3_read_data(), starting
+ * with the next one. The default is selected in Kconfig.
+ */
+int shtc3_set_profile(shtc3_profile_t profile);
+shtc3_profile_t shtc3_get_profile(void);
+/**
+ * Average time from starting a measurement to reading its result and average
+ * time spent on I2C transactions per measurement cycle, for measurements
+ * taken with @p profile since boot.
+ */
+int shtc3_get_profile_stats(shtc3_profile_t profile,
+                            double *out_latency_us,
+                            double *out_bus_time_us_per_cycle);
 
-int shtc3_get_temp_and_humi(double *temp, double *humi);
-int shtc3_get_temp_and_humi_polling(double *temp, double *humi);
+/**
+ * Temperature is returned in mCel, humidity in thousandths of %RH.
+ */
+int shtc3_get_temp_and_humi(sensor_value_t *temp, sensor_value_t *humi);
+/**
+ * Blocking measurement, the sensor has to be woken up first. The result is
+ * also cached for shtc3_get_last_temp_and_humi().
+ */
+int shtc3_get_temp_and_humi_polling(sensor_value_t *temp, sensor_value_t *humi);
+/**
+ * Returns the last cached measurement, however old, without measuring;
+ * -1 if there is none yet.
+ */
+int shtc3_get_last_temp_and_humi(sensor_value_t *temp, sensor_value_t *humi);
 int shtc3_wakeup(void);
 int shtc3_sleep(void);
 
@@ -0,0 +1,56 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "sleep_stats.h"
+
+// the original one, and the wrapper the linker substitutes for it
+esp_err_t __real_esp_light_sleep_start(void);
+esp_err_t __wrap_esp_light_sleep_start(void);
+
+static struct {
+    // the idle tasks of both cores may try to enter light sleep
+    portMUX_TYPE lock;
+    int64_t asleep_total_us;
+    uint32_t wakeups;
+} stats_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED
+};
+
+esp_err_t __wrap_esp_light_sleep_start(void) {
+    // esp_timer is compensated for the time spent in light sleep
+    const int64_t start_us = esp_timer_get_time();
+    const esp_err_t result = __real_esp_light_sleep_start();
+    if (!result) {
+        const int64_t asleep_us = esp_timer_get_time() - start_us;
+        portENTER_CRITICAL_SAFE(&stats_state.lock);
+        stats_state.asleep_total_us += asleep_us;
+        stats_state.wakeups++;
+        portEXIT_CRITICAL_SAFE(&stats_state.lock);
+    }
+    return result;
+}
+
+int sleep_stats_get(double *out_awake_ms_per_hour,
+                    double *out_wakeups_per_hour) {
+    assert(out_awake_ms_per_hour);
+    assert(out_wakeups_per_hour);
+
+    const int64_t now_us = esp_timer_get_time();
+    if (now_us <= 0) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&stats_state.lock);
+    const int64_t asleep_us = stats_state.asleep_total_us;
+    const uint32_t wakeups = stats_state.wakeups;
+    portEXIT_CRITICAL(&stats_state.lock);
+
+    const double hours = (double) now_us / (3600.0 * 1000000.0);
+    *out_awake_ms_per_hour = (double) (now_us - asleep_us) / 1000.0 / hours;
+    *out_wakeups_per_hour = (double) wakeups / hours;
+    return 0;
+}
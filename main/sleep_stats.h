@@ -0,0 +1,17 @@
+#ifndef _SLEEP_STATS_H_
+#define _SLEEP_STATS_H_
+
+/*
+ * Light sleep residency of the chip: every automatic light sleep entered by
+ * the power management from the idle task is counted and timed. The linker
+ * routes calls to esp_light_sleep_start() through this module (see
+ * --wrap in CMakeLists.txt), so no ESP-IDF code has to be changed.
+ *
+ * Figures are averaged since boot and normalized to one hour; they are the
+ * current consumption proxies of the single shot CO2 mode. Without light
+ * sleep enabled, the chip is awake all the time and never woken up.
+ */
+int sleep_stats_get(double *out_awake_ms_per_hour,
+                    double *out_wakeups_per_hour);
+
+#endif // _SLEEP_STATS_H_
@@ -0,0 +1,31 @@
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "sdkconfig.h"
+
+#include <avsystem/commons/avs_time.h>
+
+#include "time_sync.h"
+
+static const char *TAG = "time_sync";
+
+static void time_synced(struct timeval *tv) {
+    ESP_LOGI(TAG, "Clock set to %lld", (long long) tv->tv_sec);
+}
+
+void time_sync_start(void) {
+    if (!*CONFIG_ANJAY_CLIENT_SNTP_SERVER) {
+        ESP_LOGW(TAG, "No SNTP server, the clock will not be set");
+        return;
+    }
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, CONFIG_ANJAY_CLIENT_SNTP_SERVER);
+    sntp_set_time_sync_notification_cb(time_synced);
+    sntp_init();
+}
+
+bool time_sync_is_valid(void) {
+    return avs_time_real_now().since_real_epoch.seconds
+           >= TIME_SYNC_MIN_VALID_TIME;
+}
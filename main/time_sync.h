@@ -0,0 +1,30 @@
+#ifndef _TIME_SYNC_H_
+#define _TIME_SYNC_H_
+
+#include <stdbool.h>
+
+/*
+ * Wall clock of the device. It restarts from the Unix epoch at every power
+ * up and is set over SNTP, from CONFIG_ANJAY_CLIENT_SNTP_SERVER, once the
+ * network is up; without an SNTP server (e.g. over the BG96 module) it is
+ * never set.
+ *
+ * Anything stored or sent with a timestamp has to check
+ * time_sync_is_valid() first, as timestamps taken before the clock is set
+ * neither increase across reboots nor mean anything to the server.
+ */
+/*
+ * Clocks that were never set count from the Unix epoch, so they are far
+ * from reaching this; set ones are past it, as the firmware is younger.
+ */
+#define TIME_SYNC_MIN_VALID_TIME 1640995200 // 2022-01-01T00:00:00Z
+
+void time_sync_start(void);
+
+/**
+ * Returns true if the wall clock has been set, since boot or before a warm
+ * reset, which keeps the RTC running.
+ */
+bool time_sync_is_valid(void);
+
+#endif // _TIME_SYNC_H_
@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include <anjay/anjay.h>
+#include <anjay/lwm2m_send.h>
+#include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_sched.h>
+#include <avsystem/commons/avs_time.h>
+
+#include "sdkconfig.h"
+
+#include "main.h"
+#include "uplink_batch.h"
+
+#if CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE > 0
+
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    anjay_rid_t rid;
+    avs_time_real_t timestamp;
+    double value;
+} uplink_batch_entry_t;
+
+static struct {
+    anjay_t *anjay;
+    pthread_mutex_t mutex;
+    avs_sched_handle_t send_job_handle;
+    uplink_batch_entry_t entries[CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE];
+    size_t head;
+    size_t count;
+} batch_state = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void send_job(avs_sched_t *sched, const void *args);
+
+static void schedule_send_unlocked(avs_time_duration_t delay) {
+    avs_sched_del(&batch_state.send_job_handle);
+    AVS_SCHED_DELAYED(anjay_get_scheduler(batch_state.anjay),
+                      &batch_state.send_job_handle, delay, send_job, NULL, 0);
+}
+
+static void send_job(avs_sched_t *sched, const void *args) {
+    (void) sched;
+    (void) args;
+
+    pthread_mutex_lock(&batch_state.mutex);
+    const size_t count = batch_state.count;
+    if (!count) {
+        pthread_mutex_unlock(&batch_state.mutex);
+        return;
+    }
+
+    anjay_send_batch_builder_t *builder = anjay_send_batch_builder_new();
+    bool failed = !builder;
+    for (size_t i = 0; i < count && !failed; i++) {
+        const uplink_batch_entry_t *entry =
+                &batch_state.entries[(batch_state.head + i)
+                                     % CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE];
+        failed = anjay_send_batch_add_double(builder, entry->oid, entry->iid,
+                                             entry->rid, ANJAY_ID_INVALID,
+                                             entry->timestamp, entry->value);
+    }
+    pthread_mutex_unlock(&batch_state.mutex);
+
+    anjay_send_batch_t *batch =
+            failed ? NULL : anjay_send_batch_builder_compile(&builder);
+    anjay_send_batch_builder_cleanup(&builder);
+    failed = !batch
+             || anjay_send(batch_state.anjay, MAIN_SERVER_SSID, batch, NULL,
+                           NULL)
+                        != ANJAY_SEND_OK;
+    anjay_send_batch_release(&batch);
+
+    pthread_mutex_lock(&batch_state.mutex);
+    if (failed) {
+        avs_log(uplink_batch, WARNING, "Sending %u buffered values failed",
+                (unsigned) count);
+    } else {
+        // values added in the meantime stay in the buffer
+        batch_state.head = (batch_state.head + count)
+                           % CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE;
+        batch_state.count -= count;
+    }
+    if (batch_state.count) {
+        schedule_send_unlocked(avs_time_duration_from_scalar(
+                CONFIG_ANJAY_CLIENT_UPLINK_BATCH_MAX_LATENCY, AVS_TIME_S));
+    }
+    pthread_mutex_unlock(&batch_state.mutex);
+}
+
+int uplink_batch_init(anjay_t *anjay) {
+    assert(anjay);
+    pthread_mutex_lock(&batch_state.mutex);
+    batch_state.anjay = anjay;
+    batch_state.head = 0;
+    batch_state.count = 0;
+    pthread_mutex_unlock(&batch_state.mutex);
+    return 0;
+}
+
+void uplink_batch_add(anjay_oid_t oid,
+                      anjay_iid_t iid,
+                      anjay_rid_t rid,
+                      avs_time_real_t timestamp,
+                      double value) {
+    pthread_mutex_lock(&batch_state.mutex);
+    if (!batch_state.anjay) {
+        pthread_mutex_unlock(&batch_state.mutex);
+        return;
+    }
+
+    size_t index = (batch_state.head + batch_state.count)
+                   % CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE;
+    if (batch_state.count == CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE) {
+        // buffer overflow, drop the oldest value
+        batch_state.head = (batch_state.head + 1)
+                           % CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE;
+    } else {
+        batch_state.count++;
+    }
+    batch_state.entries[index] = (uplink_batch_entry_t) {
+        .oid = oid,
+        .iid = iid,
+        .rid = rid,
+        .timestamp = timestamp,
+        .value = value
+    };
+
+    if (batch_state.count == CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE) {
+        schedule_send_unlocked(AVS_TIME_DURATION_ZERO);
+    } else if (batch_state.count == 1) {
+        schedule_send_unlocked(avs_time_duration_from_scalar(
+                CONFIG_ANJAY_CLIENT_UPLINK_BATCH_MAX_LATENCY, AVS_TIME_S));
+    }
+    pthread_mutex_unlock(&batch_state.mutex);
+}
+
+void uplink_batch_release(void) {
+    pthread_mutex_lock(&batch_state.mutex);
+    if (batch_state.anjay) {
+        avs_sched_del(&batch_state.send_job_handle);
+        batch_state.anjay = NULL;
+    }
+    pthread_mutex_unlock(&batch_state.mutex);
+}
+
+#else // CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE > 0
+
+int uplink_batch_init(anjay_t *anjay) {
+    (void) anjay;
+    return 0;
+}
+
+void uplink_batch_add(anjay_oid_t oid,
+                      anjay_iid_t iid,
+                      anjay_rid_t rid,
+                      avs_time_real_t timestamp,
+                      double value) {
+    (void) oid;
+    (void) iid;
+    (void) rid;
+    (void) timestamp;
+    (void) value;
+}
+
+void uplink_batch_release(void) {}
+
+#endif // CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE > 0
@@ -0,0 +1,24 @@
+#ifndef _UPLINK_BATCH_H_
+#define _UPLINK_BATCH_H_
+
+#include <anjay/anjay.h>
+
+/*
+ * Buffers timestamped resource values and reports them to the LwM2M Server
+ * in a single Send message, once CONFIG_ANJAY_CLIENT_UPLINK_BATCH_SIZE values
+ * are collected or the oldest buffered value is
+ * CONFIG_ANJAY_CLIENT_UPLINK_BATCH_MAX_LATENCY seconds old, whichever comes
+ * first. If the Send fails, values are kept and the oldest ones are dropped
+ * when the buffer overflows.
+ *
+ * uplink_batch_add() may be called from any task.
+ */
+int uplink_batch_init(anjay_t *anjay);
+void uplink_batch_add(anjay_oid_t oid,
+                      anjay_iid_t iid,
+                      anjay_rid_t rid,
+                      avs_time_real_t timestamp,
+                      double value);
+void uplink_batch_release(void);
+
+#endif // _UPLINK_BATCH_H_
@@ -0,0 +1,325 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "vibration_monitor.h"
+
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+#    include <pthread.h>
+
+#    include "driver/gpio.h"
+#    include "esp_err.h"
+#    include "esp_log.h"
+#    include "freertos/FreeRTOS.h"
+#    include "freertos/task.h"
+
+#    include "objects/mpu6886.h"
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+
+// Hann window in Q15
+static int16_t hann[VIBRATION_WINDOW_SIZE];
+static bool hann_initialized;
+
+// FFT buffers, too big for the stack of the acquisition task
+static int16_t fft_re[VIBRATION_WINDOW_SIZE];
+static int16_t fft_im[VIBRATION_WINDOW_SIZE];
+
+static void init_hann(void) {
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        hann[i] = (int16_t) lrintf(
+                32767.0f * 0.5f
+                * (1.0f
+                   - cosf(2.0f * (float) M_PI * i
+                          / (VIBRATION_WINDOW_SIZE - 1))));
+    }
+    hann_initialized = true;
+}
+
+static uint16_t dominant_frequency_bin(const int16_t *samples,
+                                       int32_t mean,
+                                       int32_t peak) {
+    if (!hann_initialized) {
+        init_hann();
+    }
+    // scale the signal to use the whole input range of the FFT
+    int left = 0;
+    int right = 0;
+    while ((peak >> right) > FIXED_FFT_MAX_INPUT) {
+        right++;
+    }
+    while (!right && (peak << (left + 1)) <= FIXED_FFT_MAX_INPUT) {
+        left++;
+    }
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        const int32_t value = (samples[i] - mean) * (1 << left) >> right;
+        fft_re[i] = (int16_t) ((value * hann[i]) >> 15);
+        fft_im[i] = 0;
+    }
+    fixed_fft(fft_re, fft_im);
+
+    // DC is skipped, what is left of it after removing the mean is leakage
+    uint16_t best_bin = 1;
+    uint32_t best_power = 0;
+    for (uint16_t bin = 1; bin < VIBRATION_WINDOW_SIZE / 2; bin++) {
+        const uint32_t power =
+                (uint32_t) (fft_re[bin] * fft_re[bin])
+                + (uint32_t) (fft_im[bin] * fft_im[bin]);
+        if (power > best_power) {
+            best_power = power;
+            best_bin = bin;
+        }
+    }
+    return best_bin;
+}
+
+// floor of the square root, computed bit by bit
+static uint32_t isqrt(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t) 1 << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t) result;
+}
+
+// value / 2^shift, rounded to nearest
+static sensor_value_t round_shift(uint64_t value, int shift) {
+    return (sensor_value_t) ((value + ((uint64_t) 1 << (shift - 1)))
+                             >> shift);
+}
+
+static sensor_value_t round_div(uint64_t dividend, uint64_t divisor) {
+    return (sensor_value_t) ((dividend + divisor / 2) / divisor);
+}
+
+void vibration_compute_axis_features(const int16_t *samples,
+                                     uint16_t sample_rate_hz,
+                                     uint32_t scale_q16,
+                                     vibration_axis_features_t *out_features) {
+    assert(samples);
+    assert(out_features);
+
+    int32_t sum = 0;
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        sum += samples[i];
+    }
+    const int32_t mean = sum / VIBRATION_WINDOW_SIZE;
+
+    uint64_t sum_of_squares = 0;
+    int32_t peak = 0;
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        const int32_t deviation = samples[i] - mean;
+        sum_of_squares += (uint64_t) ((int64_t) deviation * deviation);
+        if (abs(deviation) > peak) {
+            peak = abs(deviation);
+        }
+    }
+    // in raw units, in Q8; the sum of squares is below 2^40, so it can be
+    // shifted
+    const uint32_t rms_q8 =
+            isqrt((sum_of_squares << 16) / VIBRATION_WINDOW_SIZE);
+
+    out_features->rms = round_shift((uint64_t) rms_q8 * scale_q16, 24);
+    out_features->peak = round_shift((uint64_t) peak * scale_q16, 16);
+    out_features->crest_factor =
+            rms_q8 ? round_div((uint64_t) peak * SENSOR_VALUE_SCALE << 8,
+                               rms_q8)
+                   : 0;
+    out_features->dominant_frequency =
+            peak ? round_div((uint64_t) dominant_frequency_bin(samples, mean,
+                                                               peak)
+                                     * sample_rate_hz * SENSOR_VALUE_SCALE,
+                             VIBRATION_WINDOW_SIZE)
+                 : 0;
+}
+
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+
+// samples in the FIFO that wake up the task; 392 of its 1024 bytes
+#    define FIFO_WATERMARK 28
+/*
+ * The task also wakes up this often, in case the watermark interrupt was
+ * missed; shorter than the time the FIFO takes to fill at the highest rate.
+ */
+#    define FIFO_POLL_PERIOD_MS 100
+#    define TASK_STOP_POLL_PERIOD_MS 10
+
+static const char *TAG = "vibration";
+
+// thousandths of m/s2 per LSB of the accelerometer output, in Q16
+#    define ACCELEROMETER_SCALE_Q16                                  \
+        ((uint32_t) (ACCELEROMETER_RANGE * GRAVITY_CONSTANT         \
+                     * SENSOR_VALUE_SCALE / 32768.0 * 65536.0 + 0.5))
+
+static struct {
+    TaskHandle_t task;
+    volatile bool stop_requested;
+    uint16_t sample_rate_hz;
+    // accessed by the acquisition task only
+    int16_t window[VIBRATION_AXES][VIBRATION_WINDOW_SIZE];
+    uint16_t window_fill;
+
+    pthread_mutex_t mutex; // guards the results below
+    vibration_features_t features;
+    uint32_t windows;
+    uint32_t overflows;
+} monitor = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void IRAM_ATTR fifo_watermark_isr_handler(void *arg) {
+    BaseType_t task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(monitor.task, &task_woken);
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void complete_window(void) {
+    vibration_features_t features;
+    for (int axis = 0; axis < VIBRATION_AXES; axis++) {
+        vibration_compute_axis_features(monitor.window[axis],
+                                        monitor.sample_rate_hz,
+                                        ACCELEROMETER_SCALE_Q16,
+                                        &features.axes[axis]);
+    }
+    pthread_mutex_lock(&monitor.mutex);
+    monitor.features = features;
+    monitor.windows++;
+    pthread_mutex_unlock(&monitor.mutex);
+    monitor.window_fill = 0;
+}
+
+static void drain_fifo(void) {
+    int16_t samples[MPU6886_FIFO_MAX_BURST][3];
+    size_t count;
+    do {
+        bool overflow;
+        if (mpu6886_fifo_read(samples, MPU6886_FIFO_MAX_BURST, &count,
+                              &overflow)) {
+            ESP_LOGW(TAG, "MPU6886 FIFO read has failed");
+            return;
+        }
+        if (overflow) {
+            // the window would not be continuous
+            monitor.window_fill = 0;
+            pthread_mutex_lock(&monitor.mutex);
+            monitor.overflows++;
+            pthread_mutex_unlock(&monitor.mutex);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            for (int axis = 0; axis < VIBRATION_AXES; axis++) {
+                monitor.window[axis][monitor.window_fill] = samples[i][axis];
+            }
+            if (++monitor.window_fill == VIBRATION_WINDOW_SIZE) {
+                complete_window();
+            }
+        }
+    } while (count == MPU6886_FIFO_MAX_BURST);
+}
+
+static void vibration_task(void *arg) {
+    (void) arg;
+    while (!monitor.stop_requested) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FIFO_POLL_PERIOD_MS));
+        if (!monitor.stop_requested) {
+            drain_fifo();
+        }
+    }
+    mpu6886_fifo_stop();
+    monitor.task = NULL;
+    vTaskDelete(NULL);
+}
+
+int vibration_monitor_start(void) {
+    assert(!monitor.task);
+
+    gpio_config_t config = {
+        .pin_bit_mask = BIT64(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_POSEDGE
+    };
+    esp_err_t err = gpio_config(&config);
+    if (!err) {
+        // may have been installed already by another user of GPIO interrupts
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;
+        }
+    }
+    if (err) {
+        return -1;
+    }
+
+    monitor.stop_requested = false;
+    monitor.window_fill = 0;
+    if (mpu6886_fifo_start(CONFIG_ANJAY_CLIENT_VIBRATION_SAMPLE_RATE,
+                           FIFO_WATERMARK, &monitor.sample_rate_hz)) {
+        ESP_LOGW(TAG, "MPU6886 FIFO could not be started");
+        return -1;
+    }
+    if (xTaskCreate(&vibration_task, "vibration_task", 3072, NULL, 5,
+                    &monitor.task)
+            != pdPASS) {
+        mpu6886_fifo_stop();
+        return -1;
+    }
+    if (gpio_isr_handler_add(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN,
+                             fifo_watermark_isr_handler, NULL)) {
+        ESP_LOGW(TAG, "MPU6886 interrupt is not available, polling the FIFO");
+    }
+    return 0;
+}
+
+void vibration_monitor_stop(void) {
+    if (!monitor.task) {
+        return;
+    }
+    gpio_isr_handler_remove(CONFIG_ANJAY_CLIENT_MPU6886_INT_PIN);
+    monitor.stop_requested = true;
+    xTaskNotifyGive(monitor.task);
+    while (monitor.task) {
+        vTaskDelay(pdMS_TO_TICKS(TASK_STOP_POLL_PERIOD_MS));
+    }
+}
+
+int vibration_monitor_get_features(vibration_features_t *out_features,
+                                   uint32_t *out_windows) {
+    assert(out_features);
+    assert(out_windows);
+
+    pthread_mutex_lock(&monitor.mutex);
+    const uint32_t windows = monitor.windows;
+    *out_features = monitor.features;
+    pthread_mutex_unlock(&monitor.mutex);
+
+    if (!windows) {
+        return -1;
+    }
+    *out_windows = windows;
+    return 0;
+}
+
+uint16_t vibration_monitor_get_sample_rate(void) {
+    return monitor.sample_rate_hz;
+}
+
+uint32_t vibration_monitor_get_overflows(void) {
+    pthread_mutex_lock(&monitor.mutex);
+    const uint32_t overflows = monitor.overflows;
+    pthread_mutex_unlock(&monitor.mutex);
+    return overflows;
+}
+
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
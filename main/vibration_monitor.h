@@ -0,0 +1,67 @@
+#ifndef _VIBRATION_MONITOR_H_
+#define _VIBRATION_MONITOR_H_
+
+#include <stdint.h>
+
+#include "fixed_fft.h"
+#include "sdkconfig.h"
+#include "sensor_value.h"
+
+/*
+ * Vibration features of the accelerometer signal, computed over windows of
+ * VIBRATION_WINDOW_SIZE consecutive samples streamed from the MPU6886 FIFO.
+ *
+ * Every axis is analysed separately, with its mean (gravity and offset)
+ * removed. The dominant frequency is the strongest bin of a fixed-point FFT
+ * of the Hann windowed signal, so its resolution is the sample rate divided
+ * by VIBRATION_WINDOW_SIZE.
+ *
+ * Features are computed in integer arithmetic and given as sensor_value_t
+ * thousandths of their unit, like the samples of the IPSO sensors.
+ */
+#define VIBRATION_WINDOW_SIZE FIXED_FFT_SIZE
+#define VIBRATION_AXES 3
+
+typedef struct vibration_axis_features_struct {
+    sensor_value_t rms;  // in m/s2
+    sensor_value_t peak; // in m/s2
+    sensor_value_t crest_factor;
+    sensor_value_t dominant_frequency; // in Hz, 0 if the signal is constant
+} vibration_axis_features_t;
+
+typedef struct vibration_features_struct {
+    vibration_axis_features_t axes[VIBRATION_AXES];
+} vibration_features_t;
+
+/**
+ * Computes features of a window of raw samples of a single axis, taken at
+ * @p sample_rate_hz; @p scale_q16 is the size of a raw unit in thousandths of
+ * m/s2, in Q16.
+ */
+void vibration_compute_axis_features(const int16_t *samples,
+                                     uint16_t sample_rate_hz,
+                                     uint32_t scale_q16,
+                                     vibration_axis_features_t *out_features);
+
+#if CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+/**
+ * Starts streaming samples from the MPU6886 FIFO in a separate task. The
+ * MPU6886 has to be initialized first.
+ */
+int vibration_monitor_start(void);
+void vibration_monitor_stop(void);
+
+/**
+ * Returns features of the last complete window and the number of windows
+ * completed so far, -1 if there are none yet.
+ */
+int vibration_monitor_get_features(vibration_features_t *out_features,
+                                   uint32_t *out_windows);
+uint16_t vibration_monitor_get_sample_rate(void);
+/**
+ * Number of times samples were lost because the FIFO was not read in time.
+ */
+uint32_t vibration_monitor_get_overflows(void);
+#endif // CONFIG_ANJAY_CLIENT_VIBRATION_MONITOR
+
+#endif // _VIBRATION_MONITOR_H_
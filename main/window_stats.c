@@ -0,0 +1,44 @@
+#include <assert.h>
+#include <math.h>
+
+#include "window_stats.h"
+
+void window_stats_reset(window_stats_t *stats) {
+    assert(stats);
+    stats->count = 0;
+    stats->shift = 0;
+    stats->sum = 0;
+    stats->sum_sq = 0;
+}
+
+void window_stats_add(window_stats_t *stats, sensor_value_t value) {
+    assert(stats);
+    if (!stats->count) {
+        stats->shift = value;
+    }
+    const int64_t diff = (int64_t) value - stats->shift;
+    stats->count++;
+    stats->sum += diff;
+    stats->sum_sq += diff * diff;
+}
+
+double window_stats_mean(const window_stats_t *stats) {
+    assert(stats);
+    if (!stats->count) {
+        return NAN;
+    }
+    return SENSOR_VALUE_TO_DOUBLE(stats->shift
+                                  + (double) stats->sum / stats->count);
+}
+
+double window_stats_stddev(const window_stats_t *stats) {
+    assert(stats);
+    if (!stats->count) {
+        return NAN;
+    }
+    const double sum = (double) stats->sum;
+    const double variance =
+            ((double) stats->sum_sq - sum * sum / stats->count) / stats->count;
+    // rounding may make a zero variance slightly negative
+    return SENSOR_VALUE_TO_DOUBLE(sqrt(variance > 0.0 ? variance : 0.0));
+}
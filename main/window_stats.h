@@ -0,0 +1,48 @@
+#ifndef _WINDOW_STATS_H_
+#define _WINDOW_STATS_H_
+
+#include <stdint.h>
+
+#include "sensor_value.h"
+
+/*
+ * Streaming mean and standard deviation of the samples of a window, in
+ * constant time and memory per sample.
+ *
+ * Like Welford's algorithm, it avoids the cancellation of the textbook sum of
+ * squares formula, but by shifting the data instead of updating the mean:
+ * sums are taken of the differences from the first sample of the window, so
+ * they stay small however far the samples are from zero. Samples are
+ * integers, so the sums are exact and adding a sample takes no division or
+ * floating point; those are left to reading the results.
+ *
+ * The sum of squares overflows only after about 9 * 10^6 samples spanning the
+ * whole range of a sensor_value_t of a million, e.g. +-500 deg/s.
+ */
+typedef struct window_stats_struct {
+    uint32_t count;
+    sensor_value_t shift; // first sample of the window
+    int64_t sum;          // of differences from shift
+    int64_t sum_sq;       // of squares of differences from shift
+} window_stats_t;
+
+/**
+ * Starts a new, empty window. A zero-initialized accumulator is empty too.
+ */
+void window_stats_reset(window_stats_t *stats);
+
+void window_stats_add(window_stats_t *stats, sensor_value_t value);
+
+/**
+ * Mean of the samples, in the unit of the samples (not thousandths), NAN if
+ * there are none.
+ */
+double window_stats_mean(const window_stats_t *stats);
+
+/**
+ * Population standard deviation of the samples, in the unit of the samples,
+ * NAN if there are none.
+ */
+double window_stats_stddev(const window_stats_t *stats);
+
+#endif // _WINDOW_STATS_H_
@@ -0,0 +1,80 @@
+#include "change_filter.h"
+#include "test.h"
+
+static void advance_ms(int64_t ms) {
+    test_clock_advance(avs_time_duration_from_scalar(ms, AVS_TIME_MS));
+}
+
+static void test_absolute_deadband(void) {
+    static const change_filter_config_t CONFIG = { .abs_deadband = 10 };
+    change_filter_t filter;
+    change_filter_init(&filter, &CONFIG);
+
+    CHECK(change_filter_update(&filter, 400));
+    CHECK(!change_filter_update(&filter, 400));
+    CHECK(!change_filter_update(&filter, 409));
+    CHECK(!change_filter_update(&filter, 391));
+    CHECK(change_filter_update(&filter, 410));
+    // drift accumulates against the last reported value
+    CHECK(!change_filter_update(&filter, 415));
+    CHECK(change_filter_update(&filter, 420));
+    CHECK(change_filter_update(&filter, 410));
+}
+
+static void test_relative_deadband(void) {
+    static const change_filter_config_t CONFIG = {
+        .abs_deadband = 1,
+        .rel_deadband_permille = 20
+    };
+    change_filter_t filter;
+    change_filter_init(&filter, &CONFIG);
+
+    CHECK(change_filter_update(&filter, -1000000));
+    CHECK(!change_filter_update(&filter, -980001));
+    CHECK(change_filter_update(&filter, -980000));
+    // neither the difference nor the threshold overflows 32 bits
+    CHECK(change_filter_update(&filter, INT32_MAX));
+    CHECK(!change_filter_update(&filter, INT32_MAX - 1000));
+    CHECK(change_filter_update(&filter, INT32_MIN));
+}
+
+static void test_min_interval(void) {
+    static const change_filter_config_t CONFIG = {
+        .abs_deadband = 1,
+        .min_interval = { .seconds = 5 }
+    };
+    change_filter_t filter;
+    change_filter_init(&filter, &CONFIG);
+
+    CHECK(change_filter_update(&filter, 1));
+    advance_ms(4999);
+    CHECK(!change_filter_update(&filter, 2));
+    advance_ms(1);
+    CHECK(change_filter_update(&filter, 2));
+    // a suppressed value is reported once the interval passes
+    CHECK(!change_filter_update(&filter, 3));
+    advance_ms(5000);
+    CHECK(change_filter_update(&filter, 3));
+}
+
+static void test_reset(void) {
+    static const change_filter_config_t CONFIG = {
+        .abs_deadband = 100,
+        .min_interval = { .seconds = 60 }
+    };
+    change_filter_t filter;
+    change_filter_init(&filter, &CONFIG);
+
+    CHECK(change_filter_update(&filter, 0));
+    CHECK(!change_filter_update(&filter, 0));
+    change_filter_reset(&filter);
+    CHECK(change_filter_update(&filter, 0));
+}
+
+int main(void) {
+    test_absolute_deadband();
+    test_relative_deadband();
+    test_min_interval();
+    test_reset();
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "co2_analytics.h"
+#include "test.h"
+
+static void test_first_sample_sets_band(void) {
+    co2_analytics_t analytics;
+    co2_analytics_init(&analytics);
+
+    // e.g. after a reboot in a room that is already poorly ventilated
+    const int changed = co2_analytics_update(&analytics, 1500, 10);
+    CHECK(!(changed & CO2_ANALYTICS_BAND_CHANGED));
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_POOR);
+    CHECK(!(co2_analytics_update(&analytics, 1500, 10)
+            & CO2_ANALYTICS_BAND_CHANGED));
+}
+
+static void test_band_hysteresis(void) {
+    co2_analytics_t analytics;
+    co2_analytics_init(&analytics);
+
+    CHECK(!(co2_analytics_update(&analytics, 700, 10)
+            & CO2_ANALYTICS_BAND_CHANGED));
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_GOOD);
+    CHECK(co2_analytics_update(&analytics, 800, 10)
+          & CO2_ANALYTICS_BAND_CHANGED);
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_FAIR);
+    // back below the threshold, but within the hysteresis margin
+    CHECK(!(co2_analytics_update(&analytics, 760, 10)
+            & CO2_ANALYTICS_BAND_CHANGED));
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_FAIR);
+    CHECK(co2_analytics_update(&analytics, 749, 10)
+          & CO2_ANALYTICS_BAND_CHANGED);
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_GOOD);
+    // up more than one band at once
+    CHECK(co2_analytics_update(&analytics, 2500, 10)
+          & CO2_ANALYTICS_BAND_CHANGED);
+    CHECK(analytics.band == CO2_ANALYTICS_BAND_BAD);
+}
+
+static void test_rising(void) {
+    co2_analytics_t analytics;
+    co2_analytics_init(&analytics);
+
+    int changed = 0;
+    uint16_t value = 500;
+    // 1000 ppm/h, well above the alert rate
+    for (int i = 0; i < 100 && !(changed & CO2_ANALYTICS_RISING_CHANGED);
+         i++) {
+        changed = co2_analytics_update(&analytics, value, 36);
+        value += 10;
+    }
+    CHECK(analytics.rising);
+    for (int i = 0; i < 100 && analytics.rising; i++) {
+        co2_analytics_update(&analytics, value, 36);
+    }
+    CHECK(!analytics.rising);
+}
+
+int main(void) {
+    test_first_sample_sets_band();
+    test_band_hysteresis();
+    test_rising();
+    return 0;
+}
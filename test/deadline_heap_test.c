@@ -0,0 +1,145 @@
+#include <stdbool.h>
+
+#include "deadline_heap.h"
+#include "test.h"
+
+static avs_time_monotonic_t at_ms(int64_t ms) {
+    return avs_time_monotonic_add(avs_time_monotonic_now(),
+                                  avs_time_duration_from_scalar(ms,
+                                                                AVS_TIME_MS));
+}
+
+static bool same_time(avs_time_monotonic_t a, avs_time_monotonic_t b) {
+    return !avs_time_monotonic_before(a, b)
+           && !avs_time_monotonic_before(b, a);
+}
+
+// inserts into the reference, kept sorted by deadline
+static void reference_push(deadline_heap_entry_t *reference,
+                           size_t *size,
+                           uint8_t id,
+                           avs_time_monotonic_t deadline) {
+    size_t index = (*size)++;
+    while (index
+           && avs_time_monotonic_before(deadline,
+                                        reference[index - 1].deadline)) {
+        reference[index] = reference[index - 1];
+        index--;
+    }
+    reference[index] = (deadline_heap_entry_t) {
+        .deadline = deadline,
+        .id = id
+    };
+}
+
+/*
+ * Pops the earliest entry and checks it against the sorted reference: its
+ * deadline must be the first one, and among equal deadlines any entry may
+ * come first, as long as it is one that was pushed. Returns its id.
+ */
+static uint8_t pop_and_check(deadline_heap_t *heap,
+                             deadline_heap_entry_t *reference,
+                             size_t *size) {
+    deadline_heap_entry_t entry;
+    CHECK(!deadline_heap_peek(heap, &entry));
+    deadline_heap_pop(heap);
+    CHECK(heap->size == *size - 1);
+    CHECK(same_time(entry.deadline, reference[0].deadline));
+
+    size_t found = 0;
+    while (found < *size && reference[found].id != entry.id) {
+        found++;
+    }
+    CHECK(found < *size);
+    CHECK(same_time(reference[found].deadline, entry.deadline));
+    for (--*size; found < *size; found++) {
+        reference[found] = reference[found + 1];
+    }
+    return entry.id;
+}
+
+static void test_random(void) {
+    deadline_heap_t heap = { 0 };
+    // ids of the entries in the heap are unique, so that they can be found
+    deadline_heap_entry_t reference[DEADLINE_HEAP_CAPACITY];
+    size_t size = 0;
+    unsigned used_ids = 0;
+
+    srand(2022);
+    for (int step = 0; step < 100000; step++) {
+        const bool push = size < DEADLINE_HEAP_CAPACITY
+                          && (!size || rand() % 2);
+        if (push) {
+            // few distinct deadlines, so that many of them are equal
+            const avs_time_monotonic_t deadline = at_ms(rand() % 16);
+            uint8_t id = 0;
+            while (used_ids & (1u << id)) {
+                id++;
+            }
+            used_ids |= 1u << id;
+            CHECK(!deadline_heap_push(&heap, id, deadline));
+            reference_push(reference, &size, id, deadline);
+        } else {
+            used_ids &= ~(1u << pop_and_check(&heap, reference, &size));
+        }
+        CHECK(heap.size == size);
+    }
+    while (size) {
+        pop_and_check(&heap, reference, &size);
+    }
+}
+
+static void test_full(void) {
+    deadline_heap_t heap = { 0 };
+    for (int i = 0; i < DEADLINE_HEAP_CAPACITY; i++) {
+        CHECK(!deadline_heap_push(&heap, (uint8_t) i,
+                                  at_ms(DEADLINE_HEAP_CAPACITY - i)));
+    }
+    CHECK(deadline_heap_push(&heap, DEADLINE_HEAP_CAPACITY, at_ms(0)) == -1);
+    CHECK(heap.size == DEADLINE_HEAP_CAPACITY);
+
+    // the rejected entry did not replace any of the others
+    for (int i = DEADLINE_HEAP_CAPACITY - 1; i >= 0; i--) {
+        deadline_heap_entry_t entry;
+        CHECK(!deadline_heap_peek(&heap, &entry));
+        CHECK(entry.id == i);
+        deadline_heap_pop(&heap);
+    }
+}
+
+static void test_empty(void) {
+    deadline_heap_t heap = { 0 };
+    deadline_heap_entry_t entry;
+    CHECK(deadline_heap_peek(&heap, &entry) == -1);
+    deadline_heap_pop(&heap);
+    CHECK(!heap.size);
+}
+
+static void test_equal_deadlines(void) {
+    deadline_heap_t heap = { 0 };
+    for (int i = 0; i < DEADLINE_HEAP_CAPACITY; i++) {
+        CHECK(!deadline_heap_push(&heap, (uint8_t) i, at_ms(100)));
+    }
+
+    // every entry is popped exactly once
+    unsigned popped = 0;
+    for (int i = 0; i < DEADLINE_HEAP_CAPACITY; i++) {
+        deadline_heap_entry_t entry;
+        CHECK(!deadline_heap_peek(&heap, &entry));
+        CHECK(same_time(entry.deadline, at_ms(100)));
+        CHECK(entry.id < DEADLINE_HEAP_CAPACITY);
+        CHECK(!(popped & (1u << entry.id)));
+        popped |= 1u << entry.id;
+        deadline_heap_pop(&heap);
+    }
+    CHECK(popped == (1u << DEADLINE_HEAP_CAPACITY) - 1);
+    CHECK(!heap.size);
+}
+
+int main(void) {
+    test_random();
+    test_full();
+    test_empty();
+    test_equal_deadlines();
+    return 0;
+}
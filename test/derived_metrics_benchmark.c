@@ -0,0 +1,146 @@
+#include <math.h>
+
+#include "derived_metrics.h"
+#include "test.h"
+
+/*
+ * Compares the single precision derived metrics with the same formulas in
+ * double precision: the float results have to stay within a small fraction
+ * of the sensor resolution of the double ones, over the whole operating
+ * range. Costs of both are printed; on the host both are done by the FPU, so
+ * they only show the cost of the formulas themselves. On the ESP32, whose FPU
+ * is single precision only, the double ones are emulated in software.
+ */
+#define SAMPLES 2000000
+#define REPEATS 5
+
+// Magnus formula coefficients, over water
+#define MAGNUS_A 6.112 // in hPa
+#define MAGNUS_B 17.62
+#define MAGNUS_C 243.12 // in Cel
+
+#define ABSOLUTE_HUMIDITY_FACTOR 216.7 // in g*K/(m3*hPa)
+#define ZERO_CELSIUS 273.15            // in K
+
+#define MIN_HUMIDITY 0.1 // in %
+
+// largest acceptable differences, well below the 0.1 Cel, 0.1 g/m3
+// resolution the values are meaningful with
+#define MAX_DEW_POINT_ERROR 0.001
+#define MAX_ABSOLUTE_HUMIDITY_ERROR 0.001
+#define MAX_HEAT_INDEX_ERROR 0.001
+
+static double clamp_humidity(double humi) {
+    if (humi < MIN_HUMIDITY) {
+        return MIN_HUMIDITY;
+    }
+    return humi > 100.0 ? 100.0 : humi;
+}
+
+static double dew_point(double temp, double humi) {
+    const double gamma = log(clamp_humidity(humi) / 100.0)
+                         + MAGNUS_B * temp / (MAGNUS_C + temp);
+    return MAGNUS_C * gamma / (MAGNUS_B - gamma);
+}
+
+static double absolute_humidity(double temp, double humi) {
+    const double saturation =
+            MAGNUS_A * exp(MAGNUS_B * temp / (MAGNUS_C + temp));
+    return ABSOLUTE_HUMIDITY_FACTOR * (clamp_humidity(humi) / 100.0)
+           * saturation / (ZERO_CELSIUS + temp);
+}
+
+static double heat_index(double temp, double humi) {
+    const double t = temp * 1.8 + 32.0;
+    const double rh = clamp_humidity(humi);
+
+    double hi = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+    if ((hi + t) / 2.0 >= 80.0) {
+        hi = -42.379 + 2.04901523 * t + 10.14333127 * rh - 0.22475541 * t * rh
+             - 0.00683783 * t * t - 0.05481717 * rh * rh
+             + 0.00122874 * t * t * rh + 0.00085282 * t * rh * rh
+             - 0.00000199 * t * t * rh * rh;
+        if (rh < 13.0 && t >= 80.0 && t <= 112.0) {
+            hi -= (13.0 - rh) / 4.0 * sqrt((17.0 - fabs(t - 95.0)) / 17.0);
+        } else if (rh > 85.0 && t >= 80.0 && t <= 87.0) {
+            hi += (rh - 85.0) / 10.0 * (87.0 - t) / 5.0;
+        }
+    }
+    return (hi - 32.0) / 1.8;
+}
+
+static void check_accuracy(void) {
+    double max_errors[3] = { 0 };
+    // SHTC3 operating range, in steps of its typical accuracy
+    for (double temp = -40.0; temp <= 60.0; temp += 0.2) {
+        for (double humi = 0.0; humi <= 100.0; humi += 1.0) {
+            const double errors[] = {
+                fabs(derived_metrics_dew_point((float) temp, (float) humi)
+                     - dew_point(temp, humi)),
+                fabs(derived_metrics_absolute_humidity((float) temp,
+                                                       (float) humi)
+                     - absolute_humidity(temp, humi)),
+                fabs(derived_metrics_heat_index((float) temp, (float) humi)
+                     - heat_index(temp, humi))
+            };
+            for (int i = 0; i < (int) TEST_ARRAY_SIZE(errors); i++) {
+                max_errors[i] = fmax(max_errors[i], errors[i]);
+            }
+        }
+    }
+    printf("max error of float: dew point %.2g Cel, absolute humidity "
+           "%.2g g/m3, heat index %.2g Cel\n",
+           max_errors[0], max_errors[1], max_errors[2]);
+    CHECK(max_errors[0] < MAX_DEW_POINT_ERROR);
+    CHECK(max_errors[1] < MAX_ABSOLUTE_HUMIDITY_ERROR);
+    CHECK(max_errors[2] < MAX_HEAT_INDEX_ERROR);
+}
+
+static double benchmark_float(void) {
+    int64_t best = INT64_MAX;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        volatile float sink = 0.0f;
+        const int64_t start = test_now_ns();
+        for (int i = 0; i < SAMPLES; i++) {
+            const float temp = (float) (i % 700) * 0.1f - 20.0f;
+            const float humi = (float) (i % 99 + 1);
+            sink += derived_metrics_dew_point(temp, humi)
+                    + derived_metrics_absolute_humidity(temp, humi)
+                    + derived_metrics_heat_index(temp, humi);
+        }
+        const int64_t elapsed = test_now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+        CHECK(sink != 0.0f);
+    }
+    return (double) best / SAMPLES;
+}
+
+static double benchmark_double(void) {
+    int64_t best = INT64_MAX;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        volatile double sink = 0.0;
+        const int64_t start = test_now_ns();
+        for (int i = 0; i < SAMPLES; i++) {
+            const double temp = (double) (i % 700) * 0.1 - 20.0;
+            const double humi = (double) (i % 99 + 1);
+            sink += dew_point(temp, humi) + absolute_humidity(temp, humi)
+                    + heat_index(temp, humi);
+        }
+        const int64_t elapsed = test_now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+        CHECK(sink != 0.0);
+    }
+    return (double) best / SAMPLES;
+}
+
+int main(void) {
+    check_accuracy();
+    printf("all three metrics, ns per sample (best of %d): float %.1f, "
+           "double %.1f\n",
+           REPEATS, benchmark_float(), benchmark_double());
+    return 0;
+}
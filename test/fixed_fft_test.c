@@ -0,0 +1,76 @@
+#include <math.h>
+
+#include "fixed_fft.h"
+#include "test.h"
+
+/*
+ * Compares fixed_fft() against a double precision DFT divided by
+ * FIXED_FFT_SIZE, for a pure tone, random noise and full scale square waves,
+ * which are the worst case for overflow.
+ */
+// rounding of every stage may accumulate up to one LSB each
+#define MAX_ERROR FIXED_FFT_SIZE_LOG2
+
+static int16_t re[FIXED_FFT_SIZE];
+static int16_t im[FIXED_FFT_SIZE];
+
+static int check_against_dft(void) {
+    double in_re[FIXED_FFT_SIZE];
+    double in_im[FIXED_FFT_SIZE];
+    for (int i = 0; i < FIXED_FFT_SIZE; i++) {
+        in_re[i] = re[i];
+        in_im[i] = im[i];
+    }
+    fixed_fft(re, im);
+
+    double max_error = 0;
+    for (int k = 0; k < FIXED_FFT_SIZE; k++) {
+        double sum_re = 0;
+        double sum_im = 0;
+        for (int i = 0; i < FIXED_FFT_SIZE; i++) {
+            const double angle = -2 * M_PI * k * i / FIXED_FFT_SIZE;
+            sum_re += in_re[i] * cos(angle) - in_im[i] * sin(angle);
+            sum_im += in_re[i] * sin(angle) + in_im[i] * cos(angle);
+        }
+        max_error = fmax(max_error,
+                         fabs(sum_re / FIXED_FFT_SIZE - re[k]));
+        max_error = fmax(max_error,
+                         fabs(sum_im / FIXED_FFT_SIZE - im[k]));
+    }
+    CHECK(max_error <= MAX_ERROR);
+    return (int) ceil(max_error);
+}
+
+int main(void) {
+    for (int i = 0; i < FIXED_FFT_SIZE; i++) {
+        re[i] = (int16_t) lrint(FIXED_FFT_MAX_INPUT
+                                * sin(2 * M_PI * 20 * i / FIXED_FFT_SIZE));
+        im[i] = 0;
+    }
+    const int tone_error = check_against_dft();
+    // the tone lands in its bin and its mirror only
+    for (int k = 0; k < FIXED_FFT_SIZE; k++) {
+        if (k != 20 && k != FIXED_FFT_SIZE - 20) {
+            CHECK(abs(re[k]) + abs(im[k]) <= 2 * MAX_ERROR);
+        }
+    }
+    CHECK(abs(im[20]) > FIXED_FFT_MAX_INPUT / 2 - MAX_ERROR);
+
+    for (int i = 0; i < FIXED_FFT_SIZE; i++) {
+        re[i] = (int16_t) (rand() % (2 * FIXED_FFT_MAX_INPUT + 1)
+                           - FIXED_FFT_MAX_INPUT);
+        im[i] = (int16_t) (rand() % (2 * FIXED_FFT_MAX_INPUT + 1)
+                           - FIXED_FFT_MAX_INPUT);
+    }
+    const int noise_error = check_against_dft();
+
+    for (int i = 0; i < FIXED_FFT_SIZE; i++) {
+        re[i] = (i & 8) ? FIXED_FFT_MAX_INPUT : -FIXED_FFT_MAX_INPUT;
+        im[i] = (i & 4) ? FIXED_FFT_MAX_INPUT : -FIXED_FFT_MAX_INPUT;
+    }
+    const int square_error = check_against_dft();
+
+    printf("fixed_fft: max error (LSB) tone %d, noise %d, square %d\n",
+           tone_error, noise_error, square_error);
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include "hampel_filter.h"
+#include "test.h"
+
+/*
+ * Cost of hampel_filter_update() per sample for growing window sizes. The
+ * bound is O(window size): the memmove() calls and the MAD merge walk cover
+ * up to the whole window, so the figures show how much that costs up to
+ * HAMPEL_FILTER_MAX_WINDOW.
+ */
+#define SAMPLES 500000
+#define REPEATS 5
+
+int main(void) {
+    printf("hampel_filter_update, ns per sample (best of %d)\n", REPEATS);
+    for (int window_size = 1; window_size <= HAMPEL_FILTER_MAX_WINDOW;
+         window_size += window_size < 3 ? 2 : 4) {
+        int64_t best = INT64_MAX;
+        for (int repeat = 0; repeat < REPEATS; repeat++) {
+            hampel_filter_t filter;
+            hampel_filter_init(&filter, (uint8_t) window_size, 30, 20);
+            volatile uint32_t sink = 0;
+            const int64_t start = test_now_ns();
+            for (int i = 0; i < SAMPLES; i++) {
+                // CO2-like values with a spike every 50 samples
+                const uint16_t sample =
+                        (uint16_t) (i % 50 ? 400 + (i * 7919) % 30 : 3000);
+                sink += hampel_filter_update(&filter, sample, NULL);
+            }
+            const int64_t elapsed = test_now_ns() - start;
+            if (elapsed < best) {
+                best = elapsed;
+            }
+            CHECK(sink);
+        }
+        printf("window %2d: %5.1f\n", window_size,
+               (double) best / SAMPLES);
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <math.h>
+
+#include "hampel_filter.h"
+#include "test.h"
+
+/*
+ * Compares the streaming filter against a direct computation of median and
+ * MAD by sorting copies of the window, for every window size.
+ */
+#define SAMPLES 20000
+#define THRESHOLD 30
+#define MIN_DEVIATION 20
+#define MAD_SCALE_X1000 1483
+
+static uint16_t history[SAMPLES];
+
+static int compare_doubles(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+static double median(double *values, int count) {
+    qsort(values, count, sizeof(values[0]), compare_doubles);
+    return count % 2 ? values[count / 2]
+                     : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+static void check_window_size(uint8_t window_size) {
+    hampel_filter_t filter;
+    hampel_filter_init(&filter, window_size, THRESHOLD, MIN_DEVIATION);
+
+    for (int i = 0; i < SAMPLES; i++) {
+        const uint16_t sample = rand() % 50 ? 400 + rand() % 30
+                                            : rand() % 5000;
+        history[i] = sample;
+        bool is_outlier;
+        const uint16_t result =
+                hampel_filter_update(&filter, sample, &is_outlier);
+
+        const int count = i + 1 < window_size ? i + 1 : window_size;
+        bool expected_outlier = false;
+        uint16_t expected = sample;
+        if (count >= 3) {
+            double values[HAMPEL_FILTER_MAX_WINDOW];
+            double deviations[HAMPEL_FILTER_MAX_WINDOW];
+            for (int k = 0; k < count; k++) {
+                values[k] = history[i + 1 - count + k];
+            }
+            const double med = median(values, count);
+            for (int k = 0; k < count; k++) {
+                deviations[k] = fabs(values[k] - med);
+            }
+            const double mad = median(deviations, count);
+            // same integer rounding of the limit as the filter
+            const double limit_x2 = (double) ((uint64_t) THRESHOLD
+                                              * MAD_SCALE_X1000
+                                              * (uint64_t) (2 * mad)
+                                              / 10000);
+            const double dev = fabs(sample - med);
+            if (2 * dev > limit_x2 && dev > MIN_DEVIATION) {
+                expected_outlier = true;
+                expected = (uint16_t) med;
+            }
+        }
+        CHECK(is_outlier == expected_outlier);
+        CHECK(result == expected);
+    }
+}
+
+int main(void) {
+    for (uint8_t window_size = 1; window_size <= HAMPEL_FILTER_MAX_WINDOW;
+         window_size++) {
+        check_window_size(window_size);
+    }
+    return 0;
+}
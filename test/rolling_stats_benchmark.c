@@ -0,0 +1,88 @@
+#include "rolling_stats.h"
+#include "test.h"
+
+/*
+ * Cost of rolling_stats_add() while the history grows from empty to past the
+ * longest window, at the shortest sample period. If the cost is constant,
+ * every phase takes about the same time per sample even though the windows
+ * being maintained cover 12, 96 and 288 buckets by the end. Each phase is
+ * measured with random values and with strictly monotonic ones, which keep
+ * the min or max deques at their longest.
+ */
+#define SAMPLES_PER_HOUR (3600 / ROLLING_STATS_MIN_SAMPLE_WEIGHT)
+#define REPEATS 20
+
+static const struct {
+    const char *name;
+    int hours; // of history at the end of the phase
+} PHASES[] = {
+    { "0-1 h", 1 }, { "1-8 h", 8 }, { "8-24 h", 24 }, { "24-48 h", 48 }
+};
+
+typedef enum { PATTERN_RANDOM, PATTERN_RISING, PATTERN_FALLING } pattern_t;
+
+static const char *const PATTERN_NAMES[] = { "random", "rising", "falling" };
+
+#define RANDOM_VALUES 60000
+
+static rolling_stats_t stats;
+// generated up front, so that rand() is not measured
+static uint16_t random_values[RANDOM_VALUES];
+
+static uint16_t pattern_value(pattern_t pattern, int i) {
+    switch (pattern) {
+    case PATTERN_RISING:
+        return (uint16_t) (i % RANDOM_VALUES);
+    case PATTERN_FALLING:
+        return (uint16_t) (RANDOM_VALUES - i % RANDOM_VALUES);
+    default:
+        return random_values[i % RANDOM_VALUES];
+    }
+}
+
+int main(void) {
+    for (int i = 0; i < RANDOM_VALUES; i++) {
+        random_values[i] = (uint16_t) (400 + rand() % 2000);
+    }
+
+    printf("rolling_stats_add, ns per sample (best of %d)\n", REPEATS);
+    printf("%-8s %10s %10s %10s\n", "history", PATTERN_NAMES[0],
+           PATTERN_NAMES[1], PATTERN_NAMES[2]);
+
+    int64_t best[TEST_ARRAY_SIZE(PHASES)][3];
+    for (int pattern = 0; pattern < 3; pattern++) {
+        for (int p = 0; p < (int) TEST_ARRAY_SIZE(PHASES); p++) {
+            best[p][pattern] = INT64_MAX;
+        }
+        for (int repeat = 0; repeat < REPEATS; repeat++) {
+            rolling_stats_init(&stats);
+            int i = 0;
+            for (int p = 0; p < (int) TEST_ARRAY_SIZE(PHASES); p++) {
+                const int end = PHASES[p].hours * SAMPLES_PER_HOUR;
+                const int count = end - i;
+                const int64_t start = test_now_ns();
+                for (; i < end; i++) {
+                    rolling_stats_add(&stats,
+                                      pattern_value((pattern_t) pattern, i),
+                                      ROLLING_STATS_MIN_SAMPLE_WEIGHT);
+                }
+                const int64_t ns_per_sample =
+                        (test_now_ns() - start) * 1000 / count;
+                if (ns_per_sample < best[p][pattern]) {
+                    best[p][pattern] = ns_per_sample;
+                }
+            }
+            CHECK(!rolling_stats_is_empty(&stats));
+        }
+    }
+
+    for (int p = 0; p < (int) TEST_ARRAY_SIZE(PHASES); p++) {
+        printf("%-8s", PHASES[p].name);
+        for (int pattern = 0; pattern < 3; pattern++) {
+            printf(" %6" PRId64 ".%03d", best[p][pattern] / 1000,
+                   (int) (best[p][pattern] % 1000));
+        }
+        printf("\n");
+    }
+    return 0;
+}
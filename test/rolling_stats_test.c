@@ -0,0 +1,172 @@
+#include <math.h>
+#include <string.h>
+
+#include "rolling_stats.h"
+#include "test.h"
+
+/*
+ * Feeds random samples of random weights and compares every window against
+ * a brute force computation over the whole history. Every few hundred
+ * samples, the state goes through a snapshot round trip.
+ */
+#define SAMPLES 40000
+
+static const int WINDOW_BUCKETS[ROLLING_STATS_WINDOW_COUNT] = { 1, 12, 96,
+                                                                288 };
+
+static struct {
+    uint16_t value;
+    long start;
+    long end;
+} history[SAMPLES];
+
+static rolling_stats_t stats;
+static rolling_stats_t loaded;
+static rolling_stats_snapshot_t snapshot;
+
+static uint16_t random_weight(void) {
+    const int r = rand() % 100;
+    if (r < 70) {
+        return 5 + rand() % 60;
+    } else if (r < 95) {
+        // below ROLLING_STATS_MIN_SAMPLE_WEIGHT as well
+        return 1 + rand() % 10;
+    }
+    return 200 + rand() % 1000;
+}
+
+static void check_window(int count, long now, int window) {
+    long start;
+    if (window == ROLLING_STATS_WINDOW_5_MIN) {
+        start = now - ROLLING_STATS_BUCKET_PERIOD;
+    } else {
+        const long bucket_start = now / ROLLING_STATS_BUCKET_PERIOD
+                                  * ROLLING_STATS_BUCKET_PERIOD;
+        start = bucket_start
+                - (long) (WINDOW_BUCKETS[window] - 1)
+                          * ROLLING_STATS_BUCKET_PERIOD;
+    }
+    if (start < 0) {
+        start = 0;
+    }
+
+    double sum = 0;
+    long weight = 0;
+    int min = INT32_MAX;
+    int max = -1;
+    for (int i = count - 1; i >= 0 && history[i].end > start; i--) {
+        const long from = history[i].start > start ? history[i].start : start;
+        sum += (double) history[i].value * (history[i].end - from);
+        weight += history[i].end - from;
+        if (history[i].value < min) {
+            min = history[i].value;
+        }
+        if (history[i].value > max) {
+            max = history[i].value;
+        }
+    }
+
+    double avg;
+    uint16_t got_min;
+    uint16_t got_max;
+    CHECK(!rolling_stats_get_avg(&stats, window, &avg));
+    CHECK(!rolling_stats_get_min(&stats, window, &got_min));
+    CHECK(!rolling_stats_get_max(&stats, window, &got_max));
+    CHECK(fabs(sum / weight - avg) < 1e-6);
+    CHECK(got_min == min);
+    CHECK(got_max == max);
+}
+
+// a gap drops the raw samples and ages the longer windows by whole buckets
+static void test_skip(void) {
+    rolling_stats_init(&loaded);
+    for (int i = 0; i < 60; i++) {
+        rolling_stats_add(&loaded, 1000, 60);
+    }
+    rolling_stats_skip(&loaded, 1800);
+    CHECK(rolling_stats_is_empty(&loaded));
+
+    rolling_stats_add(&loaded, 2000, 60);
+    double avg;
+    uint16_t min;
+    CHECK(!rolling_stats_get_avg(&loaded, ROLLING_STATS_WINDOW_5_MIN, &avg));
+    CHECK(avg == 2000.0);
+    // 4 of the 11 completed buckets of the hour are from before the gap
+    CHECK(!rolling_stats_get_avg(&loaded, ROLLING_STATS_WINDOW_1_HOUR, &avg));
+    CHECK(fabs(avg - (4.0 * 300 * 1000 + 60 * 2000) / (4 * 300 + 60))
+          < 1e-6);
+    CHECK(!rolling_stats_get_min(&loaded, ROLLING_STATS_WINDOW_1_HOUR, &min));
+    CHECK(min == 1000);
+
+    // nothing is left from before a gap longer than the longest window
+    rolling_stats_skip(&loaded, 25 * 3600);
+    rolling_stats_add(&loaded, 500, 60);
+    CHECK(!rolling_stats_get_avg(&loaded, ROLLING_STATS_WINDOW_24_HOURS,
+                                 &avg));
+    CHECK(avg == 500.0);
+    CHECK(!rolling_stats_get_min(&loaded, ROLLING_STATS_WINDOW_24_HOURS,
+                                 &min));
+    CHECK(min == 500);
+}
+
+int main(void) {
+    rolling_stats_init(&stats);
+    CHECK(rolling_stats_is_empty(&stats));
+
+    long now = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        const uint16_t value = 400 + rand() % 2000;
+        const uint16_t weight = random_weight();
+
+        history[i].value = value;
+        history[i].start = now;
+        now += weight < ROLLING_STATS_MIN_SAMPLE_WEIGHT
+                       ? ROLLING_STATS_MIN_SAMPLE_WEIGHT
+                       : weight;
+        history[i].end = now;
+        rolling_stats_add(&stats, value, weight);
+        CHECK(rolling_stats_get_last(&stats) == value);
+
+        if (i % 997 == 0) {
+            rolling_stats_save(&stats, &snapshot);
+            memset(&loaded, 0x5a, sizeof(loaded));
+            CHECK(!rolling_stats_load(&loaded, &snapshot));
+            stats = loaded;
+        }
+        for (int window = 0; window < ROLLING_STATS_WINDOW_COUNT; window++) {
+            check_window(i + 1, now, window);
+        }
+    }
+
+    // a corrupted snapshot leaves the statistics empty
+    rolling_stats_save(&stats, &snapshot);
+    snapshot.sample_count = ROLLING_STATS_MAX_RAW_SAMPLES + 1;
+    CHECK(rolling_stats_load(&loaded, &snapshot));
+    CHECK(rolling_stats_is_empty(&loaded));
+
+    // so does one with light samples other than the oldest one, which would
+    // not leave room for the next sample
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.sample_count = ROLLING_STATS_MAX_RAW_SAMPLES;
+    for (int i = 0; i < ROLLING_STATS_MAX_RAW_SAMPLES; i++) {
+        snapshot.samples[i] = (rolling_stats_sample_t) {
+            .value = 400,
+            .weight = 1
+        };
+    }
+    CHECK(rolling_stats_load(&loaded, &snapshot));
+    CHECK(rolling_stats_is_empty(&loaded));
+
+    // but the oldest one may be light, as trimmed
+    snapshot.sample_count = 2;
+    snapshot.samples[1].weight = ROLLING_STATS_MIN_SAMPLE_WEIGHT;
+    CHECK(!rolling_stats_load(&loaded, &snapshot));
+    rolling_stats_add(&loaded, 500, ROLLING_STATS_MIN_SAMPLE_WEIGHT);
+    CHECK(rolling_stats_get_last(&loaded) == 500);
+
+    test_skip();
+
+    printf("rolling_stats: %d samples match, sizeof(rolling_stats_t) = %zu\n",
+           SAMPLES, sizeof(rolling_stats_t));
+    return 0;
+}
@@ -0,0 +1,25 @@
+#include "sample_path_benchmark.h"
+#include "test.h"
+
+/*
+ * Host run of the sample path benchmark, timed in nanoseconds. Both variants
+ * use the FPU of the host, so the figures show the cost of the integer path
+ * rather than the gain on the ESP32; the on-target run logs CPU cycles.
+ */
+#define SAMPLES 1000000
+
+static uint32_t clock_ns(void) {
+    return (uint32_t) test_now_ns();
+}
+
+int main(void) {
+    sample_path_benchmark_result_t result;
+    sample_path_benchmark_run(clock_ns, SAMPLES, &result);
+    CHECK(result.fixed_point_ticks && result.double_ticks);
+    printf("sample path, ns per sample (best of %d): fixed point %.1f, "
+           "double %.1f\n",
+           SAMPLE_PATH_BENCHMARK_REPEATS,
+           (double) result.fixed_point_ticks / SAMPLES,
+           (double) result.double_ticks / SAMPLES);
+    return 0;
+}
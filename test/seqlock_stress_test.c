@@ -0,0 +1,72 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "seqlock.h"
+#include "test.h"
+
+/*
+ * A single writer publishes records whose fields all hold the same counter,
+ * as fast as it can, while several readers keep reading them. A record with
+ * differing fields is torn; a counter going backwards means a stale copy.
+ */
+#define WRITES 20000000L
+#define READERS 4
+#define FIELDS 7
+
+typedef struct {
+    int64_t fields[FIELDS];
+} record_t;
+
+static seqlock_t lock;
+static record_t copies[2];
+static atomic_bool done;
+
+static void *reader(void *arg) {
+    int64_t *out_reads = (int64_t *) arg;
+    int64_t last = 0;
+    int64_t reads = 0;
+    while (!atomic_load(&done)) {
+        record_t record;
+        seqlock_read(&lock, copies, &record, sizeof(record));
+        for (int i = 1; i < FIELDS; i++) {
+            CHECK(record.fields[i] == record.fields[0]);
+        }
+        CHECK(record.fields[0] >= last);
+        last = record.fields[0];
+        reads++;
+    }
+    *out_reads = reads;
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const long writes = argc > 1 ? atol(argv[1]) : WRITES;
+    pthread_t threads[READERS];
+    int64_t reads[READERS];
+    for (int i = 0; i < READERS; i++) {
+        CHECK(!pthread_create(&threads[i], NULL, reader, &reads[i]));
+    }
+
+    for (long counter = 1; counter <= writes; counter++) {
+        record_t record;
+        for (int i = 0; i < FIELDS; i++) {
+            record.fields[i] = counter;
+        }
+        seqlock_write(&lock, copies, &record, sizeof(record));
+    }
+    atomic_store(&done, true);
+
+    int64_t total_reads = 0;
+    for (int i = 0; i < READERS; i++) {
+        CHECK(!pthread_join(threads[i], NULL));
+        total_reads += reads[i];
+    }
+    record_t record;
+    seqlock_read(&lock, copies, &record, sizeof(record));
+    CHECK(record.fields[0] == writes);
+
+    printf("seqlock: %ld writes, %" PRId64 " reads by %d readers, none torn\n",
+           writes, total_reads, READERS);
+    return 0;
+}
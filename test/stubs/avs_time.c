@@ -0,0 +1,86 @@
+#include <avsystem/commons/avs_time.h>
+
+#define NS_PER_S 1000000000
+
+const avs_time_monotonic_t AVS_TIME_MONOTONIC_INVALID = {
+    .since_monotonic_epoch = { 0, -1 }
+};
+
+static avs_time_monotonic_t test_clock = {
+    .since_monotonic_epoch = { 1000, 0 }
+};
+
+static int64_t to_ns(avs_time_duration_t t) {
+    return t.seconds * NS_PER_S + t.nanoseconds;
+}
+
+static avs_time_duration_t from_ns(int64_t ns) {
+    avs_time_duration_t t = {
+        .seconds = ns / NS_PER_S,
+        .nanoseconds = (int32_t) (ns % NS_PER_S)
+    };
+    if (t.nanoseconds < 0) {
+        t.seconds--;
+        t.nanoseconds += NS_PER_S;
+    }
+    return t;
+}
+
+bool avs_time_duration_valid(avs_time_duration_t t) {
+    return t.nanoseconds >= 0 && t.nanoseconds < NS_PER_S;
+}
+
+bool avs_time_duration_less(avs_time_duration_t a, avs_time_duration_t b) {
+    return avs_time_duration_valid(a) && avs_time_duration_valid(b)
+           && to_ns(a) < to_ns(b);
+}
+
+avs_time_duration_t avs_time_duration_from_scalar(int64_t value,
+                                                  avs_time_unit_t unit) {
+    static const int64_t NS_PER_UNIT[] = {
+        [AVS_TIME_S] = NS_PER_S,
+        [AVS_TIME_MS] = 1000000,
+        [AVS_TIME_US] = 1000,
+        [AVS_TIME_NS] = 1
+    };
+    return from_ns(value * NS_PER_UNIT[unit]);
+}
+
+bool avs_time_monotonic_valid(avs_time_monotonic_t t) {
+    return avs_time_duration_valid(t.since_monotonic_epoch);
+}
+
+bool avs_time_monotonic_before(avs_time_monotonic_t a,
+                               avs_time_monotonic_t b) {
+    return avs_time_duration_less(a.since_monotonic_epoch,
+                                  b.since_monotonic_epoch);
+}
+
+avs_time_duration_t avs_time_monotonic_diff(avs_time_monotonic_t minuend,
+                                            avs_time_monotonic_t subtrahend) {
+    if (!avs_time_monotonic_valid(minuend)
+            || !avs_time_monotonic_valid(subtrahend)) {
+        return AVS_TIME_MONOTONIC_INVALID.since_monotonic_epoch;
+    }
+    return from_ns(to_ns(minuend.since_monotonic_epoch)
+                   - to_ns(subtrahend.since_monotonic_epoch));
+}
+
+avs_time_monotonic_t avs_time_monotonic_add(avs_time_monotonic_t a,
+                                            avs_time_duration_t b) {
+    if (!avs_time_monotonic_valid(a) || !avs_time_duration_valid(b)) {
+        return AVS_TIME_MONOTONIC_INVALID;
+    }
+    return (avs_time_monotonic_t) {
+        .since_monotonic_epoch =
+                from_ns(to_ns(a.since_monotonic_epoch) + to_ns(b))
+    };
+}
+
+avs_time_monotonic_t avs_time_monotonic_now(void) {
+    return test_clock;
+}
+
+void test_clock_advance(avs_time_duration_t duration) {
+    test_clock = avs_time_monotonic_add(test_clock, duration);
+}
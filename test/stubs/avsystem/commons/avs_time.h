@@ -0,0 +1,46 @@
+#ifndef _AVS_TIME_H_
+#define _AVS_TIME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Host stand-in for the part of avs_commons' avs_time.h used by the tested
+ * modules. Types and signatures follow avs_commons; the monotonic clock is
+ * driven by the test with test_clock_advance().
+ */
+typedef struct {
+    int64_t seconds;
+    int32_t nanoseconds;
+} avs_time_duration_t;
+
+typedef struct {
+    avs_time_duration_t since_monotonic_epoch;
+} avs_time_monotonic_t;
+
+typedef enum {
+    AVS_TIME_S,
+    AVS_TIME_MS,
+    AVS_TIME_US,
+    AVS_TIME_NS
+} avs_time_unit_t;
+
+extern const avs_time_monotonic_t AVS_TIME_MONOTONIC_INVALID;
+
+bool avs_time_duration_valid(avs_time_duration_t t);
+bool avs_time_duration_less(avs_time_duration_t a, avs_time_duration_t b);
+avs_time_duration_t avs_time_duration_from_scalar(int64_t value,
+                                                  avs_time_unit_t unit);
+
+bool avs_time_monotonic_valid(avs_time_monotonic_t t);
+bool avs_time_monotonic_before(avs_time_monotonic_t a,
+                               avs_time_monotonic_t b);
+avs_time_duration_t avs_time_monotonic_diff(avs_time_monotonic_t minuend,
+                                            avs_time_monotonic_t subtrahend);
+avs_time_monotonic_t avs_time_monotonic_add(avs_time_monotonic_t a,
+                                            avs_time_duration_t b);
+avs_time_monotonic_t avs_time_monotonic_now(void);
+
+void test_clock_advance(avs_time_duration_t duration);
+
+#endif // _AVS_TIME_H_
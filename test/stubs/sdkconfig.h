@@ -0,0 +1,14 @@
+#ifndef _SDKCONFIG_H_
+#define _SDKCONFIG_H_
+
+/*
+ * Host stand-in for the configuration generated by ESP-IDF, with Kconfig
+ * defaults of the options used by the tested modules.
+ */
+#define CONFIG_ANJAY_CLIENT_AIR_QUALITY_SENSOR 1
+#define CONFIG_ANJAY_CLIENT_CO2_RISE_ALERT_RATE 300
+#define CONFIG_ANJAY_CLIENT_CO2_ROOM_VOLUME 30
+#define CONFIG_ANJAY_CLIENT_CO2_AIR_CHANGES 5
+#define CONFIG_ANJAY_CLIENT_CO2_OUTDOOR_LEVEL 420
+
+#endif // _SDKCONFIG_H_
@@ -0,0 +1,31 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Minimal helpers shared by the host tests: a failed check prints its
+ * location and terminates the test with a non-zero exit code.
+ */
+#define CHECK(Cond)                                                   \
+    do {                                                              \
+        if (!(Cond)) {                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,    \
+                    __LINE__, #Cond);                                 \
+            exit(EXIT_FAILURE);                                       \
+        }                                                             \
+    } while (0)
+
+#define TEST_ARRAY_SIZE(Array) (sizeof(Array) / sizeof(*(Array)))
+
+static inline int64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif // _TEST_H_
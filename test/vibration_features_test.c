@@ -0,0 +1,85 @@
+#include <math.h>
+
+#include "test.h"
+#include "vibration_monitor.h"
+
+/*
+ * Checks the integer vibration features against the same formulas in double
+ * precision, for sine waves of various amplitudes and frequencies with an
+ * offset and some noise, as seen by the accelerometer.
+ */
+#define SAMPLE_RATE_HZ 500
+// the MPU6886 scale at +-2 g, thousandths of m/s2 per LSB in Q16
+#define SCALE_Q16 39227
+#define SCALE ((double) SCALE_Q16 / 65536.0)
+
+// in thousandths of the unit
+#define MAX_RMS_ERROR 1
+#define MAX_PEAK_ERROR 1
+#define MAX_CREST_FACTOR_ERROR 2
+
+static void check_window(double amplitude, double frequency_hz) {
+    int16_t samples[VIBRATION_WINDOW_SIZE];
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        const double noise = (double) (rand() % 21 - 10);
+        samples[i] = (int16_t) lrint(
+                8192.0 + noise
+                + amplitude
+                          * sin(2.0 * M_PI * frequency_hz * i
+                                / SAMPLE_RATE_HZ));
+    }
+
+    vibration_axis_features_t features;
+    vibration_compute_axis_features(samples, SAMPLE_RATE_HZ, SCALE_Q16,
+                                    &features);
+
+    int32_t sum = 0;
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        sum += samples[i];
+    }
+    const int32_t mean = sum / VIBRATION_WINDOW_SIZE;
+    double sum_of_squares = 0.0;
+    double peak = 0.0;
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        const double deviation = samples[i] - mean;
+        sum_of_squares += deviation * deviation;
+        peak = fmax(peak, fabs(deviation));
+    }
+    const double rms = sqrt(sum_of_squares / VIBRATION_WINDOW_SIZE);
+
+    CHECK(labs(features.rms - lround(rms * SCALE)) <= MAX_RMS_ERROR);
+    CHECK(labs(features.peak - lround(peak * SCALE)) <= MAX_PEAK_ERROR);
+    CHECK(labs(features.crest_factor
+               - lround(peak / rms * SENSOR_VALUE_SCALE))
+          <= MAX_CREST_FACTOR_ERROR);
+    // within the resolution of the FFT
+    const double resolution_hz =
+            (double) SAMPLE_RATE_HZ / VIBRATION_WINDOW_SIZE;
+    CHECK(fabs(SENSOR_VALUE_TO_DOUBLE(features.dominant_frequency)
+               - frequency_hz)
+          <= resolution_hz);
+}
+
+int main(void) {
+    static const double AMPLITUDES[] = { 50.0, 500.0, 5000.0, 20000.0 };
+    static const double FREQUENCIES_HZ[] = { 5.0, 17.3, 50.0, 123.4, 240.0 };
+    for (int i = 0; i < (int) TEST_ARRAY_SIZE(AMPLITUDES); i++) {
+        for (int j = 0; j < (int) TEST_ARRAY_SIZE(FREQUENCIES_HZ); j++) {
+            check_window(AMPLITUDES[i], FREQUENCIES_HZ[j]);
+        }
+    }
+
+    // a constant signal has no vibration at all
+    int16_t samples[VIBRATION_WINDOW_SIZE];
+    for (int i = 0; i < VIBRATION_WINDOW_SIZE; i++) {
+        samples[i] = 8192;
+    }
+    vibration_axis_features_t features;
+    vibration_compute_axis_features(samples, SAMPLE_RATE_HZ, SCALE_Q16,
+                                    &features);
+    CHECK(!features.rms);
+    CHECK(!features.peak);
+    CHECK(!features.crest_factor);
+    CHECK(!features.dominant_frequency);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <math.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "window_stats.h"
+
+// Welford's algorithm in double precision, on the same values in units
+typedef struct {
+    uint32_t count;
+    double mean;
+    double m2;
+} welford_t;
+
+static void welford_add(welford_t *welford, sensor_value_t value) {
+    const double x = SENSOR_VALUE_TO_DOUBLE(value);
+    const double delta = x - welford->mean;
+    welford->count++;
+    welford->mean += delta / welford->count;
+    welford->m2 += delta * (x - welford->mean);
+}
+
+static bool close_to(double actual, double expected) {
+    return fabs(actual - expected) <= 1e-9 * (1.0 + fabs(expected));
+}
+
+static void check_against_welford(sensor_value_t base, sensor_value_t spread) {
+    window_stats_t stats;
+    window_stats_reset(&stats);
+    welford_t welford = { 0 };
+
+    for (int i = 0; i < 10000; i++) {
+        const sensor_value_t value = base + rand() % (2 * spread + 1) - spread;
+        window_stats_add(&stats, value);
+        welford_add(&welford, value);
+    }
+    CHECK(stats.count == welford.count);
+    CHECK(close_to(window_stats_mean(&stats), welford.mean));
+    CHECK(close_to(window_stats_stddev(&stats),
+                   sqrt(welford.m2 / welford.count)));
+}
+
+static void test_welford(void) {
+    srand(2022);
+    check_against_welford(0, 1000);
+    check_against_welford(0, 500000);
+    // far from zero with a small spread, where sums of squares cancel out
+    check_against_welford(500000, 10);
+    check_against_welford(-500000, 10);
+    check_against_welford(499990, 10);
+}
+
+static void test_constant(void) {
+    static const sensor_value_t VALUES[] = { 0, 1, -1, 21500, 500000,
+                                             -500000 };
+    for (size_t i = 0; i < TEST_ARRAY_SIZE(VALUES); i++) {
+        window_stats_t stats;
+        window_stats_reset(&stats);
+        for (int j = 0; j < 1000; j++) {
+            window_stats_add(&stats, VALUES[i]);
+        }
+        CHECK(window_stats_mean(&stats) == SENSOR_VALUE_TO_DOUBLE(VALUES[i]));
+        CHECK(window_stats_stddev(&stats) == 0.0);
+    }
+}
+
+static void test_extremes(void) {
+    window_stats_t stats;
+    window_stats_reset(&stats);
+    // alternating between both ends of the range of the gyroscope
+    for (int i = 0; i < 1000; i++) {
+        window_stats_add(&stats, i % 2 ? 500000 : -500000);
+    }
+    CHECK(window_stats_mean(&stats) == 0.0);
+    CHECK(window_stats_stddev(&stats) == 500.0);
+}
+
+static void test_empty(void) {
+    window_stats_t stats = { 0 };
+    CHECK(isnan(window_stats_mean(&stats)));
+    CHECK(isnan(window_stats_stddev(&stats)));
+
+    window_stats_add(&stats, 1000);
+    CHECK(window_stats_mean(&stats) == 1.0);
+    CHECK(window_stats_stddev(&stats) == 0.0);
+
+    // a new window forgets the previous one
+    window_stats_reset(&stats);
+    CHECK(isnan(window_stats_mean(&stats)));
+    CHECK(isnan(window_stats_stddev(&stats)));
+}
+
+int main(void) {
+    test_welford();
+    test_constant();
+    test_extremes();
+    test_empty();
+    return 0;
+}